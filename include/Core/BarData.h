@@ -0,0 +1,46 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_CORE_BARDATA_H_
+#define FT_INCLUDE_CORE_BARDATA_H_
+
+#include <cstdint>
+
+namespace ft {
+
+enum BarType : uint32_t {
+  BAR_TIME = 1,  // 按交易所时间（北京时间）对齐的固定周期
+  BAR_VOLUME,    // 成交量达到interval时结束
+  BAR_TICK       // 行情条数达到interval时结束
+};
+
+/*
+ * 引擎由行情合成的bar，跟随行情的传输方式发布
+ * 进行中的bar会定期发布（is_closed为0），结束时再发布一次（is_closed为1）
+ */
+struct BarData {
+  uint64_t ticker_index;
+  uint32_t type;       // BarType
+  uint32_t is_closed;  // 0: 进行中，1: 已结束
+  uint64_t interval;   // 时间bar为秒数，成交量bar为成交量，tick bar为行情条数
+  uint64_t date;       // 交易日，夜盘属于下一个交易日
+
+  // UTC纪元以来的纳秒数。时间bar为周期的起止时间，其他bar为第一条和最后
+  // 一条行情的交易所时间
+  uint64_t start_time;
+  uint64_t end_time;
+
+  double open = 0;
+  double high = 0;
+  double low = 0;
+  double close = 0;
+  uint64_t volume = 0;
+  uint64_t turnover = 0;
+  uint64_t open_interest = 0;
+  uint64_t num_ticks = 0;
+
+  uint64_t engine_time = 0;  // 引擎发布这个bar的时间（now_ns）
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_CORE_BARDATA_H_
@@ -152,6 +152,42 @@ inline const std::string& ordertype_str(uint64_t t) {
   return t_str.find(t)->second;
 }
 
+/*
+ * 订单状态
+ * CREATED -> SUBMITTING -> NO_TRADED -> PART_TRADED -> ALL_TRADED/CANCELED
+ * 交易所拒单时进入REJECTED，ALL_TRADED、CANCELED、REJECTED是终止状态
+ * 撤单被拒不改变订单状态，CANCEL_REJECTED只出现在订单回报中
+ */
+enum class OrderStatus : uint32_t {
+  CREATED = 0,
+  SUBMITTING,
+  REJECTED,
+  NO_TRADED,
+  PART_TRADED,
+  ALL_TRADED,
+  CANCELED,
+  CANCEL_REJECTED
+};
+
+inline const std::string& to_string(OrderStatus s) {
+  static const std::map<OrderStatus, std::string> s_str = {
+      {OrderStatus::CREATED, "Created"},
+      {OrderStatus::SUBMITTING, "Submitting"},
+      {OrderStatus::REJECTED, "Rejected"},
+      {OrderStatus::NO_TRADED, "No traded"},
+      {OrderStatus::PART_TRADED, "Part traded"},
+      {OrderStatus::ALL_TRADED, "All traded"},
+      {OrderStatus::CANCELED, "Canceled"},
+      {OrderStatus::CANCEL_REJECTED, "Cancel rejected"}};
+
+  return s_str.find(s)->second;
+}
+
+inline bool is_final_status(OrderStatus s) {
+  return s == OrderStatus::ALL_TRADED || s == OrderStatus::CANCELED ||
+         s == OrderStatus::REJECTED;
+}
+
 /*
  * symbol和exchange转为ft支持的ticker类型
  * ticker = symbol.exchange
@@ -110,6 +110,11 @@ class ContractTable {
     return &contracts[ticker_index - 1];
   }
 
+  /*
+   * 合约的index范围为[1, size()]
+   */
+  static std::size_t size() { return contracts.size(); }
+
  private:
   inline static std::vector<Contract> contracts;
   inline static std::map<std::string, Contract*> ticker2contract;
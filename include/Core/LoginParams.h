@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "Utils/ThreadAffinity.h"
+
 namespace ft {
 
 class LoginParams {
@@ -54,6 +56,31 @@ class LoginParams {
 
   const auto& subscribed_list() const { return subscribed_list_; }
 
+  /*
+   * 同一个引擎登录多个账户时，这些交易所的订单发往这个账户，为空表示作为
+   * 没有指定账户的交易所的默认账户
+   */
+  void set_exchanges(const std::vector<std::string>& exchanges) {
+    exchanges_ = exchanges;
+  }
+
+  const auto& exchanges() const { return exchanges_; }
+
+  /*
+   * 柜台API的行情和交易回调线程的位置，网关在回调线程中自己设置
+   */
+  void set_md_thread(const ThreadPlacement& placement) {
+    md_thread_ = placement;
+  }
+
+  const ThreadPlacement& md_thread() const { return md_thread_; }
+
+  void set_trade_thread(const ThreadPlacement& placement) {
+    trade_thread_ = placement;
+  }
+
+  const ThreadPlacement& trade_thread() const { return trade_thread_; }
+
  private:
   std::string api_;
   std::string front_addr_;
@@ -65,6 +92,10 @@ class LoginParams {
   std::string app_id_;
 
   std::vector<std::string> subscribed_list_;
+  std::vector<std::string> exchanges_;
+
+  ThreadPlacement md_thread_;
+  ThreadPlacement trade_thread_;
 };
 
 }  // namespace ft
@@ -5,9 +5,23 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <map>
 #include <string>
 
+#include "Core/BarData.h"
+#include "Core/Constants.h"
+#include "Core/Position.h"
+#include "Core/TickData.h"
+#include "IPC/broadcast_ring.h"
+#include "IPC/mpsc_queue.h"
+#include "IPC/notifier.h"
+#include "IPC/seqlock.h"
+#include "IPC/spsc_ring.h"
+
 namespace ft {
 
 /*
@@ -35,6 +49,7 @@ inline const uint32_t TRADER_CMD_MAGIC = 0x1709394;
 enum TraderCmdType { NEW_ORDER = 1, CANCEL_ORDER, CANCEL_TICKER, CANCEL_ALL };
 
 struct TraderOrderReq {
+  uint64_t client_order_id;  // 由策略指定，订单回报中原样带回
   uint64_t ticker_index;
   uint64_t direction;
   uint64_t offset;
@@ -55,6 +70,10 @@ struct TraderCommand {
   uint32_t magic;
   uint32_t type;
   uint32_t strategy_id;
+  uint32_t batch_size;  // 所在批次的指令数，单条发送时为1
+  // 以下时间戳用于统计延迟（now_ns）
+  uint64_t send_time;     // 策略发出指令的时间
+  uint64_t trigger_time;  // 触发该指令的行情被网关收到的时间，没有则为0
   union {
     TraderOrderReq order_req;
     TraderCancelReq cancel_req;
@@ -64,14 +83,205 @@ struct TraderCommand {
 
 constexpr const char* const TRADER_CMD_TOPIC = "trader_cmd";
 
+/*
+ * 一个批次最多包含的指令数
+ * 同一批次的指令在一次IPC中发送，引擎在同一把锁下连续处理，并且先对批次中
+ * 所有的新订单做风控检查，任意一个不通过则整批都不执行
+ * redis: 一条消息中连续存放batch_size个TraderCommand
+ * shm: batch_size个TraderCommand一次性写入队列
+ */
+inline const uint32_t kMaxCmdBatchSize = 32;
+
+// 同时运行的策略进程数上限，strategy_id的范围为[0, kMaxStrategies)
+inline const uint32_t kMaxStrategies = 64;
+
 inline std::string proto_md_topic(const std::string& ticker) {
   return fmt::format("md-{}", ticker);
 }
 
+/*
+ * 引擎合成的bar和行情使用同一个redis连接发布，策略通过channel区分
+ */
+inline std::string proto_bar_topic(const std::string& ticker) {
+  return fmt::format("bar-{}", ticker);
+}
+
+inline bool is_bar_topic(const char* channel) {
+  return strncmp(channel, "bar-", 4) == 0;
+}
+
+/*
+ * TradingEngine和Strategy之间的传输方式，行情、交易指令和仓位可以分别指定
+ * REDIS: 通过redis的publish/subscribe以及get/set
+ * SHM: 共享内存中的无锁数据结构
+ *   行情：所有ticker共用一个广播队列，引擎写入一次，每个策略按自己的进度读取
+ *   交易指令：每个策略（strategy_id）一个环形队列，策略写入，引擎轮询
+ *   仓位：以ticker_index为下标的仓位表，引擎写入，策略无锁读取
+ *   订单回报：跟随行情的传输方式，每个策略一个环形队列，引擎写入，策略轮询
+ */
+enum class IpcTransport { REDIS = 0, SHM };
+
+inline IpcTransport string2transport(const std::string& name) {
+  static const std::map<std::string, IpcTransport> transport_map = {
+      {"redis", IpcTransport::REDIS}, {"shm", IpcTransport::SHM}};
+
+  auto iter = transport_map.find(name);
+  if (iter == transport_map.end()) return IpcTransport::REDIS;
+  return iter->second;
+}
+
+// 每个策略独占其中的一个队列，以strategy_id区分
+using TraderCmdQueue = MpscQueue<TraderCommand, kMaxStrategies, 256>;
+
+constexpr const char* const TRADER_CMD_SHM_NAME = "/ft-trader-cmd";
+
+// 引擎睡眠时，策略写入交易指令后通过这个命名管道唤醒引擎
+constexpr const char* const TRADER_CMD_DOORBELL_PATH =
+    "/dev/shm/ft-trader-cmd.fifo";
+
+// 策略运行期间持有对应strategy_id的文件锁，防止两个策略使用同一个id
+inline std::string proto_strategy_lock_path(uint32_t strategy_id) {
+  return fmt::format("/dev/shm/ft-strategy-{}.lock", strategy_id);
+}
+
 inline std::string proto_pos_key(const std::string& ticker) {
   return fmt::format("pos-{}", ticker);
 }
 
+// 共享内存仓位表能容纳的ticker_index上限
+inline const uint64_t kMaxTickers = 4096;
+
+/*
+ * 共享内存中的仓位表，由引擎写入，策略读取
+ * 仓位以ticker_index为下标，每个仓位由各自的顺序锁保护
+ */
+struct PositionTable {
+  SeqLocked<double> realized_pnl;
+  SeqLocked<double> float_pnl;
+  SeqLocked<Position> positions[kMaxTickers];
+};
+
+constexpr const char* const POSITION_SHM_NAME = "/ft-position";
+
+struct LatestTick {
+  uint64_t seq;  // 这个tick在广播队列中的序号
+  TickData tick;
+};
+
+/*
+ * 共享内存中的行情，由引擎写入，所有策略读取
+ * ring: 所有tick按时间顺序写入的广播队列
+ * latest: 以ticker_index为下标的最新行情快照，落后太多的策略跳过队列中
+ *         积压的数据，直接从这里取每个ticker的最新行情
+ *
+ * bars: 引擎合成的bar，和行情一样按时间顺序写入，每个策略按自己的进度读取
+ *
+ * notifier: 引擎写入行情、bar或者订单回报之后通过它唤醒睡眠中的策略
+ * publish_time: 最近一次写入行情的时间（now_ns），用于统计策略的唤醒延迟
+ *
+ * 引擎先更新latest再写入ring，所以latest[i].seq总是不小于队列中该ticker
+ * 最后一个tick的序号
+ */
+struct MarketDataBroadcast {
+  BroadcastRing<TickData, 4096> ring;
+  SeqLocked<LatestTick> latest[kMaxTickers];
+  BroadcastRing<BarData, 4096> bars;
+  Notifier notifier;
+  std::atomic<uint64_t> publish_time;
+};
+
+constexpr const char* const MD_SHM_NAME = "/ft-md";
+
+/*
+ * TradingEngine发给Strategy的订单回报，按下单时的strategy_id路由回对应的策略
+ * 传输方式和行情一致，策略在接收行情的同一个循环中处理订单回报
+ */
+enum OrderEventType {
+  ORDER_ACCEPTED = 1,
+  ORDER_REJECTED,
+  ORDER_TRADED,
+  ORDER_CANCELED,
+  ORDER_CANCEL_REJECTED
+};
+
+struct OrderEvent {
+  uint32_t type;
+  uint32_t strategy_id;
+  uint64_t order_id;         // 引擎分配的订单号，撤单时使用
+  uint64_t client_order_id;  // 下单时策略指定的订单号
+  uint64_t ticker_index;
+  uint64_t direction;
+  uint64_t offset;
+  int64_t volume;           // 原始委托量
+  int64_t traded_volume;    // 累计成交量
+  int64_t canceled_volume;  // 撤单量
+  int64_t this_traded;      // 本次成交量，只在ORDER_TRADED时有效
+  double this_traded_price;
+  uint64_t gateway_time;  // Gateway收到柜台回报的时间（now_ns）
+  uint64_t engine_time;   // 引擎发出回报的时间（now_ns）
+};
+
+// 每个策略一个环形队列，引擎写入，策略轮询
+using OrderEventRing = SpscRing<OrderEvent, 1024>;
+
+inline std::string proto_order_event_shm_name(uint32_t strategy_id) {
+  return fmt::format("/ft-order-event-{}", strategy_id);
+}
+
+inline std::string proto_order_event_topic(uint32_t strategy_id) {
+  return fmt::format("order_event-{}", strategy_id);
+}
+
+/*
+ * 策略的未结束订单，order_id为0表示空槽位
+ */
+struct OpenOrder {
+  uint64_t order_id;
+  uint64_t client_order_id;
+  uint64_t ticker_index;
+  uint64_t direction;
+  uint64_t offset;
+  uint64_t type;
+  double price;
+  int64_t volume;
+  int64_t traded_volume;
+  int64_t canceled_volume;
+  OrderStatus status;
+  uint64_t insert_time;
+};
+
+// 每个策略同时存在的未结束订单的上限
+inline constexpr std::size_t kMaxOpenOrders = 1024;
+
+/*
+ * 共享内存中每个策略的未结束订单视图，由引擎写入，策略读取
+ * 引擎在订单发出后占用一个槽位，每次状态变化时更新，订单结束时释放。
+ * used是槽位的位图，策略只需要读取位图中被占用的槽位，每个槽位由各自的
+ * 顺序锁保护，读取过程中被释放的槽位会读到order_id为0
+ */
+struct OpenOrderTable {
+  std::atomic<uint64_t> used[kMaxOpenOrders / 64];
+  SeqLocked<OpenOrder> orders[kMaxOpenOrders];
+
+  template <class Func>
+  void for_each(Func&& func) const {
+    for (std::size_t i = 0; i < kMaxOpenOrders / 64; ++i) {
+      uint64_t bits = used[i].load(std::memory_order_acquire);
+      while (bits) {
+        int bit = __builtin_ctzll(bits);
+        bits &= bits - 1;
+
+        auto order = orders[i * 64 + bit].load();
+        if (order.order_id != 0) func(order);
+      }
+    }
+  }
+};
+
+inline std::string proto_open_order_shm_name(uint32_t strategy_id) {
+  return fmt::format("/ft-open-order-{}", strategy_id);
+}
+
 }  // namespace ft
 
 #endif  // FT_INCLUDE_CORE_PROTOCOL_H_
@@ -9,12 +9,28 @@ namespace ft {
 
 static const std::size_t kMarketLevel = 10;
 
+/*
+ * 引擎对每条行情计算一次的盘口指标，随行情一起发布，所有策略看到的值
+ * 完全相同。买一或卖一为空时价格相关的指标为0
+ */
+struct TickAnalytics {
+  double mid_price = 0;
+  double micro_price = 0;     // 按买一卖一挂单量加权的中间价
+  int64_t spread_ticks = 0;   // 买卖价差是多少个最小变动价位
+  double imbalance_l1 = 0;    // (买量-卖量)/(买量+卖量)，范围[-1, 1]
+  double imbalance_l5 = 0;    // 同上，按前5档的总量计算
+  uint64_t bid_depth_l5 = 0;  // 前5档的买量之和
+  uint64_t ask_depth_l5 = 0;
+  uint64_t volume_delta = 0;  // 和同一合约上一条发布的行情之间的成交量
+  uint64_t turnover_delta = 0;
+};
+
 struct TickData {
   uint64_t ticker_index;
-  // std::string date;
-  uint64_t date;
+  uint64_t date;  // 交易日，如20200618，夜盘属于下一个交易日
   uint64_t time_sec;
   uint64_t time_ms;
+  uint64_t exchange_time = 0;  // 交易所时间，UTC纪元以来的纳秒数
 
   double last_price = 0;
   double open_price = 0;
@@ -32,6 +48,13 @@ struct TickData {
   double bid[kMarketLevel]{0};
   uint64_t ask_volume[kMarketLevel]{0};
   uint64_t bid_volume[kMarketLevel]{0};
+
+  // 用于统计延迟的时间戳（now_ns），分别在网关收到行情和引擎转发行情时记录
+  uint64_t gateway_time = 0;
+  uint64_t engine_time = 0;
+
+  // 引擎转发前填写
+  TickAnalytics analytics;
 };
 
 }  // namespace ft
@@ -34,29 +34,34 @@ class TradingEngineInterface {
 
   /*
    * 订单被交易所接受时回调（如果只是被柜台而非交易所接受则不回调）
+   *
+   * 以下订单相关的回调中，recv_time是Gateway刚收到柜台回报时的时间戳（见
+   * Utils/Clock.h的now_ns），用于统计回报在Gateway和引擎内部的耗时
    */
-  virtual void on_order_accepted(uint64_t order_id) {}
+  virtual void on_order_accepted(uint64_t order_id, uint64_t recv_time) {}
 
   /*
    * 订单被拒时回调
    */
-  virtual void on_order_rejected(uint64_t order_id) {}
+  virtual void on_order_rejected(uint64_t order_id, uint64_t recv_time) {}
 
   /*
    * 订单成交时回调
    */
   virtual void on_order_traded(uint64_t order_id, int64_t this_traded,
-                               double traded_price) {}
+                               double traded_price, uint64_t recv_time) {}
 
   /*
    * 撤单成功时回调
    */
-  virtual void on_order_canceled(uint64_t order_id, int64_t canceled_volume) {}
+  virtual void on_order_canceled(uint64_t order_id, int64_t canceled_volume,
+                                 uint64_t recv_time) {}
 
   /*
    * 撤单被拒时回调
    */
-  virtual void on_order_cancel_rejected(uint64_t order_id) {}
+  virtual void on_order_cancel_rejected(uint64_t order_id,
+                                        uint64_t recv_time) {}
 };
 
 }  // namespace ft
@@ -0,0 +1,250 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_CORE_WIREFORMAT_H_
+#define FT_INCLUDE_CORE_WIREFORMAT_H_
+
+#include <spdlog/spdlog.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Core/BarData.h"
+#include "Core/Position.h"
+#include "Core/Protocol.h"
+#include "Core/TickData.h"
+#include "IPC/shm.h"
+#include "Utils/Clock.h"
+
+namespace ft {
+
+/*
+ * 通过redis在进程间传递的二进制消息格式
+ *
+ * 每条消息由固定长度的MsgHeader和紧跟其后的若干个消息体组成，消息体就是
+ * TickData、TraderCommand等结构体本身，接收方校验头部之后直接在收到的
+ * 内存上访问（WireView），不需要解析
+ *
+ * 每种消息体都有一个版本号，修改结构体的布局时必须同时修改版本号和下面的
+ * static_assert，这样新旧版本的进程之间收到的消息会因为版本不一致被丢弃，
+ * 而不是被错误地解释
+ *
+ * 共享内存中的数据结构同理，ShmSegment在开头写入ShmHeader，打开时校验
+ * 类型、版本和大小，修改布局时需要升级ShmTraits中的版本号
+ */
+
+inline const uint32_t kWireMagic = 0x4654574d;  // "FTWM"
+
+enum WireMsgType : uint16_t {
+  WIRE_TICK_DATA = 1,
+  WIRE_TRADER_CMD,
+  WIRE_ORDER_EVENT,
+  WIRE_POSITION,
+  WIRE_BAR_DATA
+};
+
+struct MsgHeader {
+  uint32_t magic;
+  uint16_t type;
+  uint16_t version;
+  uint32_t size;       // 整条消息的长度，包括头部
+  uint32_t count;      // 消息体的个数
+  uint64_t seq;        // 发送方递增的序号，用于检测丢失和排查问题
+  uint64_t send_time;  // 发送时间（now_ns），用于统计传输延迟
+};
+
+static_assert(sizeof(MsgHeader) == 32);
+static_assert(offsetof(MsgHeader, seq) == 16);
+static_assert(offsetof(MsgHeader, send_time) == 24);
+
+template <class T>
+struct WireTraits;
+
+template <>
+struct WireTraits<TickData> {
+  static constexpr uint16_t kType = WIRE_TICK_DATA;
+  static constexpr uint16_t kVersion = 4;
+};
+
+template <>
+struct WireTraits<TraderCommand> {
+  static constexpr uint16_t kType = WIRE_TRADER_CMD;
+  static constexpr uint16_t kVersion = 2;
+};
+
+template <>
+struct WireTraits<OrderEvent> {
+  static constexpr uint16_t kType = WIRE_ORDER_EVENT;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct WireTraits<Position> {
+  static constexpr uint16_t kType = WIRE_POSITION;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct WireTraits<BarData> {
+  static constexpr uint16_t kType = WIRE_BAR_DATA;
+  static constexpr uint16_t kVersion = 1;
+};
+
+// 以下是各个消息体在当前版本下的布局，修改结构体后编译失败说明需要升级版本号
+static_assert(kMarketLevel == 10);
+static_assert(sizeof(TickData) == 536);
+static_assert(offsetof(TickData, last_price) == 40);
+static_assert(offsetof(TickData, level) == 120);
+static_assert(offsetof(TickData, ask) == 128);
+static_assert(offsetof(TickData, bid_volume) == 368);
+static_assert(offsetof(TickData, gateway_time) == 448);
+static_assert(offsetof(TickData, analytics) == 464);
+static_assert(sizeof(TickAnalytics) == 72);
+
+static_assert(sizeof(TraderCommand) == 88);
+static_assert(offsetof(TraderCommand, batch_size) == 12);
+static_assert(offsetof(TraderCommand, send_time) == 16);
+static_assert(offsetof(TraderCommand, order_req) == 32);
+static_assert(sizeof(TraderOrderReq) == 56);
+
+static_assert(sizeof(OrderEvent) == 104);
+static_assert(offsetof(OrderEvent, volume) == 48);
+static_assert(offsetof(OrderEvent, engine_time) == 96);
+
+static_assert(sizeof(Position) == 120);
+static_assert(offsetof(Position, short_pos) == 64);
+
+static_assert(sizeof(BarData) == 120);
+static_assert(offsetof(BarData, open) == 48);
+static_assert(offsetof(BarData, engine_time) == 112);
+
+enum ShmType : uint16_t {
+  SHM_MARKET_DATA = 1,
+  SHM_TRADER_CMD,
+  SHM_ORDER_EVENT,
+  SHM_OPEN_ORDER,
+  SHM_POSITION
+};
+
+template <>
+struct ShmTraits<MarketDataBroadcast> {
+  static constexpr uint16_t kType = SHM_MARKET_DATA;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct ShmTraits<TraderCmdQueue> {
+  static constexpr uint16_t kType = SHM_TRADER_CMD;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct ShmTraits<OrderEventRing> {
+  static constexpr uint16_t kType = SHM_ORDER_EVENT;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct ShmTraits<OpenOrderTable> {
+  static constexpr uint16_t kType = SHM_OPEN_ORDER;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct ShmTraits<PositionTable> {
+  static constexpr uint16_t kType = SHM_POSITION;
+  static constexpr uint16_t kVersion = 1;
+};
+
+// 共享内存中的数据结构在当前版本下的大小，编译失败说明需要升级版本号
+static_assert(sizeof(ShmHeader) == 64);
+static_assert(sizeof(MarketDataBroadcast) == 5112064);
+static_assert(sizeof(TraderCmdQueue) == 1450048);
+static_assert(sizeof(OrderEventRing) == 106624);
+static_assert(sizeof(OpenOrderTable) == 131200);
+static_assert(sizeof(PositionTable) == 524416);
+
+/*
+ * 发送方使用，最多可以容纳kMaxCount个消息体
+ */
+template <class T, std::size_t kMaxCount = 1>
+struct WireMsg {
+  static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>,
+                "T must be trivially copyable and standard layout");
+  static_assert(alignof(T) <= alignof(MsgHeader));
+
+  MsgHeader header;
+  T body[kMaxCount];
+
+  void set_header(uint64_t seq, std::size_t count = 1) {
+    header.magic = kWireMagic;
+    header.type = WireTraits<T>::kType;
+    header.version = WireTraits<T>::kVersion;
+    header.size = sizeof(MsgHeader) + sizeof(T) * count;
+    header.count = count;
+    header.seq = seq;
+    header.send_time = now_ns();
+  }
+
+  const void* data() const { return this; }
+
+  std::size_t size() const { return header.size; }
+};
+
+/*
+ * 接收方使用，校验消息头之后直接访问消息体，不拷贝
+ * data需要按8字节对齐（redis的reply由malloc分配，满足要求）
+ */
+template <class T>
+class WireView {
+ public:
+  WireView(const void* data, std::size_t size)
+      : header_(reinterpret_cast<const MsgHeader*>(data)) {
+    if (size < sizeof(MsgHeader) ||
+        reinterpret_cast<uintptr_t>(data) % alignof(MsgHeader) != 0) {
+      spdlog::error("[WireView] Invalid msg. Size: {}", size);
+      return;
+    }
+
+    if (header_->magic != kWireMagic || header_->type != WireTraits<T>::kType) {
+      spdlog::error("[WireView] Unknown msg. Magic: {:#x}, Type: {}",
+                    header_->magic, header_->type);
+      return;
+    }
+
+    if (header_->version != WireTraits<T>::kVersion) {
+      spdlog::error(
+          "[WireView] Version mismatch. Type: {}, Expected: {}, Received: {}",
+          header_->type, WireTraits<T>::kVersion, header_->version);
+      return;
+    }
+
+    if (header_->size != size ||
+        header_->size != sizeof(MsgHeader) + sizeof(T) * header_->count) {
+      spdlog::error("[WireView] Size mismatch. Header: {}, Received: {}",
+                    header_->size, size);
+      return;
+    }
+
+    is_valid_ = true;
+  }
+
+  bool is_valid() const { return is_valid_; }
+
+  const MsgHeader& header() const { return *header_; }
+
+  std::size_t count() const { return header_->count; }
+
+  const T* data() const { return reinterpret_cast<const T*>(header_ + 1); }
+
+  const T& operator[](std::size_t i) const { return data()[i]; }
+
+ private:
+  const MsgHeader* header_;
+  bool is_valid_ = false;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_CORE_WIREFORMAT_H_
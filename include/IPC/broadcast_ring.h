@@ -0,0 +1,81 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_BROADCAST_RING_H_
+#define FT_INCLUDE_IPC_BROADCAST_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "IPC/spsc_ring.h"
+
+namespace ft {
+
+/*
+ * 单生产者多消费者的广播环形队列
+ * 每条数据只写入一次，消费者各自维护读取位置（序号），互不影响，生产者也
+ * 不关心消费者的进度，写满之后直接覆盖最旧的数据，所以慢的消费者不会拖慢
+ * 生产者和其他消费者。消费者读取时通过槽位上的序号判断数据是否已经被覆盖
+ *
+ * 可以直接放在共享内存中使用（全0即为空队列）
+ */
+template <class T, std::size_t kCapacity>
+class BroadcastRing {
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                "capacity must be power of 2");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "T must be trivially copyable");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+ public:
+  static constexpr std::size_t capacity() { return kCapacity; }
+
+  /*
+   * 只能有一个生产者，返回写入数据的序号
+   */
+  uint64_t push(const T& item) {
+    uint64_t seq = head_.load(std::memory_order_relaxed);
+    auto& slot = slots_[seq & (kCapacity - 1)];
+
+    // 槽位序号为0表示正在写入，写完后设为seq + 1
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.data, &item, sizeof(T));
+    slot.seq.store(seq + 1, std::memory_order_release);
+
+    head_.store(seq + 1, std::memory_order_release);
+    return seq;
+  }
+
+  /*
+   * 下一条数据的序号，即已经写入的数据总数
+   */
+  uint64_t head() const { return head_.load(std::memory_order_acquire); }
+
+  /*
+   * 读取序号为seq的数据，数据还未写入或已经被覆盖时返回false
+   */
+  bool read(uint64_t seq, T* item) const {
+    const auto& slot = slots_[seq & (kCapacity - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != seq + 1) return false;
+
+    memcpy(item, &slot.data, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == seq + 1;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq;
+    T data;
+  };
+
+  alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};
+  alignas(kCacheLineSize) Slot slots_[kCapacity];
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_BROADCAST_RING_H_
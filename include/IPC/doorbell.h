@@ -0,0 +1,93 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_DOORBELL_H_
+#define FT_INCLUDE_IPC_DOORBELL_H_
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+
+namespace ft {
+
+/*
+ * 基于命名管道的跨进程唤醒机制
+ * 消费者把fd加入epoll，生产者写入一个字节即可唤醒消费者，用于共享内存队列
+ * 和epoll等其他事件源一起等待的场景
+ *
+ * 生产者只需要在消费者睡眠时按门铃，管道满了说明消费者已经有待处理的唤醒，
+ * 直接忽略即可
+ */
+class Doorbell {
+ public:
+  Doorbell() {}
+
+  ~Doorbell() { close(); }
+
+  Doorbell(const Doorbell&) = delete;
+  Doorbell& operator=(const Doorbell&) = delete;
+
+  /*
+   * 消费者调用
+   * 以读写方式打开，保证至少有一个写端，没有生产者时也不会一直可读
+   */
+  bool open_reader(const std::string& path) {
+    if (mkfifo(path.c_str(), 0666) != 0 && errno != EEXIST) return false;
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_NONBLOCK);
+    return fd_ >= 0;
+  }
+
+  /*
+   * 生产者调用，消费者还没启动时打开会失败，之后在ring时重试
+   */
+  bool open_writer(const std::string& path) {
+    // 消费者退出后写管道会触发SIGPIPE，这里忽略，由write返回错误
+    signal(SIGPIPE, SIG_IGN);
+
+    path_ = path;
+    if (mkfifo(path.c_str(), 0666) != 0 && errno != EEXIST) return false;
+    return reopen_writer();
+  }
+
+  void ring() {
+    if (fd_ < 0 && !reopen_writer()) return;
+
+    char c = 1;
+    if (::write(fd_, &c, 1) < 0 && errno == EPIPE) close();
+  }
+
+  /*
+   * 消费者在fd可读时调用，清空管道
+   */
+  void drain() {
+    char buf[256];
+    while (::read(fd_, buf, sizeof(buf)) > 0) {
+    }
+  }
+
+  int fd() const { return fd_; }
+
+  void close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+  }
+
+ private:
+  bool reopen_writer() {
+    if (path_.empty()) return false;
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_NONBLOCK);
+    return fd_ >= 0;
+  }
+
+ private:
+  int fd_ = -1;
+  std::string path_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_DOORBELL_H_
@@ -0,0 +1,58 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_FILE_LOCK_H_
+#define FT_INCLUDE_IPC_FILE_LOCK_H_
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace ft {
+
+/*
+ * 基于flock的进程间互斥，用于保证某个资源（如strategy_id）同一时刻只被
+ * 一个实例占用。进程退出（包括崩溃）时内核自动释放，不会留下需要手动清理
+ * 的锁
+ */
+class FileLock {
+ public:
+  FileLock() {}
+
+  ~FileLock() { unlock(); }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+  /*
+   * 不阻塞，已经被其他实例占用时返回false
+   */
+  bool try_lock(const std::string& path) {
+    unlock();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd_ < 0) return false;
+
+    if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+      unlock();
+      return false;
+    }
+    return true;
+  }
+
+  void unlock() {
+    // 关闭fd即释放锁
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+  }
+
+  bool is_locked() const { return fd_ >= 0; }
+
+ private:
+  int fd_ = -1;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_FILE_LOCK_H_
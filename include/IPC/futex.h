@@ -0,0 +1,46 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_FUTEX_H_
+#define FT_INCLUDE_IPC_FUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace ft {
+
+/*
+ * futex的简单封装，用于跨进程的等待/唤醒，所以不能使用FUTEX_PRIVATE_FLAG
+ * 等待的变量必须位于共享内存中
+ */
+
+// 如果*addr仍然等于expected则睡眠，直到被唤醒或超时（timeout_ns为0表示不超时）
+inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected,
+                       uint64_t timeout_ns = 0) {
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+  timespec ts;
+  timespec* pts = nullptr;
+  if (timeout_ns > 0) {
+    ts.tv_sec = timeout_ns / 1000000000UL;
+    ts.tv_nsec = timeout_ns % 1000000000UL;
+    pts = &ts;
+  }
+
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected,
+          pts, nullptr, 0);
+}
+
+// 唤醒最多n个在addr上等待的线程
+inline void futex_wake(std::atomic<uint32_t>* addr, int n = 1) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, n, nullptr,
+          nullptr, 0);
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_FUTEX_H_
@@ -0,0 +1,115 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_MPSC_QUEUE_H_
+#define FT_INCLUDE_IPC_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "IPC/spsc_ring.h"
+
+namespace ft {
+
+/*
+ * 多生产者单消费者队列
+ * 每个生产者独占一个SPSC环形队列（以producer_id为下标），消费者轮询所有队列，
+ * 所以生产者之间不存在竞争。可以直接放在共享内存中使用（全0即为空队列）
+ *
+ * 消费者空闲时可以先自旋一段时间再睡眠，睡眠前调用prepare_sleep。生产者
+ * push之后如果is_consumer_sleeping返回true，需要通过外部的通知机制（如
+ * Doorbell）唤醒消费者，正常情况下push不会产生系统调用
+ */
+template <class T, std::size_t kMaxProducers, std::size_t kCapacity>
+class MpscQueue {
+ public:
+  static constexpr std::size_t max_producers() { return kMaxProducers; }
+
+  /*
+   * 生产者调用，队列满时返回false
+   */
+  bool push(std::size_t producer_id, const T& item) {
+    if (producer_id >= kMaxProducers) return false;
+    if (!rings_[producer_id].push(item)) return false;
+
+    // 和prepare_sleep中的fence配对，保证要么消费者看到新数据，
+    // 要么生产者看到消费者在睡眠
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return true;
+  }
+
+  /*
+   * 生产者调用，一次写入count个元素，消费者会连续处理这些元素
+   * 队列剩余空间不足时不写入任何元素并返回false
+   */
+  bool push(std::size_t producer_id, const T* items, std::size_t count) {
+    if (producer_id >= kMaxProducers) return false;
+    if (!rings_[producer_id].push(items, count)) return false;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return true;
+  }
+
+  /*
+   * 生产者在push成功之后调用，返回true时需要唤醒消费者
+   */
+  bool is_consumer_sleeping() const {
+    return sleeping_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /*
+   * 消费者调用，依次处理所有生产者队列中的数据，返回处理的数量
+   */
+  template <class Handler>
+  std::size_t poll(Handler&& handler) {
+    std::size_t count = 0;
+    for (auto& ring : rings_) {
+      while (const T* item = ring.front()) {
+        handler(*item);
+        ring.pop_front();
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  /*
+   * 消费者调用，丢弃一个生产者队列中所有的数据，返回丢弃的数量
+   */
+  uint64_t clear(std::size_t producer_id) {
+    if (producer_id >= kMaxProducers) return 0;
+    return rings_[producer_id].clear();
+  }
+
+  /*
+   * 消费者在睡眠之前调用，返回false说明有新数据，不能睡眠
+   * 返回true时，消费者醒来后需要调用finish_sleep
+   */
+  bool prepare_sleep() {
+    sleeping_.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!empty()) {
+      sleeping_.store(0, std::memory_order_relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  void finish_sleep() { sleeping_.store(0, std::memory_order_relaxed); }
+
+  bool empty() const {
+    for (const auto& ring : rings_) {
+      if (!ring.empty()) return false;
+    }
+    return true;
+  }
+
+ private:
+  alignas(kCacheLineSize) std::atomic<uint32_t> sleeping_{0};
+
+  SpscRing<T, kCapacity> rings_[kMaxProducers];
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_MPSC_QUEUE_H_
@@ -0,0 +1,60 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_NOTIFIER_H_
+#define FT_INCLUDE_IPC_NOTIFIER_H_
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#include "IPC/futex.h"
+#include "IPC/spsc_ring.h"
+
+namespace ft {
+
+/*
+ * 共享内存中的唤醒点，生产者写入数据后唤醒在这里睡眠的消费者
+ *
+ * 消费者睡眠的步骤：
+ *   auto seq = notifier.prepare_wait();
+ *   if (没有新数据) notifier.wait(seq);
+ *   notifier.finish_wait();
+ * 生产者写入数据之后调用notify，没有消费者睡眠时只是一次内存读取，
+ * 不会产生系统调用
+ *
+ * 两边都在写入之后、读取对方之前加了seq_cst fence，保证不会出现消费者
+ * 看不到新数据、生产者也看不到消费者在睡眠的情况
+ */
+class Notifier {
+ public:
+  uint32_t prepare_wait() {
+    num_waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return seq_.load(std::memory_order_acquire);
+  }
+
+  /*
+   * seq被notify修改过之后会立即返回
+   */
+  void wait(uint32_t seq, uint64_t timeout_ns = 0) {
+    futex_wait(&seq_, seq, timeout_ns);
+  }
+
+  void finish_wait() { num_waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiters_.load(std::memory_order_relaxed) == 0) return;
+
+    seq_.fetch_add(1, std::memory_order_release);
+    futex_wake(&seq_, INT_MAX);
+  }
+
+ private:
+  alignas(kCacheLineSize) std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> num_waiters_{0};
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_NOTIFIER_H_
@@ -9,8 +9,8 @@
 #include <spdlog/spdlog.h>
 
 #include <cassert>
+#include <cstring>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
@@ -18,6 +18,17 @@ namespace ft {
 
 using RedisReply = std::shared_ptr<redisReply>;
 
+/*
+ * 订阅连接上收到的回复是否为publish的消息，订阅确认等其他回复返回false
+ * 是消息时element[1]为channel，element[2]为消息内容
+ */
+inline bool is_sub_message(const RedisReply& reply) {
+  return reply->type == REDIS_REPLY_ARRAY && reply->elements >= 3 &&
+         reply->element[0]->type == REDIS_REPLY_STRING &&
+         strcmp(reply->element[0]->str, "message") == 0 &&
+         reply->element[2]->type == REDIS_REPLY_STRING;
+}
+
 struct RedisReplyDestructor {
   void operator()(redisReply* p) {
     if (p) freeReplyObject(p);
@@ -84,17 +95,39 @@ class RedisSession {
     return RedisReply(reply, RedisReplyDestructor());
   }
 
+  /*
+   * 一条subscribe命令订阅所有topic，redis对每个topic回复一次确认，全部读完
+   * 再返回。需要在开始接收订阅消息之前调用，否则确认之前到达的消息会被
+   * 当作确认丢掉
+   */
   void subscribe(const std::vector<std::string>& topics) {
     if (topics.empty()) return;
 
-    std::stringstream ss;
-    std::string args;
-    for (const auto& topic : topics) ss << topic << " ";
-    ss >> args;
+    append_subscribe_cmd(topics);
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+      redisReply* reply;
+      auto status = redisGetReply(ctx_, reinterpret_cast<void**>(&reply));
+      assert(status == REDIS_OK);
+      freeReplyObject(reply);
+    }
+  }
 
-    auto* reply = reinterpret_cast<redisReply*>(
-        redisCommand(ctx_, "subscribe %s", args.c_str()));
-    freeReplyObject(reply);
+  /*
+   * 在已经开始接收订阅消息的连接上追加订阅，只发送不等待确认。确认和消息
+   * 一样由poll_sub_replies取出，需要用is_sub_message过滤
+   */
+  void append_subscribe(const std::vector<std::string>& topics) {
+    if (topics.empty()) return;
+
+    append_subscribe_cmd(topics);
+    int is_done = 0;
+    while (!is_done) {
+      if (redisBufferWrite(ctx_, &is_done) != REDIS_OK) {
+        spdlog::error("[RedisSession::append_subscribe] Failed to write: {}",
+                      ctx_->errstr);
+        return;
+      }
+    }
   }
 
   RedisReply get_sub_reply() {
@@ -104,6 +137,24 @@ class RedisSession {
     return RedisReply(reply, RedisReplyDestructor());
   }
 
+  /*
+   * 在fd可读时调用，不会阻塞地取出所有已经到达的订阅消息，返回消息的数量
+   */
+  template <class Handler>
+  std::size_t poll_sub_replies(Handler&& handler) {
+    std::size_t count = drain_sub_replies(handler);
+    if (count > 0) return count;
+
+    if (redisBufferRead(ctx_) != REDIS_OK) {
+      spdlog::error("[RedisSession::poll_sub_replies] Failed to read: {}",
+                    ctx_->errstr);
+      return 0;
+    }
+    return drain_sub_replies(handler);
+  }
+
+  int fd() const { return ctx_->fd; }
+
   void publish(const std::string& topic, const void* p, size_t size) {
     const char* argv[3];
     size_t argvlen[3];
@@ -123,8 +174,67 @@ class RedisSession {
     freeReplyObject(reply);
   }
 
+  /*
+   * 把set命令加入pipeline，但不等待结果
+   * 调用flush_pipeline后才会真正发送，并一次性读取所有的回复
+   */
+  void append_set(const std::string& key, const void* p, size_t size) {
+    const char* argv[3];
+    size_t argvlen[3];
+
+    argv[0] = "set";
+    argvlen[0] = 3;
+
+    argv[1] = key.c_str();
+    argvlen[1] = key.length();
+
+    argv[2] = reinterpret_cast<const char*>(p);
+    argvlen[2] = size;
+
+    auto status = redisAppendCommandArgv(ctx_, 3, argv, argvlen);
+    assert(status == REDIS_OK);
+    ++pipeline_size_;
+  }
+
+  void flush_pipeline() {
+    redisReply* reply;
+    for (; pipeline_size_ > 0; --pipeline_size_) {
+      auto status = redisGetReply(ctx_, reinterpret_cast<void**>(&reply));
+      assert(status == REDIS_OK);
+      freeReplyObject(reply);
+    }
+  }
+
+ private:
+  void append_subscribe_cmd(const std::vector<std::string>& topics) {
+    std::vector<const char*> argv{"subscribe"};
+    std::vector<size_t> argvlen{9};
+    for (const auto& topic : topics) {
+      argv.emplace_back(topic.c_str());
+      argvlen.emplace_back(topic.length());
+    }
+
+    auto status = redisAppendCommandArgv(ctx_, argv.size(), argv.data(),
+                                         argvlen.data());
+    assert(status == REDIS_OK);
+  }
+
+  template <class Handler>
+  std::size_t drain_sub_replies(Handler&& handler) {
+    std::size_t count = 0;
+    void* reply = nullptr;
+    while (redisGetReplyFromReader(ctx_, &reply) == REDIS_OK && reply) {
+      handler(RedisReply(reinterpret_cast<redisReply*>(reply),
+                         RedisReplyDestructor()));
+      reply = nullptr;
+      ++count;
+    }
+    return count;
+  }
+
  private:
   redisContext* ctx_ = nullptr;
+  std::size_t pipeline_size_ = 0;
 };
 
 class AsyncRedisSession {
@@ -0,0 +1,63 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_SEQLOCK_H_
+#define FT_INCLUDE_IPC_SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "IPC/spsc_ring.h"
+
+namespace ft {
+
+/*
+ * 单写多读的顺序锁
+ * 写者不会被读者阻塞，读者在读取过程中如果遇到写入则重试，读写双方都不需要系统调用
+ * 可以直接放在共享内存中使用（全0即为初始状态）
+ */
+template <class T>
+class alignas(kCacheLineSize) SeqLocked {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "T must be trivially copyable");
+
+ public:
+  /*
+   * 只能有一个写者
+   */
+  void store(const T& value) {
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data_, &value, sizeof(T));
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  T load() const {
+    T value;
+    uint64_t seq0, seq1;
+    do {
+      seq0 = seq_.load(std::memory_order_acquire);
+      memcpy(&value, &data_, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      seq1 = seq_.load(std::memory_order_relaxed);
+    } while ((seq0 & 1) || seq0 != seq1);
+    return value;
+  }
+
+  /*
+   * 是否被写入过
+   */
+  bool is_written() const {
+    return seq_.load(std::memory_order_acquire) != 0;
+  }
+
+ private:
+  std::atomic<uint64_t> seq_{0};
+  T data_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_SEQLOCK_H_
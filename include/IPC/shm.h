@@ -0,0 +1,224 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_SHM_H_
+#define FT_INCLUDE_IPC_SHM_H_
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ft {
+
+/*
+ * POSIX共享内存的简单封装
+ * 新创建的共享内存全部为0，所以放在共享内存里的数据结构都要保证全0是合法的初始状态，
+ * 这样引擎和策略谁先启动都可以，不需要额外的初始化同步
+ * 进程之间共享的数据结构使用下面带头部的ShmSegment
+ */
+class SharedMemory {
+ public:
+  SharedMemory() = default;
+
+  SharedMemory(const SharedMemory&) = delete;
+  SharedMemory& operator=(const SharedMemory&) = delete;
+
+  ~SharedMemory() { close(); }
+
+  /*
+   * 创建名为name的共享内存，size为映射的大小
+   * 已经存在时返回false，errno为EEXIST
+   */
+  bool create(const std::string& name, std::size_t size) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) return false;
+
+    if (ftruncate(fd, size) != 0) {
+      ::close(fd);
+      shm_unlink(name.c_str());
+      return false;
+    }
+    return map(fd, size);
+  }
+
+  /*
+   * 打开已经存在的共享内存，大小不足size时返回false
+   */
+  bool open(const std::string& name, std::size_t size) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < size) {
+      ::close(fd);
+      return false;
+    }
+    return map(fd, size);
+  }
+
+  void close() {
+    if (addr_) {
+      munmap(addr_, size_);
+      addr_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  static void remove(const std::string& name) { shm_unlink(name.c_str()); }
+
+  bool is_open() const { return addr_ != nullptr; }
+
+  void* address() const { return addr_; }
+
+  std::size_t size() const { return size_; }
+
+  template <class T>
+  T* as() const {
+    return reinterpret_cast<T*>(addr_);
+  }
+
+ private:
+  bool map(int fd, std::size_t size) {
+    void* addr =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    addr_ = addr;
+    size_ = size;
+    return true;
+  }
+
+ private:
+  void* addr_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+inline const uint32_t kShmMagic = 0x4654534d;  // "FTSM"
+
+/*
+ * 共享内存开头的头部，记录了其中数据结构的类型、版本和大小
+ * 创建者写好其他字段之后最后写入magic，magic为0说明头部还没有写好
+ */
+struct alignas(64) ShmHeader {
+  std::atomic<uint32_t> magic;
+  uint16_t type;
+  uint16_t version;
+  uint64_t size;
+};
+
+/*
+ * 每种放在共享内存中的数据结构需要特化ShmTraits，提供kType和kVersion
+ */
+template <class T>
+struct ShmTraits;
+
+/*
+ * 带头部的共享内存，布局为ShmHeader后紧跟T
+ * 不同版本的程序打开同一块共享内存时通过头部发现布局不一致，而不是按错误的
+ * 布局访问对方的数据
+ */
+template <class T>
+class ShmSegment {
+ public:
+  static_assert(alignof(T) <= alignof(ShmHeader));
+
+  /*
+   * 打开名为name的共享内存，不存在则创建并写入头部，T的部分全部为0
+   * 已经存在时校验头部，不一致时：
+   *   is_owner为true：删除后重新创建，已经打开旧内存的进程不受影响
+   *   否则打开失败，由调用方报错退出
+   */
+  bool open(const std::string& name, bool is_owner) {
+    for (int i = 0; i < 2; ++i) {
+      auto result = try_open(name);
+      if (result == OpenResult::OK) return true;
+      if (result == OpenResult::FAILED || !is_owner) break;
+
+      spdlog::warn("[ShmSegment::open] Recreate shm {}", name);
+      shm_.close();
+      SharedMemory::remove(name);
+    }
+
+    shm_.close();
+    return false;
+  }
+
+  void close() { shm_.close(); }
+
+  bool is_open() const { return shm_.is_open(); }
+
+  T* get() const {
+    if (!shm_.is_open()) return nullptr;
+    return reinterpret_cast<T*>(shm_.as<char>() + sizeof(ShmHeader));
+  }
+
+ private:
+  enum class OpenResult { OK, MISMATCH, FAILED };
+
+  OpenResult try_open(const std::string& name) {
+    static const std::size_t kSize = sizeof(ShmHeader) + sizeof(T);
+
+    // 其他进程刚刚创建，还没有设置大小或者写好头部时稍等
+    for (int retry = 0; retry < kMaxRetries; ++retry) {
+      if (shm_.create(name, kSize)) {
+        auto* header = shm_.as<ShmHeader>();
+        header->type = ShmTraits<T>::kType;
+        header->version = ShmTraits<T>::kVersion;
+        header->size = sizeof(T);
+        header->magic.store(kShmMagic, std::memory_order_release);
+        return OpenResult::OK;
+      }
+      if (errno != EEXIST) {
+        spdlog::error("[ShmSegment::open] Failed to create shm {}. Error: {}",
+                      name, errno);
+        return OpenResult::FAILED;
+      }
+
+      if (shm_.open(name, kSize) &&
+          shm_.as<ShmHeader>()->magic.load(std::memory_order_acquire) != 0)
+        return check_header(name) ? OpenResult::OK : OpenResult::MISMATCH;
+      usleep(1000);
+    }
+
+    spdlog::error(
+        "[ShmSegment::open] Shm {} is not initialized or too small", name);
+    return OpenResult::MISMATCH;
+  }
+
+  bool check_header(const std::string& name) const {
+    const auto* header = shm_.as<ShmHeader>();
+    uint32_t magic = header->magic.load(std::memory_order_relaxed);
+    if (magic == kShmMagic && header->type == ShmTraits<T>::kType &&
+        header->version == ShmTraits<T>::kVersion &&
+        header->size == sizeof(T))
+      return true;
+
+    spdlog::error(
+        "[ShmSegment::open] Shm {} mismatch. Magic: {:#x}, Type: {}, "
+        "Version: {}, Size: {}. Expected type: {}, version: {}, size: {}",
+        name, magic, header->type, header->version, header->size,
+        ShmTraits<T>::kType, ShmTraits<T>::kVersion, sizeof(T));
+    return false;
+  }
+
+ private:
+  static constexpr int kMaxRetries = 1000;
+
+  SharedMemory shm_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_SHM_H_
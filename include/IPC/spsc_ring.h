@@ -0,0 +1,126 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_SPSC_RING_H_
+#define FT_INCLUDE_IPC_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace ft {
+
+inline constexpr std::size_t kCacheLineSize = 64;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/*
+ * 单生产者单消费者的无锁环形队列
+ * 可以直接放在共享内存中使用（全0即为空队列），生产者和消费者各自修改的
+ * 下标放在不同的cache line上，避免伪共享
+ */
+template <class T, std::size_t kCapacity>
+class SpscRing {
+  static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0,
+                "capacity must be power of 2");
+  static_assert(std::is_trivially_copyable_v<T>,
+                "T must be trivially copyable");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+ public:
+  static constexpr std::size_t capacity() { return kCapacity; }
+
+  /*
+   * 生产者调用，队列满时返回false
+   */
+  bool push(const T& item) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ >= kCapacity) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ >= kCapacity) return false;
+    }
+
+    slots_[tail & kMask] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*
+   * 生产者调用，一次写入count个元素，消费者要么看到全部要么一个都看不到
+   * 剩余空间不足时不写入任何元素并返回false
+   */
+  bool push(const T* items, std::size_t count) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail + count - head_cache_ > kCapacity) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail + count - head_cache_ > kCapacity) return false;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+      slots_[(tail + i) & kMask] = items[i];
+    tail_.store(tail + count, std::memory_order_release);
+    return true;
+  }
+
+  /*
+   * 消费者调用，返回队首元素的指针，队列为空时返回nullptr
+   * 处理完后需要调用pop_front，期间生产者不会覆盖该元素
+   */
+  const T* front() {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return nullptr;
+    }
+    return &slots_[head & kMask];
+  }
+
+  void pop_front() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  bool pop(T* item) {
+    const T* p = front();
+    if (!p) return false;
+    *item = *p;
+    pop_front();
+    return true;
+  }
+
+  /*
+   * 消费者调用，丢弃队列中所有的数据，返回丢弃的数量
+   */
+  uint64_t clear() {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    tail_cache_ = tail_.load(std::memory_order_acquire);
+    head_.store(tail_cache_, std::memory_order_release);
+    return tail_cache_ - head;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr uint64_t kMask = kCapacity - 1;
+
+  // 消费者写
+  alignas(kCacheLineSize) std::atomic<uint64_t> head_{0};
+  uint64_t tail_cache_ = 0;
+
+  // 生产者写
+  alignas(kCacheLineSize) std::atomic<uint64_t> tail_{0};
+  uint64_t head_cache_ = 0;
+
+  alignas(kCacheLineSize) T slots_[kCapacity];
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_SPSC_RING_H_
@@ -0,0 +1,530 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_JOURNAL_TICKJOURNAL_H_
+#define FT_INCLUDE_JOURNAL_TICKJOURNAL_H_
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Core/ContractTable.h"
+#include "Core/TickData.h"
+#include "Core/WireFormat.h"
+#include "Utils/Clock.h"
+#include "Utils/Counter.h"
+#include "Utils/ThreadAffinity.h"
+
+namespace ft {
+
+/*
+ * 行情日志的文件格式
+ *
+ * 每个交易日一个文件（见journal_file_name），64字节的文件头之后是按写入
+ * 顺序排列的记录。每条记录是WireFormat.h中的MsgHeader加上一个消息体，和
+ * 通过redis发送的消息格式相同，布局变化时同样通过版本号区分：
+ *   JournalTicker: 合约在文件中第一次出现时写入，读取时不依赖当时的合约表
+ *   TickData: 原样写入的行情
+ *   JournalEnd: 关闭文件时写入，续写时之后还可能有新的记录
+ *
+ * 每条记录的magic最后写入，读到magic不对的位置说明已经到了结尾（或者正在
+ * 写入），所以可以一边写一边读。文件按段预先分配，写入中的文件结尾是全0。
+ * 文件关闭时不截断，否则正在读取的进程访问截掉的页时会收到SIGBUS，没有
+ * 用到的空间通过打洞释放，大小不变，读到的仍然是0
+ */
+inline const uint32_t kJournalMagic = 0x46544a4e;  // "FTJN"
+inline const uint32_t kJournalVersion = 1;
+
+struct JournalFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t trading_day;
+  uint64_t data_offset;  // 第一条记录在文件中的位置
+  uint64_t create_time;  // UTC纪元以来的纳秒数
+  char reserved[32];
+};
+
+static_assert(sizeof(JournalFileHeader) == 64);
+
+struct JournalTicker {
+  uint64_t ticker_index;
+  char ticker[56];
+};
+
+struct JournalEnd {
+  uint64_t close_time;  // UTC纪元以来的纳秒数
+};
+
+// 只出现在行情日志中，不和WireMsgType重复
+inline const uint16_t kJournalTickerType = 0x100;
+inline const uint16_t kJournalEndType = 0x101;
+
+template <>
+struct WireTraits<JournalTicker> {
+  static constexpr uint16_t kType = kJournalTickerType;
+  static constexpr uint16_t kVersion = 1;
+};
+
+template <>
+struct WireTraits<JournalEnd> {
+  static constexpr uint16_t kType = kJournalEndType;
+  static constexpr uint16_t kVersion = 1;
+};
+
+static_assert(sizeof(JournalTicker) == 64);
+static_assert(sizeof(JournalEnd) == 8);
+
+inline std::string journal_file_name(const std::string& dir,
+                                     uint64_t trading_day) {
+  return fmt::format("{}/ticks-{}.journal", dir, trading_day);
+}
+
+/*
+ * base中pos处已经写完的记录，没有时返回nullptr
+ */
+inline const MsgHeader* journal_record_at(const char* base, uint64_t size,
+                                          uint64_t pos) {
+  if (pos + sizeof(MsgHeader) > size) return nullptr;
+
+  const auto* header = reinterpret_cast<const MsgHeader*>(base + pos);
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != kWireMagic)
+    return nullptr;
+  if (header->size < sizeof(MsgHeader) || header->size % 8 != 0 ||
+      pos + header->size > size)
+    return nullptr;
+  return header;
+}
+
+/*
+ * 行情日志的写入
+ *
+ * 整个文件通过mmap写入，append只是一次内存拷贝，不调用系统函数。后台线程
+ * 按段用fallocate提前分配磁盘空间，并在写入位置之前保持一个段的已缺页的
+ * 空间，写入线程不会因为缺页或分配空间陷入内核。后台线程同时每隔
+ * flush_interval_ms用msync把新写入的部分落盘
+ *
+ * 进程异常退出时已经写入的记录都在page cache中，不会丢失；重新打开同一个
+ * 交易日的文件时从最后一条完整的记录之后继续写入
+ */
+class TickJournalWriter {
+ public:
+  static constexpr uint64_t kDefaultSegmentSize = 64UL << 20;
+
+  ~TickJournalWriter() { close(); }
+
+  /*
+   * 启动后台线程，文件在收到每个交易日的第一条行情时创建或者续写
+   */
+  bool open(const std::string& dir,
+            uint64_t segment_size = kDefaultSegmentSize,
+            uint64_t flush_interval_ms = 1000) {
+    if (is_running_) return true;
+
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+      spdlog::error("[TickJournalWriter::open] Invalid dir: {}", dir);
+      return false;
+    }
+
+    dir_ = dir;
+    if (dir_.size() > 1 && dir_.back() == '/') dir_.pop_back();
+    page_size_ = sysconf(_SC_PAGESIZE);
+    segment_size_ =
+        std::max((segment_size + page_size_ - 1) / page_size_, 1UL) *
+        page_size_;
+    flush_interval_ = flush_interval_ms * 1000000UL;
+
+    is_running_ = true;
+    thread_ = std::thread([this] { run_background(); });
+    return true;
+  }
+
+  /*
+   * 关闭前需要先停止调用append的线程
+   */
+  void close() {
+    if (!is_running_) return;
+
+    is_running_ = false;
+    if (thread_.joinable()) thread_.join();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    close_file();
+  }
+
+  /*
+   * 只能在一个线程中调用。只有切换交易日，或者后台线程来不及分配空间时
+   * 才会在调用线程中加锁处理，后者计入num_stalls
+   */
+  bool append(const TickData& tick) {
+    if (tick.date != trading_day_ &&
+        (tick.date == failed_day_ || !switch_file(tick.date))) {
+      increase_counter(&num_dropped_);
+      return false;
+    }
+
+    if (!has_ticker(tick.ticker_index)) {
+      JournalTicker ticker{};
+      ticker.ticker_index = tick.ticker_index;
+      const auto* contract = ContractTable::get_by_index(tick.ticker_index);
+      if (contract)
+        snprintf(ticker.ticker, sizeof(ticker.ticker), "%s",
+                 contract->ticker.c_str());
+      if (!write_record(ticker)) {
+        increase_counter(&num_dropped_);
+        return false;
+      }
+      set_has_ticker(tick.ticker_index);
+    }
+
+    if (!write_record(tick)) {
+      increase_counter(&num_dropped_);
+      return false;
+    }
+    increase_counter(&num_ticks_);
+    return true;
+  }
+
+  /*
+   * 把后台线程绑到指定的核，放在行情线程之外
+   */
+  void set_placement(const ThreadPlacement& placement) {
+    apply_thread_placement(thread_.native_handle(), "journal_writer",
+                           placement);
+  }
+
+  // 以下统计可以在其他线程中读取
+  uint64_t num_ticks() const {
+    return num_ticks_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t num_stalls() const {
+    return num_stalls_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t num_dropped() const {
+    return num_dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // 为整个文件预留的地址空间，只是虚拟地址，不占用内存
+  static constexpr uint64_t kMaxFileSize = 64UL << 30;
+  static constexpr uint64_t kBackgroundIntervalMs = 10;
+  static constexpr uint64_t kPrefaultStep = 2UL << 20;
+
+  bool has_ticker(uint64_t ticker_index) const {
+    return ticker_index < has_ticker_.size() && has_ticker_[ticker_index];
+  }
+
+  void set_has_ticker(uint64_t ticker_index) {
+    if (ticker_index >= has_ticker_.size())
+      has_ticker_.resize(ticker_index + 1, false);
+    has_ticker_[ticker_index] = true;
+  }
+
+  template <class T>
+  bool write_record(const T& body) {
+    constexpr uint64_t kSize = sizeof(MsgHeader) + sizeof(T);
+    static_assert(kSize % 8 == 0);
+
+    uint64_t pos = write_pos_.load(std::memory_order_relaxed);
+    if (pos + kSize > allocated_size_.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      increase_counter(&num_stalls_);
+      if (!allocate(pos + kSize)) return false;
+    }
+    put_record(pos, body);
+    return true;
+  }
+
+  /*
+   * pos之后的空间需要已经分配
+   */
+  template <class T>
+  void put_record(uint64_t pos, const T& body) {
+    constexpr uint64_t kSize = sizeof(MsgHeader) + sizeof(T);
+
+    auto* msg = reinterpret_cast<WireMsg<T>*>(base_ + pos);
+    msg->body[0] = body;
+    msg->header.type = WireTraits<T>::kType;
+    msg->header.version = WireTraits<T>::kVersion;
+    msg->header.size = kSize;
+    msg->header.count = 1;
+    msg->header.seq = next_seq_++;
+    msg->header.send_time = now_ns();
+    __atomic_store_n(&msg->header.magic, kWireMagic, __ATOMIC_RELEASE);
+
+    write_pos_.store(pos + kSize, std::memory_order_release);
+  }
+
+  bool switch_file(uint64_t trading_day) {
+    if (trading_day == 0) return false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    close_file();
+    if (open_file(trading_day)) return true;
+
+    // 这个交易日之后的行情直接丢弃，不再反复尝试
+    failed_day_ = trading_day;
+    return false;
+  }
+
+  // 以下函数的调用方需要持有mutex_
+  bool open_file(uint64_t trading_day) {
+    auto file = journal_file_name(dir_, trading_day);
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+      spdlog::error("[TickJournalWriter::open_file] Failed to open {}", file);
+      return false;
+    }
+
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0) {
+      base = mmap(nullptr, kMaxFileSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_NORESERVE, fd, 0);
+    }
+    if (base == MAP_FAILED) {
+      spdlog::error("[TickJournalWriter::open_file] Failed to map {}", file);
+      ::close(fd);
+      return false;
+    }
+
+    fd_ = fd;
+    base_ = reinterpret_cast<char*>(base);
+    file_ = file;
+    trading_day_ = trading_day;
+    file_size_ = st.st_size;
+    allocated_size_.store(st.st_size, std::memory_order_relaxed);
+    has_ticker_.clear();
+    next_seq_ = 0;
+
+    // 先准备好开头的一部分空间，之后由后台线程继续
+    bool is_ok = st.st_size == 0 ? init_file() : resume_file();
+    uint64_t pos = write_pos_.load(std::memory_order_relaxed);
+    if (!is_ok || !allocate(pos + kPrefaultStep)) {
+      munmap(base_, kMaxFileSize);
+      ::close(fd_);
+      fd_ = -1;
+      base_ = nullptr;
+      trading_day_ = 0;
+      return false;
+    }
+
+    synced_pos_ = write_pos_.load(std::memory_order_relaxed);
+    spdlog::info("[TickJournalWriter::open_file] {} opened. Records: {}",
+                 file_, next_seq_);
+    return true;
+  }
+
+  bool init_file() {
+    if (!allocate(sizeof(JournalFileHeader))) return false;
+
+    auto* header = reinterpret_cast<JournalFileHeader*>(base_);
+    *header = JournalFileHeader{};
+    header->version = kJournalVersion;
+    header->trading_day = trading_day_;
+    header->data_offset = sizeof(JournalFileHeader);
+    header->create_time = wall_time_ns();
+    __atomic_store_n(&header->magic, kJournalMagic, __ATOMIC_RELEASE);
+
+    write_pos_.store(header->data_offset, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*
+   * 跳过已有的记录（包括上次关闭时写入的JournalEnd），从最后一条完整的
+   * 记录之后继续写入
+   */
+  bool resume_file() {
+    uint64_t size = allocated_size_.load(std::memory_order_relaxed);
+    const auto* header = reinterpret_cast<const JournalFileHeader*>(base_);
+    if (size < sizeof(JournalFileHeader) || header->magic != kJournalMagic ||
+        header->version != kJournalVersion ||
+        header->trading_day != trading_day_) {
+      spdlog::error(
+          "[TickJournalWriter::resume_file] Not a journal of {}, or of "
+          "another version: {}",
+          trading_day_, file_);
+      return false;
+    }
+
+    uint64_t pos = header->data_offset;
+    while (const auto* record = journal_record_at(base_, size, pos)) {
+      if (record->type == kJournalTickerType) {
+        const auto* ticker = reinterpret_cast<const JournalTicker*>(record + 1);
+        set_has_ticker(ticker->ticker_index);
+      }
+      pos += record->size;
+      ++next_seq_;
+    }
+
+    write_pos_.store(pos, std::memory_order_relaxed);
+
+    // 上次正常关闭时释放了写入位置之后的空间，文件大小不变但是没有分配
+    // 磁盘。从写入位置所在页的下一页开始重新分配和缺页，否则写入线程会在
+    // 缺页时才分配磁盘，磁盘满时收到SIGBUS
+    uint64_t allocated = (pos + page_size_ - 1) / page_size_ * page_size_;
+    file_size_ = std::min(file_size_, allocated);
+    allocated_size_.store(file_size_, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*
+   * 保证min_size之前的空间可以写入：文件按段扩展，缺页只处理到min_size
+   * 所在的页为止，后台线程每次只处理kPrefaultStep，不会长时间占用CPU
+   */
+  bool allocate(uint64_t min_size) {
+    uint64_t size = allocated_size_.load(std::memory_order_relaxed);
+    if (size >= min_size) return true;
+
+    if (min_size > file_size_) {
+      uint64_t file_size =
+          (min_size + segment_size_ - 1) / segment_size_ * segment_size_;
+      if (file_size > kMaxFileSize) {
+        spdlog::error("[TickJournalWriter::allocate] {} is full", file_);
+        return false;
+      }
+
+      // 不支持fallocate的文件系统退化为ftruncate，续写时文件可能已经比
+      // file_size_大，只能扩大不能截断
+      if (posix_fallocate(fd_, file_size_, file_size - file_size_) != 0 &&
+          !extend_file(file_size)) {
+        spdlog::error("[TickJournalWriter::allocate] Failed to extend {}",
+                      file_);
+        return false;
+      }
+      file_size_ = file_size;
+    }
+
+    // 写入线程不会访问allocated_size_之后的空间
+    uint64_t new_size = std::min(
+        file_size_, (min_size + page_size_ - 1) / page_size_ * page_size_);
+    for (uint64_t offset = size; offset < new_size; offset += page_size_)
+      reinterpret_cast<volatile char*>(base_)[offset] = 0;
+
+    allocated_size_.store(new_size, std::memory_order_release);
+    return true;
+  }
+
+  bool extend_file(uint64_t file_size) {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return false;
+    if (static_cast<uint64_t>(st.st_size) >= file_size) return true;
+    return ftruncate(fd_, file_size) == 0;
+  }
+
+  /*
+   * 写入过程中只同步写入位置之前的整页：正在回写的页会被内核设为只读，
+   * 写入线程再写这一页时会缺页并等待回写完成
+   */
+  void sync(uint64_t pos, bool is_final = false) {
+    uint64_t begin = synced_pos_ / page_size_ * page_size_;
+    uint64_t end = is_final ? pos : pos / page_size_ * page_size_;
+    if (end <= begin) return;
+
+    if (msync(base_ + begin, end - begin, MS_SYNC) != 0)
+      spdlog::warn("[TickJournalWriter::sync] Failed to sync {}", file_);
+    synced_pos_ = end;
+  }
+
+  void close_file() {
+    if (fd_ < 0) return;
+
+    uint64_t pos = write_pos_.load(std::memory_order_relaxed);
+    if (allocate(pos + sizeof(WireMsg<JournalEnd>))) {
+      put_record(pos, JournalEnd{wall_time_ns()});
+      pos = write_pos_.load(std::memory_order_relaxed);
+    }
+    sync(pos, true);
+    munmap(base_, kMaxFileSize);
+
+    // 释放预先分配但没有用到的磁盘空间，文件大小不变
+    uint64_t hole = (pos + page_size_ - 1) / page_size_ * page_size_;
+    if (hole < file_size_ &&
+        fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, hole,
+                  file_size_ - hole) != 0)
+      spdlog::warn(
+          "[TickJournalWriter::close_file] Failed to release unused space of "
+          "{}",
+          file_);
+    ::close(fd_);
+
+    spdlog::info("[TickJournalWriter::close_file] {} closed. Records: {}",
+                 file_, next_seq_);
+    fd_ = -1;
+    base_ = nullptr;
+    trading_day_ = 0;
+    file_size_ = 0;
+    allocated_size_.store(0, std::memory_order_relaxed);
+    write_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  void run_background() {
+    uint64_t next_flush_time = now_ns() + flush_interval_;
+    while (is_running_) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(kBackgroundIntervalMs));
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (fd_ < 0) continue;
+
+      // 保持一个段的余量
+      uint64_t pos = write_pos_.load(std::memory_order_acquire);
+      uint64_t size = allocated_size_.load(std::memory_order_relaxed);
+      allocate(std::min(pos + segment_size_, size + kPrefaultStep));
+
+      uint64_t now = now_ns();
+      if (now >= next_flush_time) {
+        sync(pos);
+        next_flush_time = now + flush_interval_;
+      }
+    }
+  }
+
+ private:
+  std::string dir_;
+  uint64_t page_size_ = 4096;
+  uint64_t segment_size_ = kDefaultSegmentSize;
+  uint64_t flush_interval_ = 0;
+
+  // 只在写入线程中访问
+  uint64_t trading_day_ = 0;
+  uint64_t failed_day_ = 0;
+  uint64_t next_seq_ = 0;
+  std::vector<bool> has_ticker_;
+
+  // 当前的文件，打开、关闭和扩展时需要持有mutex_
+  std::mutex mutex_;
+  int fd_ = -1;
+  char* base_ = nullptr;
+  std::string file_;
+  uint64_t file_size_ = 0;                    // 已经分配的磁盘空间
+  std::atomic<uint64_t> allocated_size_ = 0;  // 已经完成缺页的空间
+  std::atomic<uint64_t> write_pos_ = 0;
+  uint64_t synced_pos_ = 0;  // 只在持有mutex_时访问
+
+  // 只有写入线程修改，其他线程只读取
+  std::atomic<uint64_t> num_ticks_ = 0;
+  std::atomic<uint64_t> num_stalls_ = 0;
+  std::atomic<uint64_t> num_dropped_ = 0;
+
+  std::atomic<bool> is_running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_JOURNAL_TICKJOURNAL_H_
@@ -0,0 +1,174 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_JOURNAL_TICKJOURNALREADER_H_
+#define FT_INCLUDE_JOURNAL_TICKJOURNALREADER_H_
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Core/TickData.h"
+#include "Core/WireFormat.h"
+#include "Journal/TickJournal.h"
+
+namespace ft {
+
+/*
+ * 按写入顺序读取行情日志，不依赖合约表，ticker_index对应的合约从日志中
+ * 的JournalTicker记录得到
+ *
+ * 可以读取正在写入的文件：读到结尾后next返回nullptr，之后再调用可以读到
+ * 新写入的行情，文件变大时自动重新映射。写入方关闭文件时不会截断，所以
+ * 映射的范围一直有效
+ */
+class TickJournalReader {
+ public:
+  ~TickJournalReader() { close(); }
+
+  bool open(const std::string& file) {
+    close();
+
+    fd_ = ::open(file.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      spdlog::error("[TickJournalReader::open] Failed to open {}", file);
+      return false;
+    }
+
+    if (!remap() || mapped_size_ < sizeof(JournalFileHeader)) {
+      spdlog::error("[TickJournalReader::open] Empty file: {}", file);
+      close();
+      return false;
+    }
+
+    const auto* header = reinterpret_cast<const JournalFileHeader*>(base_);
+    if (header->magic != kJournalMagic || header->version != kJournalVersion) {
+      spdlog::error(
+          "[TickJournalReader::open] Not a journal, or of another version: {}",
+          file);
+      close();
+      return false;
+    }
+
+    trading_day_ = header->trading_day;
+    pos_ = header->data_offset;
+    return true;
+  }
+
+  void close() {
+    if (base_) munmap(base_, mapped_size_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    mapped_size_ = 0;
+    fd_ = -1;
+    is_closed_ = false;
+  }
+
+  uint64_t trading_day() const { return trading_day_; }
+
+  /*
+   * 最后读到的记录是否为JournalEnd，即写入方已经关闭了文件。写入方重新
+   * 打开同一个交易日的文件续写时会再次变为false
+   */
+  bool is_closed() const { return is_closed_; }
+
+  /*
+   * 下一条行情，读到结尾或者遇到版本不一致的行情时返回nullptr
+   * 返回的指针在下一次调用next之前有效
+   */
+  const TickData* next() {
+    for (;;) {
+      const auto* header = journal_record_at(base_, mapped_size_, pos_);
+      if (!header) {
+        // 记录可能跨过了映射的结尾
+        if (pos_ + sizeof(WireMsg<TickData>) <= mapped_size_ || !remap())
+          return nullptr;
+        header = journal_record_at(base_, mapped_size_, pos_);
+        if (!header) return nullptr;
+      }
+
+      is_closed_ = header->type == kJournalEndType;
+      if (header->type == WIRE_TICK_DATA) {
+        if (!check_version<TickData>(*header)) return nullptr;
+        pos_ += header->size;
+        ++num_ticks_;
+        return reinterpret_cast<const TickData*>(header + 1);
+      }
+
+      if (header->type == kJournalTickerType) {
+        if (!check_version<JournalTicker>(*header)) return nullptr;
+        const auto* ticker = reinterpret_cast<const JournalTicker*>(header + 1);
+        if (ticker->ticker_index >= tickers_.size())
+          tickers_.resize(ticker->ticker_index + 1);
+        tickers_[ticker->ticker_index] = ticker->ticker;
+      }
+      pos_ += header->size;
+    }
+  }
+
+  /*
+   * 写入时ticker_index对应的合约，如"rb2009.SHFE"，没有记录时返回空字符串
+   */
+  const std::string& ticker(uint64_t ticker_index) const {
+    static const std::string kEmpty;
+    return ticker_index < tickers_.size() ? tickers_[ticker_index] : kEmpty;
+  }
+
+  uint64_t num_ticks() const { return num_ticks_; }
+
+ private:
+  template <class T>
+  bool check_version(const MsgHeader& header) {
+    if (header.version == WireTraits<T>::kVersion &&
+        header.size == sizeof(MsgHeader) + sizeof(T))
+      return true;
+
+    spdlog::error(
+        "[TickJournalReader::next] Version mismatch. Type: {}, Expected: {}, "
+        "Received: {}",
+        header.type, WireTraits<T>::kVersion, header.version);
+    return false;
+  }
+
+  /*
+   * 文件变大时重新映射整个文件
+   */
+  bool remap() {
+    struct stat st;
+    if (fstat(fd_, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) <= mapped_size_)
+      return false;
+
+    void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+      spdlog::error("[TickJournalReader::remap] Failed to map the journal");
+      return false;
+    }
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+    if (base_) munmap(base_, mapped_size_);
+    base_ = reinterpret_cast<char*>(base);
+    mapped_size_ = st.st_size;
+    return true;
+  }
+
+ private:
+  int fd_ = -1;
+  char* base_ = nullptr;
+  uint64_t mapped_size_ = 0;
+  uint64_t pos_ = 0;
+
+  uint64_t trading_day_ = 0;
+  uint64_t num_ticks_ = 0;
+  bool is_closed_ = false;
+  std::vector<std::string> tickers_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_JOURNAL_TICKJOURNALREADER_H_
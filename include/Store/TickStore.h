@@ -0,0 +1,450 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_STORE_TICKSTORE_H_
+#define FT_INCLUDE_STORE_TICKSTORE_H_
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Core/TickData.h"
+
+namespace ft {
+
+/*
+ * 历史行情库的文件格式
+ *
+ * 每个交易日一个文件（见tick_store_file_name），每个合约一个block：
+ *   StoreFileHeader
+ *   block...           每个block是一个合约当天的全部行情
+ *   StoreBlockEntry... 按合约名排序的目录，读取时二分查找
+ *   StoreFileTrailer   目录的位置
+ *
+ * block由若干页组成，每页最多kStorePageTicks条行情，按列存储：同一个字段
+ * 的值连续存放，每个值和本页上一条行情的差做zigzag编码后写成varint。价格
+ * 先按合约的price_tick换算成整数个最小变动价位，成交量、持仓量这类累计值
+ * 的差通常只有1到2个字节。block的末尾是按时间的页索引和StoreBlockFooter，
+ * 读取一个时间段时只解码和这个时间段有交集的页
+ *
+ * 时间用交易时间表示（见trading_time_ms），夜盘在日盘之前。只保存交易所
+ * 发布的字段，exchange_time精确到毫秒，analytics等引擎填写的字段不保存
+ */
+inline const uint32_t kStoreMagic = 0x46545453;  // "FTTS"
+inline const uint32_t kStoreVersion = 1;
+inline const uint32_t kStorePageTicks = 1024;
+
+struct StoreFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t trading_day;
+  char reserved[48];
+};
+
+struct StoreBlockEntry {
+  char ticker[32];
+  uint64_t offset;  // block在文件中的位置
+  uint64_t size;
+  uint64_t num_ticks;
+  uint32_t min_time;  // 交易时间
+  uint32_t max_time;
+};
+
+struct StorePageIndex {
+  uint64_t offset;  // 页在block中的位置
+  uint32_t size;
+  uint32_t num_ticks;
+  uint32_t min_time;
+  uint32_t max_time;  // 本页及之前所有页的最大值，所以按页的顺序单调不减
+};
+
+struct StoreBlockFooter {
+  double price_tick;
+  uint64_t num_pages;
+  uint64_t num_ticks;
+  uint32_t magic;
+  uint32_t reserved;
+};
+
+struct StoreFileTrailer {
+  uint64_t directory_offset;
+  uint64_t num_blocks;
+  uint32_t magic;
+  uint32_t version;
+  uint64_t reserved;
+};
+
+/*
+ * 页头之后是每一列的字节数（uint32_t），然后是各列的数据，页的大小补齐到
+ * 8字节。同一页中行情的档数相同，档数变化时换页
+ */
+struct StorePageHeader {
+  uint32_t num_ticks;
+  uint32_t level;
+};
+
+static_assert(sizeof(StoreFileHeader) == 64);
+static_assert(sizeof(StoreBlockEntry) == 64);
+static_assert(sizeof(StorePageIndex) == 24);
+static_assert(sizeof(StoreBlockFooter) == 32);
+static_assert(sizeof(StoreFileTrailer) == 32);
+static_assert(sizeof(StorePageHeader) == 8);
+
+/*
+ * 页中的列，之后每一档依次是卖价、买价、卖量、买量
+ */
+enum StoreColumn : uint32_t {
+  COL_TIME = 0,
+  COL_EXCHANGE_TIME,  // exchange_time的毫秒数减去交易时间，没有时为0
+  COL_LAST_PRICE,
+  COL_OPEN_PRICE,
+  COL_HIGHEST_PRICE,
+  COL_LOWEST_PRICE,
+  COL_PRE_CLOSE_PRICE,
+  COL_UPPER_LIMIT_PRICE,
+  COL_LOWER_LIMIT_PRICE,
+  COL_VOLUME,
+  COL_TURNOVER,
+  COL_OPEN_INTEREST,
+  COL_LEVEL_BEGIN,
+};
+
+inline const uint32_t kStoreMaxColumns = COL_LEVEL_BEGIN + 4 * kMarketLevel;
+
+inline uint32_t store_num_columns(uint32_t level) {
+  return COL_LEVEL_BEGIN + 4 * level;
+}
+
+inline std::string tick_store_file_name(const std::string& dir,
+                                        uint64_t trading_day) {
+  return fmt::format("{}/ticks-{}.store", dir, trading_day);
+}
+
+/*
+ * 交易时间：前一天18:00以来的毫秒数，同一个交易日内单调递增
+ */
+inline uint32_t trading_time_ms(uint64_t time_sec, uint64_t time_ms) {
+  return (time_sec + 6 * 3600) % 86400 * 1000 +
+         std::min<uint64_t>(time_ms, 999);
+}
+
+inline uint64_t trading_time_to_sec(uint32_t time) {
+  return (time / 1000 + 18 * 3600) % 86400;
+}
+
+inline void put_varint(int64_t value, std::string* out) {
+  uint64_t v = (static_cast<uint64_t>(value) << 1) ^
+               static_cast<uint64_t>(value >> 63);
+  while (v >= 0x80) {
+    out->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  out->push_back(static_cast<char>(v));
+}
+
+/*
+ * 数据不完整时返回nullptr
+ */
+inline const char* get_varint(const char* p, const char* end, int64_t* value) {
+  uint64_t v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    auto byte = static_cast<uint8_t>(*p++);
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = static_cast<int64_t>((v >> 1) ^ (~(v & 1) + 1));
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * 价格和最小变动价位个数之间的换算。price_tick小于1时除以它的倒数（如
+ * 0.2的倒数是5），换算回来的价格和从文本解析出来的价格完全相同
+ */
+class PriceScale {
+ public:
+  explicit PriceScale(double price_tick) {
+    if (!(price_tick > 0 && price_tick < 1e9)) price_tick = 0.0001;
+    is_multiply_ = price_tick >= 1;
+    factor_ = is_multiply_ ? price_tick : std::round(1 / price_tick);
+  }
+
+  /*
+   * 不在价格网格上时按最近的价位换算并返回false，无效的价格换算为0。
+   * 没有price_tick时按0.0001换算
+   */
+  bool to_ticks(double price, int64_t* ticks) const {
+    if (!(std::fabs(price) < 1e15)) {
+      *ticks = 0;
+      return false;
+    }
+
+    double x = is_multiply_ ? price / factor_ : price * factor_;
+    *ticks = std::llround(x);
+    return std::fabs(x - static_cast<double>(*ticks)) < 1e-6;
+  }
+
+  double to_price(int64_t ticks) const {
+    return is_multiply_ ? static_cast<double>(ticks) * factor_
+                        : static_cast<double>(ticks) / factor_;
+  }
+
+ private:
+  bool is_multiply_;
+  double factor_;
+};
+
+/*
+ * 把一个合约一天的行情按上面的格式编码成一个block
+ *
+ * 行情应该按时间顺序append，乱序的行情同样可以保存和读取，只是读取时间段
+ * 时可能多解码一些页
+ */
+class TickBlockEncoder {
+ public:
+  explicit TickBlockEncoder(double price_tick)
+      : price_tick_(price_tick), scale_(price_tick) {}
+
+  void append(const TickData& tick) {
+    auto level = static_cast<uint32_t>(
+        std::clamp<int>(tick.level, 0, static_cast<int>(kMarketLevel)));
+    if (page_ticks_ > 0 &&
+        (page_ticks_ == kStorePageTicks || level != page_level_))
+      flush_page();
+
+    if (page_ticks_ == 0) {
+      page_level_ = level;
+      page_min_time_ = UINT32_MAX;
+      std::fill(prev_, prev_ + kStoreMaxColumns, 0);
+    }
+
+    uint32_t time = trading_time_ms(tick.time_sec, tick.time_ms);
+    int64_t values[kStoreMaxColumns];
+    values[COL_TIME] = time;
+    values[COL_EXCHANGE_TIME] =
+        tick.exchange_time == 0
+            ? 0
+            : static_cast<int64_t>(tick.exchange_time / 1000000UL) - time;
+    price(tick.last_price, &values[COL_LAST_PRICE]);
+    price(tick.open_price, &values[COL_OPEN_PRICE]);
+    price(tick.highest_price, &values[COL_HIGHEST_PRICE]);
+    price(tick.lowest_price, &values[COL_LOWEST_PRICE]);
+    price(tick.pre_close_price, &values[COL_PRE_CLOSE_PRICE]);
+    price(tick.upper_limit_price, &values[COL_UPPER_LIMIT_PRICE]);
+    price(tick.lower_limit_price, &values[COL_LOWER_LIMIT_PRICE]);
+    values[COL_VOLUME] = static_cast<int64_t>(tick.volume);
+    values[COL_TURNOVER] = static_cast<int64_t>(tick.turnover);
+    values[COL_OPEN_INTEREST] = static_cast<int64_t>(tick.open_interest);
+    for (uint32_t i = 0; i < level; ++i) {
+      auto* v = &values[COL_LEVEL_BEGIN + 4 * i];
+      price(tick.ask[i], &v[0]);
+      price(tick.bid[i], &v[1]);
+      v[2] = static_cast<int64_t>(tick.ask_volume[i]);
+      v[3] = static_cast<int64_t>(tick.bid_volume[i]);
+    }
+
+    for (uint32_t c = 0; c < store_num_columns(level); ++c) {
+      put_varint(values[c] - prev_[c], &columns_[c]);
+      prev_[c] = values[c];
+    }
+
+    page_min_time_ = std::min(page_min_time_, time);
+    max_time_ = std::max(max_time_, time);
+    min_time_ = std::min(min_time_, time);
+    ++page_ticks_;
+    ++num_ticks_;
+  }
+
+  /*
+   * 写完最后一页，之后data和index才完整
+   */
+  void finish() {
+    if (page_ticks_ > 0) flush_page();
+  }
+
+  const std::string& data() const { return data_; }
+  const std::vector<StorePageIndex>& index() const { return index_; }
+  double price_tick() const { return price_tick_; }
+  uint64_t num_ticks() const { return num_ticks_; }
+  uint32_t min_time() const { return num_ticks_ > 0 ? min_time_ : 0; }
+  uint32_t max_time() const { return max_time_; }
+
+  /*
+   * 不在价格网格上或者无效的价格数，这些价格按最近的价位保存
+   */
+  uint64_t num_off_grid() const { return num_off_grid_; }
+
+ private:
+  void price(double price, int64_t* ticks) {
+    if (!scale_.to_ticks(price, ticks)) ++num_off_grid_;
+  }
+
+  void flush_page() {
+    StorePageIndex entry{};
+    entry.offset = data_.size();
+
+    StorePageHeader header{page_ticks_, page_level_};
+    data_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint32_t num_columns = store_num_columns(page_level_);
+    for (uint32_t c = 0; c < num_columns; ++c) {
+      auto size = static_cast<uint32_t>(columns_[c].size());
+      data_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    for (uint32_t c = 0; c < num_columns; ++c) {
+      data_.append(columns_[c]);
+      columns_[c].clear();
+    }
+    data_.resize((data_.size() + 7) / 8 * 8, '\0');
+
+    entry.size = static_cast<uint32_t>(data_.size() - entry.offset);
+    entry.num_ticks = page_ticks_;
+    entry.min_time = page_min_time_;
+    entry.max_time = max_time_;
+    index_.emplace_back(entry);
+    page_ticks_ = 0;
+  }
+
+ private:
+  double price_tick_;
+  PriceScale scale_;
+
+  std::string data_;
+  std::vector<StorePageIndex> index_;
+  uint64_t num_ticks_ = 0;
+  uint64_t num_off_grid_ = 0;
+  uint32_t min_time_ = UINT32_MAX;
+  uint32_t max_time_ = 0;
+
+  std::string columns_[kStoreMaxColumns];
+  int64_t prev_[kStoreMaxColumns];
+  uint32_t page_ticks_ = 0;
+  uint32_t page_level_ = 0;
+  uint32_t page_min_time_ = UINT32_MAX;
+};
+
+/*
+ * 生成一个交易日的行情库文件，每个合约调用一次write_block，close时写入
+ * 目录。写入过程中使用file.tmp，close成功后才改名为file
+ */
+class TickStoreWriter {
+ public:
+  ~TickStoreWriter() {
+    if (fp_) {
+      fclose(fp_);
+      std::remove(tmp_file_.c_str());
+    }
+  }
+
+  bool open(const std::string& file, uint64_t trading_day) {
+    file_ = file;
+    tmp_file_ = file + ".tmp";
+    fp_ = fopen(tmp_file_.c_str(), "wb");
+    if (!fp_) {
+      spdlog::error("[TickStoreWriter::open] Failed to open {}", tmp_file_);
+      return false;
+    }
+
+    StoreFileHeader header{};
+    header.magic = kStoreMagic;
+    header.version = kStoreVersion;
+    header.trading_day = trading_day;
+    entries_.clear();
+    pos_ = 0;
+    return write(&header, sizeof(header));
+  }
+
+  bool write_block(const std::string& ticker, TickBlockEncoder* encoder) {
+    if (ticker.empty() || ticker.size() >= sizeof(StoreBlockEntry::ticker)) {
+      spdlog::error("[TickStoreWriter::write_block] Invalid ticker: {}",
+                    ticker);
+      return false;
+    }
+
+    encoder->finish();
+    StoreBlockEntry entry{};
+    strncpy(entry.ticker, ticker.c_str(), sizeof(entry.ticker) - 1);
+    entry.offset = pos_;
+    entry.num_ticks = encoder->num_ticks();
+    entry.min_time = encoder->min_time();
+    entry.max_time = encoder->max_time();
+
+    StoreBlockFooter footer{};
+    footer.price_tick = encoder->price_tick();
+    footer.num_pages = encoder->index().size();
+    footer.num_ticks = encoder->num_ticks();
+    footer.magic = kStoreMagic;
+
+    const auto& data = encoder->data();
+    const auto& index = encoder->index();
+    if (!write(data.data(), data.size()) ||
+        !write(index.data(), index.size() * sizeof(StorePageIndex)) ||
+        !write(&footer, sizeof(footer)))
+      return false;
+
+    entry.size = pos_ - entry.offset;
+    entries_.emplace_back(entry);
+    return true;
+  }
+
+  bool close() {
+    if (!fp_) return false;
+
+    std::sort(entries_.begin(), entries_.end(),
+              [](const StoreBlockEntry& a, const StoreBlockEntry& b) {
+                return strcmp(a.ticker, b.ticker) < 0;
+              });
+    for (std::size_t i = 1; i < entries_.size(); ++i) {
+      if (strcmp(entries_[i - 1].ticker, entries_[i].ticker) == 0) {
+        spdlog::error("[TickStoreWriter::close] Duplicated ticker: {}",
+                      entries_[i].ticker);
+        return false;
+      }
+    }
+
+    StoreFileTrailer trailer{};
+    trailer.directory_offset = pos_;
+    trailer.num_blocks = entries_.size();
+    trailer.magic = kStoreMagic;
+    trailer.version = kStoreVersion;
+    if (!write(entries_.data(), entries_.size() * sizeof(StoreBlockEntry)) ||
+        !write(&trailer, sizeof(trailer)))
+      return false;
+
+    bool ok = fclose(fp_) == 0;
+    fp_ = nullptr;
+    if (!ok || std::rename(tmp_file_.c_str(), file_.c_str()) != 0) {
+      spdlog::error("[TickStoreWriter::close] Failed to write {}", file_);
+      std::remove(tmp_file_.c_str());
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  bool write(const void* data, std::size_t size) {
+    if (size > 0 && fwrite(data, 1, size, fp_) != size) {
+      spdlog::error("[TickStoreWriter::write] Failed to write {}", tmp_file_);
+      return false;
+    }
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  std::string file_;
+  std::string tmp_file_;
+  FILE* fp_ = nullptr;
+  uint64_t pos_ = 0;
+  std::vector<StoreBlockEntry> entries_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_STORE_TICKSTORE_H_
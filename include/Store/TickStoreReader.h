@@ -0,0 +1,268 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_STORE_TICKSTOREREADER_H_
+#define FT_INCLUDE_STORE_TICKSTOREREADER_H_
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Core/ContractTable.h"
+#include "Core/TickData.h"
+#include "Store/TickStore.h"
+
+namespace ft {
+
+/*
+ * 读取行情库文件
+ *
+ * 整个文件通过mmap映射，读取一个合约的一个时间段时只访问目录、这个合约的
+ * 页索引和有交集的页，不会读到其他合约的数据。合约在合约表中时填写
+ * ticker_index，否则为0
+ */
+class TickStoreReader {
+ public:
+  ~TickStoreReader() { close(); }
+
+  bool open(const std::string& file) {
+    close();
+
+    fd_ = ::open(file.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      spdlog::error("[TickStoreReader::open] Failed to open {}", file);
+      return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0 ||
+        static_cast<uint64_t>(st.st_size) <
+            sizeof(StoreFileHeader) + sizeof(StoreFileTrailer)) {
+      spdlog::error("[TickStoreReader::open] Invalid file: {}", file);
+      close();
+      return false;
+    }
+
+    void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+      spdlog::error("[TickStoreReader::open] Failed to map {}", file);
+      close();
+      return false;
+    }
+    // 按时间段读取时只访问很少的页，不需要预读
+    madvise(base, st.st_size, MADV_RANDOM);
+    base_ = reinterpret_cast<const char*>(base);
+    size_ = st.st_size;
+
+    const auto* header = reinterpret_cast<const StoreFileHeader*>(base_);
+    const auto* trailer = reinterpret_cast<const StoreFileTrailer*>(
+        base_ + size_ - sizeof(StoreFileTrailer));
+    if (header->magic != kStoreMagic || header->version != kStoreVersion ||
+        trailer->magic != kStoreMagic || trailer->version != kStoreVersion ||
+        trailer->num_blocks > size_ / sizeof(StoreBlockEntry) ||
+        trailer->directory_offset +
+                trailer->num_blocks * sizeof(StoreBlockEntry) >
+            size_ - sizeof(StoreFileTrailer)) {
+      spdlog::error(
+          "[TickStoreReader::open] Not a tick store, or of another version: "
+          "{}",
+          file);
+      close();
+      return false;
+    }
+
+    trading_day_ = header->trading_day;
+    entries_ = reinterpret_cast<const StoreBlockEntry*>(
+        base_ + trailer->directory_offset);
+    num_blocks_ = trailer->num_blocks;
+    return true;
+  }
+
+  void close() {
+    if (base_) munmap(const_cast<char*>(base_), size_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    size_ = 0;
+    fd_ = -1;
+    entries_ = nullptr;
+    num_blocks_ = 0;
+  }
+
+  uint64_t trading_day() const { return trading_day_; }
+
+  /*
+   * 文件中的合约，按合约名排序
+   */
+  std::size_t num_blocks() const { return num_blocks_; }
+  const StoreBlockEntry& block(std::size_t i) const { return entries_[i]; }
+
+  const StoreBlockEntry* find(const std::string& ticker) const {
+    const auto* end = entries_ + num_blocks_;
+    const auto* iter = std::lower_bound(
+        entries_, end, ticker,
+        [](const StoreBlockEntry& entry, const std::string& ticker) {
+          return strcmp(entry.ticker, ticker.c_str()) < 0;
+        });
+    if (iter == end || ticker != iter->ticker) return nullptr;
+    return iter;
+  }
+
+  /*
+   * 读取ticker当天的全部行情，追加到ticks中。合约不存在时返回true，数据
+   * 损坏时返回false
+   */
+  bool read(const std::string& ticker, std::vector<TickData>* ticks) const {
+    return read_range(ticker, 0, kEndOfDay, ticks);
+  }
+
+  /*
+   * 读取ticker在[begin_sec, end_sec)之间的行情，时间是当天的秒数（如9:00为
+   * 32400），按交易时间比较，所以21:00到次日01:00也是一个有效的时间段。
+   * 交易日从18:00开始，end_sec为18:00时表示到当天结束
+   */
+  bool read(const std::string& ticker, uint64_t begin_sec, uint64_t end_sec,
+            std::vector<TickData>* ticks) const {
+    uint32_t end = trading_time_ms(end_sec, 0);
+    return read_range(ticker, trading_time_ms(begin_sec, 0),
+                      end == 0 ? kEndOfDay : end, ticks);
+  }
+
+ private:
+  static constexpr uint32_t kEndOfDay = 86400 * 1000;
+
+  bool read_range(const std::string& ticker, uint32_t begin, uint32_t end,
+                  std::vector<TickData>* ticks) const {
+    const auto* entry = find(ticker);
+    if (!entry || entry->num_ticks == 0) return true;
+    if (begin >= end || entry->max_time < begin || entry->min_time >= end)
+      return true;
+
+    if (entry->size < sizeof(StoreBlockFooter) ||
+        entry->offset + entry->size > size_)
+      return corrupted(ticker);
+    const char* block = base_ + entry->offset;
+    const auto* footer = reinterpret_cast<const StoreBlockFooter*>(
+        block + entry->size - sizeof(StoreBlockFooter));
+    if (footer->magic != kStoreMagic ||
+        footer->num_pages >
+            (entry->size - sizeof(StoreBlockFooter)) / sizeof(StorePageIndex))
+      return corrupted(ticker);
+
+    uint64_t index_offset = entry->size - sizeof(StoreBlockFooter) -
+                            footer->num_pages * sizeof(StorePageIndex);
+    const auto* index =
+        reinterpret_cast<const StorePageIndex*>(block + index_offset);
+    const auto* index_end = index + footer->num_pages;
+
+    // max_time单调不减，之前的页中所有行情都早于begin
+    const auto* page = std::lower_bound(
+        index, index_end, begin, [](const StorePageIndex& page, uint32_t t) {
+          return page.max_time < t;
+        });
+
+    uint64_t ticker_index = 0;
+    if (const auto* contract = ContractTable::get_by_ticker(ticker))
+      ticker_index = contract->index;
+
+    PriceScale scale(footer->price_tick);
+    for (; page != index_end; ++page) {
+      if (page->min_time >= end) continue;
+      if (page->offset + page->size > index_offset ||
+          !decode_page(block + page->offset, page->size, scale, ticker_index,
+                       begin, end, ticks))
+        return corrupted(ticker);
+    }
+    return true;
+  }
+
+  bool decode_page(const char* page, uint32_t size, const PriceScale& scale,
+                   uint64_t ticker_index, uint32_t begin, uint32_t end,
+                   std::vector<TickData>* ticks) const {
+    if (size < sizeof(StorePageHeader)) return false;
+    const auto* header = reinterpret_cast<const StorePageHeader*>(page);
+    if (header->level > kMarketLevel) return false;
+
+    uint32_t num_columns = store_num_columns(header->level);
+    uint64_t pos = sizeof(StorePageHeader) + num_columns * sizeof(uint32_t);
+    if (pos > size) return false;
+
+    const auto* column_sizes =
+        reinterpret_cast<const uint32_t*>(page + sizeof(StorePageHeader));
+    const char* cursors[kStoreMaxColumns];
+    const char* ends[kStoreMaxColumns];
+    for (uint32_t c = 0; c < num_columns; ++c) {
+      cursors[c] = page + pos;
+      pos += column_sizes[c];
+      if (pos > size) return false;
+      ends[c] = page + pos;
+    }
+
+    int64_t values[kStoreMaxColumns]{0};
+    for (uint32_t i = 0; i < header->num_ticks; ++i) {
+      for (uint32_t c = 0; c < num_columns; ++c) {
+        int64_t delta;
+        cursors[c] = get_varint(cursors[c], ends[c], &delta);
+        if (!cursors[c]) return false;
+        values[c] += delta;
+      }
+
+      auto time = static_cast<uint32_t>(values[COL_TIME]);
+      if (time < begin || time >= end) continue;
+
+      auto& tick = ticks->emplace_back();
+      tick.ticker_index = ticker_index;
+      tick.date = trading_day_;
+      tick.time_sec = trading_time_to_sec(time);
+      tick.time_ms = time % 1000;
+      if (values[COL_EXCHANGE_TIME] != 0)
+        tick.exchange_time =
+            static_cast<uint64_t>(values[COL_EXCHANGE_TIME] + time) *
+            1000000UL;
+      tick.last_price = scale.to_price(values[COL_LAST_PRICE]);
+      tick.open_price = scale.to_price(values[COL_OPEN_PRICE]);
+      tick.highest_price = scale.to_price(values[COL_HIGHEST_PRICE]);
+      tick.lowest_price = scale.to_price(values[COL_LOWEST_PRICE]);
+      tick.pre_close_price = scale.to_price(values[COL_PRE_CLOSE_PRICE]);
+      tick.upper_limit_price = scale.to_price(values[COL_UPPER_LIMIT_PRICE]);
+      tick.lower_limit_price = scale.to_price(values[COL_LOWER_LIMIT_PRICE]);
+      tick.volume = values[COL_VOLUME];
+      tick.turnover = values[COL_TURNOVER];
+      tick.open_interest = values[COL_OPEN_INTEREST];
+      tick.level = header->level;
+      for (uint32_t l = 0; l < header->level; ++l) {
+        const auto* v = &values[COL_LEVEL_BEGIN + 4 * l];
+        tick.ask[l] = scale.to_price(v[0]);
+        tick.bid[l] = scale.to_price(v[1]);
+        tick.ask_volume[l] = v[2];
+        tick.bid_volume[l] = v[3];
+      }
+    }
+    return true;
+  }
+
+  bool corrupted(const std::string& ticker) const {
+    spdlog::error("[TickStoreReader::read] Corrupted block. Ticker: {}",
+                  ticker);
+    return false;
+  }
+
+ private:
+  int fd_ = -1;
+  const char* base_ = nullptr;
+  uint64_t size_ = 0;
+
+  uint64_t trading_day_ = 0;
+  const StoreBlockEntry* entries_ = nullptr;
+  std::size_t num_blocks_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_STORE_TICKSTOREREADER_H_
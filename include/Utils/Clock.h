@@ -0,0 +1,32 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_CLOCK_H_
+#define FT_INCLUDE_UTILS_CLOCK_H_
+
+#include <cstdint>
+#include <ctime>
+
+namespace ft {
+
+/*
+ * 单调时钟，单位为纳秒
+ * 同一台机器上不同进程之间可比较，可用于计算跨进程的延迟
+ */
+inline uint64_t now_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+/*
+ * 系统时钟，UTC纪元以来的纳秒数，用于和交易所时间比较
+ */
+inline uint64_t wall_time_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_CLOCK_H_
@@ -0,0 +1,22 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_COUNTER_H_
+#define FT_INCLUDE_UTILS_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace ft {
+
+/*
+ * 只有一个线程修改、其他线程只读取的统计计数
+ * 不需要原子的read-modify-write，读取方用relaxed load即可
+ */
+inline void increase_counter(std::atomic<uint64_t>* counter) {
+  counter->store(counter->load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_COUNTER_H_
@@ -0,0 +1,209 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_DEFERREDLOG_H_
+#define FT_INCLUDE_UTILS_DEFERREDLOG_H_
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "IPC/spsc_ring.h"
+#include "Utils/ThreadAffinity.h"
+
+namespace ft {
+
+/*
+ * 热路径上使用的延迟日志
+ *
+ * 调用线程只把日志位置（静态的格式串和日志级别）和原始参数拷贝到本线程
+ * 的无锁队列中，格式化和写入都由后台线程完成，最后仍然通过spdlog输出。
+ * 队列满时丢弃日志而不是阻塞调用线程
+ *
+ * 参数必须是可平凡拷贝的类型，std::string需要改为const char*，并且保证
+ * 后台线程格式化时仍然有效（如ContractTable中的ticker）。需要查表转换的
+ * 参数用LazyStr包装，查表也放到后台线程中进行
+ */
+
+struct LogSite {
+  spdlog::level::level_enum level;
+  const char* fmt;
+};
+
+inline constexpr std::size_t kMaxLogArgSize = 48;
+
+struct LogRecord {
+  using FormatFunc = std::string (*)(const LogSite* site, const void* args);
+
+  const LogSite* site;
+  FormatFunc format;
+  alignas(8) char args[kMaxLogArgSize];
+};
+
+static_assert(sizeof(LogRecord) == 64);
+
+template <class... Args>
+std::string format_log_args(const LogSite* site, const void* args) {
+  const auto& tuple = *reinterpret_cast<const std::tuple<Args...>*>(args);
+  auto format = [site](const Args&... values) {
+    return fmt::format(site->fmt, values...);
+  };
+  return std::apply(format, tuple);
+}
+
+/*
+ * 在后台线程中才转为string的参数，F是direction_str这类查表函数
+ */
+template <const std::string& (*F)(uint64_t)>
+struct LazyStr {
+  uint64_t value;
+};
+
+class DeferredLogger {
+ public:
+  static DeferredLogger& instance() {
+    static DeferredLogger logger;
+    return logger;
+  }
+
+  ~DeferredLogger() {
+    is_running_ = false;
+    if (thread_.joinable()) thread_.join();
+  }
+
+  /*
+   * 把后台线程绑到指定的核，放在热路径线程之外
+   */
+  void set_placement(const ThreadPlacement& placement) {
+    apply_thread_placement(thread_.native_handle(), "log_writer", placement);
+  }
+
+  pthread_t native_handle() { return thread_.native_handle(); }
+
+  void write(const LogRecord& record) {
+    auto* buffer = thread_buffer();
+    if (!buffer->ring.push(record))
+      buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  using LogRing = SpscRing<LogRecord, 4096>;
+
+  struct ThreadBuffer {
+    LogRing ring;
+    std::atomic<uint64_t> dropped{0};
+    uint64_t reported_dropped = 0;
+  };
+
+  DeferredLogger() : thread_([this] { run(); }) {}
+
+  /*
+   * 每个线程第一次写日志时注册自己的队列，线程退出后队列留到进程结束
+   */
+  ThreadBuffer* thread_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+      auto new_buffer = std::make_unique<ThreadBuffer>();
+      buffer = new_buffer.get();
+      std::unique_lock<std::mutex> lock(mutex_);
+      buffers_.emplace_back(std::move(new_buffer));
+    }
+    return buffer;
+  }
+
+  void run() {
+    bool is_running = true;
+    while (is_running) {
+      // 先读取标志再处理，保证退出前写入的日志都被输出
+      is_running = is_running_;
+      if (flush() == 0 && is_running)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  std::size_t flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    std::size_t count = 0;
+    for (auto& buffer : buffers_) {
+      while (const auto* record = buffer->ring.front()) {
+        spdlog::log(record->site->level, "{}",
+                    record->format(record->site, record->args));
+        buffer->ring.pop_front();
+        ++count;
+      }
+
+      uint64_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+      if (dropped != buffer->reported_dropped) {
+        spdlog::warn("[DeferredLogger::flush] Log ring is full. Dropped: {}",
+                     dropped);
+        buffer->reported_dropped = dropped;
+      }
+    }
+    return count;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::atomic<bool> is_running_ = true;
+  std::thread thread_;
+};
+
+template <class... Args>
+inline void log_deferred(const LogSite& site, const Args&... args) {
+  static_assert((std::is_trivially_copyable_v<Args> && ...),
+                "Deferred log args must be trivially copyable");
+  static_assert(sizeof(std::tuple<Args...>) <= kMaxLogArgSize,
+                "Too many deferred log args");
+  static_assert(alignof(std::tuple<Args...>) <= 8);
+
+  if (!spdlog::default_logger_raw()->should_log(site.level)) return;
+
+  LogRecord record;
+  record.site = &site;
+  record.format = &format_log_args<Args...>;
+  new (record.args) std::tuple<Args...>(args...);
+  DeferredLogger::instance().write(record);
+}
+
+}  // namespace ft
+
+namespace fmt {
+
+template <const std::string& (*F)(uint64_t)>
+struct formatter<ft::LazyStr<F>> : formatter<string_view> {
+  template <class FormatContext>
+  auto format(const ft::LazyStr<F>& s, FormatContext& ctx) {
+    return formatter<string_view>::format(F(s.value), ctx);
+  }
+};
+
+}  // namespace fmt
+
+/*
+ * 每个调用位置对应一个静态的LogSite，记录时只保存它的地址
+ */
+#define FT_LOG_DEFERRED(lvl, fmt_str, ...)                    \
+  do {                                                        \
+    static constexpr ::ft::LogSite ft_log_site{lvl, fmt_str}; \
+    ::ft::log_deferred(ft_log_site, ##__VA_ARGS__);           \
+  } while (0)
+
+#define FT_LOG_DEBUG(fmt_str, ...) \
+  FT_LOG_DEFERRED(spdlog::level::debug, fmt_str, ##__VA_ARGS__)
+#define FT_LOG_INFO(fmt_str, ...) \
+  FT_LOG_DEFERRED(spdlog::level::info, fmt_str, ##__VA_ARGS__)
+#define FT_LOG_WARN(fmt_str, ...) \
+  FT_LOG_DEFERRED(spdlog::level::warn, fmt_str, ##__VA_ARGS__)
+
+#endif  // FT_INCLUDE_UTILS_DEFERREDLOG_H_
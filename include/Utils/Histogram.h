@@ -0,0 +1,99 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_HISTOGRAM_H_
+#define FT_INCLUDE_UTILS_HISTOGRAM_H_
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace ft {
+
+/*
+ * 延迟分布统计，桶的划分方式和HdrHistogram类似：
+ * 小于kSubBuckets的值每个值一个桶，之后每个[2^n, 2^(n+1))区间等分为
+ * kSubBuckets个桶，所以任意值的相对误差不超过1/kSubBuckets（约6%），
+ * 而桶的总数只和值的位数有关。记录是O(1)的，不分配内存
+ *
+ * 不是线程安全的，由调用方保证同一时刻只有一个线程访问
+ */
+class Histogram {
+ public:
+  static constexpr uint64_t kSubBucketBits = 4;
+  static constexpr uint64_t kSubBuckets = 1UL << kSubBucketBits;
+  static constexpr std::size_t kNumBuckets =
+      (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(uint64_t value) {
+    ++buckets_[bucket_of(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void reset() { *this = Histogram(); }
+
+  uint64_t count() const { return count_; }
+
+  uint64_t min() const { return count_ > 0 ? min_ : 0; }
+
+  uint64_t max() const { return max_; }
+
+  uint64_t avg() const { return count_ > 0 ? sum_ / count_ : 0; }
+
+  /*
+   * p的取值范围是[0, 100]，返回所在桶的上界
+   */
+  uint64_t percentile(double p) const {
+    if (count_ == 0) return 0;
+
+    auto target = static_cast<uint64_t>(count_ * p / 100);
+    uint64_t accumulated = 0;
+    for (std::size_t i = 0; i < kNumBuckets; ++i) {
+      accumulated += buckets_[i];
+      if (accumulated > target) return std::min(upper_bound_of(i), max_);
+    }
+    return max_;
+  }
+
+  std::string summary() const {
+    return fmt::format(
+        "count={} avg={} min={} p50={} p90={} p99={} p99.9={} max={}", count(),
+        avg(), min(), percentile(50), percentile(90), percentile(99),
+        percentile(99.9), max());
+  }
+
+ private:
+  static std::size_t bucket_of(uint64_t value) {
+    if (value < kSubBuckets) return value;
+
+    uint64_t msb = 63 - __builtin_clzll(value);
+    uint64_t shift = msb - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) +
+           ((value >> shift) & (kSubBuckets - 1));
+  }
+
+  static uint64_t upper_bound_of(std::size_t bucket) {
+    if (bucket < kSubBuckets) return bucket;
+
+    uint64_t shift = (bucket >> kSubBucketBits) - 1;
+    uint64_t sub = bucket & (kSubBuckets - 1);
+    uint64_t lower = (kSubBuckets + sub) << shift;
+    return lower + ((1UL << shift) - 1);
+  }
+
+ private:
+  uint64_t buckets_[kNumBuckets]{};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_HISTOGRAM_H_
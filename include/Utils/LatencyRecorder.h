@@ -0,0 +1,88 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_LATENCYRECORDER_H_
+#define FT_INCLUDE_UTILS_LATENCYRECORDER_H_
+
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Utils/Histogram.h"
+
+namespace ft {
+
+/*
+ * 按阶段统计延迟，每个阶段一个Histogram
+ * 各个时间戳都来自now_ns，同一台机器上的不同进程之间可以直接相减
+ *
+ * 不是线程安全的，由调用方保证同一时刻只有一个线程访问
+ */
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(std::vector<std::string> stage_names)
+      : stage_names_(std::move(stage_names)),
+        histograms_(stage_names_.size()) {}
+
+  /*
+   * 任意一个时间戳缺失（为0）或者顺序颠倒时不记录
+   */
+  void record(std::size_t stage, uint64_t begin, uint64_t end) {
+    if (begin == 0 || end < begin) return;
+    histograms_[stage].record(end - begin);
+  }
+
+  void report(const std::string& name) const {
+    for (std::size_t i = 0; i < histograms_.size(); ++i) {
+      if (histograms_[i].count() == 0) continue;
+      spdlog::info("[{}] Latency of {}(ns): {}", name, stage_names_[i],
+                   histograms_[i].summary());
+    }
+  }
+
+  void reset() {
+    for (auto& histogram : histograms_) histogram.reset();
+  }
+
+ private:
+  std::vector<std::string> stage_names_;
+  std::vector<Histogram> histograms_;
+};
+
+/*
+ * 收到SIGUSR1时请求输出一次延迟统计
+ * notify_fd不小于0时，信号处理函数同时往这个eventfd写入，
+ * 阻塞在epoll上的进程可以据此被唤醒，否则由进程的主循环定期检查
+ */
+inline std::atomic<bool> latency_dump_requested = false;
+inline std::atomic<int> latency_dump_notify_fd = -1;
+
+inline void install_latency_dump_handler(int notify_fd = -1) {
+  latency_dump_notify_fd.store(notify_fd, std::memory_order_relaxed);
+
+  struct sigaction action {};
+  action.sa_handler = [](int) {
+    latency_dump_requested.store(true, std::memory_order_relaxed);
+    // write是async-signal-safe的，eventfd的计数也不会溢出
+    int fd = latency_dump_notify_fd.load(std::memory_order_relaxed);
+    uint64_t value = 1;
+    if (fd >= 0 && write(fd, &value, sizeof(value)) < 0) return;
+  };
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, nullptr);
+}
+
+inline bool take_latency_dump_request() {
+  return latency_dump_requested.load(std::memory_order_relaxed) &&
+         latency_dump_requested.exchange(false);
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_LATENCYRECORDER_H_
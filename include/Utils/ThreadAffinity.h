@@ -0,0 +1,166 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_UTILS_THREADAFFINITY_H_
+#define FT_INCLUDE_UTILS_THREADAFFINITY_H_
+
+#include <fmt/format.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace ft {
+
+/*
+ * 一个线程运行的位置：绑定的核以及是否使用SCHED_FIFO
+ *
+ * cpu小于0表示不绑核，fifo_priority为0表示不修改调度策略。SCHED_FIFO的
+ * 线程会一直占用所在的核直到主动让出，busy poll的线程设置了优先级后必须
+ * 绑到隔离的核上，否则同一个核上的内核线程和其他进程会被饿死
+ */
+struct ThreadPlacement {
+  int cpu = -1;
+  int fifo_priority = 0;
+
+  bool is_set() const { return cpu >= 0 || fifo_priority > 0; }
+};
+
+/*
+ * 解析/sys/devices/system/cpu/isolated这类"0-3,6"格式的核列表
+ */
+inline bool is_cpu_in_list(const std::string& list, int cpu) {
+  std::size_t pos = 0;
+  while (pos < list.size()) {
+    std::size_t end = list.find(',', pos);
+    if (end == std::string::npos) end = list.size();
+
+    int first = -1;
+    int last = -1;
+    int n = sscanf(list.c_str() + pos, "%d-%d", &first, &last);
+    if (n == 1) last = first;
+    if (n >= 1 && cpu >= first && cpu <= last) return true;
+    pos = end + 1;
+  }
+  return false;
+}
+
+/*
+ * 是否通过isolcpus从调度器中隔离，隔离的核上只会运行绑定到它的线程
+ */
+inline bool is_cpu_isolated(int cpu) {
+  static const std::string isolated = [] {
+    std::ifstream ifs("/sys/devices/system/cpu/isolated");
+    std::string list;
+    std::getline(ifs, list);
+    return list;
+  }();
+  return is_cpu_in_list(isolated, cpu);
+}
+
+/*
+ * 读取线程实际生效的绑核和调度策略，用于启动时输出
+ */
+inline std::string describe_thread_placement(pthread_t thread) {
+  std::string cpus;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (pthread_getaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0) {
+    int count = CPU_COUNT(&cpu_set);
+    for (int cpu = 0; cpu < CPU_SETSIZE && count > 0; ++cpu) {
+      if (!CPU_ISSET(cpu, &cpu_set)) continue;
+      // 连续的核合并为一个区间
+      int last = cpu;
+      while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpu_set)) ++last;
+      if (!cpus.empty()) cpus += ',';
+      if (last == cpu)
+        cpus += std::to_string(cpu);
+      else
+        cpus += fmt::format("{}-{}", cpu, last);
+      count -= last - cpu + 1;
+      cpu = last;
+    }
+  }
+
+  int policy = SCHED_OTHER;
+  sched_param param{};
+  pthread_getschedparam(thread, &policy, &param);
+  const char* policy_name = policy == SCHED_FIFO  ? "SCHED_FIFO"
+                            : policy == SCHED_RR  ? "SCHED_RR"
+                                                  : "SCHED_OTHER";
+
+  std::string desc = fmt::format("cpus={} policy={}", cpus, policy_name);
+  if (policy != SCHED_OTHER)
+    desc += fmt::format(" priority={}", param.sched_priority);
+  if (CPU_COUNT(&cpu_set) == 1) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        desc += is_cpu_isolated(cpu) ? " isolated" : " not-isolated";
+        break;
+      }
+    }
+  }
+  return desc;
+}
+
+inline void report_thread_placement(pthread_t thread, const std::string& name) {
+  spdlog::info("[ThreadPlacement] {}: {}", name,
+               describe_thread_placement(thread));
+}
+
+/*
+ * 设置线程的名字、绑核和调度策略，失败时只告警，线程仍然可以正常运行
+ *
+ * 新创建的线程会继承创建者的绑核和调度策略，所以应该在其他线程都创建
+ * 好之后再设置创建者自己
+ */
+inline bool apply_thread_placement(pthread_t thread, const std::string& name,
+                                   const ThreadPlacement& placement) {
+  // 线程名最长15个字符，方便在top -H中区分
+  pthread_setname_np(thread, name.substr(0, 15).c_str());
+
+  bool is_ok = true;
+  if (placement.cpu >= 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(placement.cpu, &cpu_set);
+    int error = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+    if (error != 0) {
+      spdlog::warn("[apply_thread_placement] Failed to pin {} to cpu {}: {}",
+                   name, placement.cpu, strerror(error));
+      is_ok = false;
+    }
+  }
+
+  if (placement.fifo_priority > 0) {
+    sched_param param{};
+    param.sched_priority = placement.fifo_priority;
+    int error = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (error != 0) {
+      spdlog::warn(
+          "[apply_thread_placement] Failed to set SCHED_FIFO({}) of {}: {}",
+          placement.fifo_priority, name, strerror(error));
+      is_ok = false;
+    }
+
+    // 实时线程所在的核上的其他线程可能被饿死
+    if (placement.cpu >= 0 && !is_cpu_isolated(placement.cpu)) {
+      spdlog::warn("[apply_thread_placement] SCHED_FIFO {} on cpu {} which "
+                   "is not isolated", name, placement.cpu);
+    }
+  }
+
+  return is_ok;
+}
+
+inline bool pin_current_thread(const std::string& name,
+                               const ThreadPlacement& placement) {
+  return apply_thread_placement(pthread_self(), name, placement);
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_UTILS_THREADAFFINITY_H_
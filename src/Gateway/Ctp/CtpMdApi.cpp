@@ -6,6 +6,9 @@
 
 #include <utility>
 
+#include "Utils/Clock.h"
+#include "Utils/DeferredLog.h"
+
 namespace ft {
 
 CtpMdApi::CtpMdApi(TradingEngineInterface *engine) : engine_(engine) {}
@@ -31,6 +34,7 @@ bool CtpMdApi::login(const LoginParams &params) {
   broker_id_ = params.broker_id();
   investor_id_ = params.investor_id();
   passwd_ = params.passwd();
+  thread_placement_ = params.md_thread();
 
   md_api_->RegisterSpi(this);
   md_api_->RegisterFront(const_cast<char *>(server_addr_.c_str()));
@@ -62,6 +66,13 @@ bool CtpMdApi::login(const LoginParams &params) {
   std::string symbol;
   std::string exchange;
   for (const auto &ticker : params.subscribed_list()) {
+    // 回调线程只读取normalizer_，必须在订阅前建好
+    if (!normalizer_.add_ticker(ticker)) {
+      spdlog::warn(
+          "[CtpMdApi::login] Ticker not found in contract list or symbol is "
+          "too long. Ticker: {}",
+          ticker);
+    }
     ticker_split(ticker, &symbol, &exchange);
     subscribed_list_.emplace_back(std::move(symbol));
   }
@@ -89,6 +100,10 @@ void CtpMdApi::logout() {
 }
 
 void CtpMdApi::OnFrontConnected() {
+  // CTP没有提供回调线程的句柄，只能在回调线程中设置自己
+  pin_current_thread("ctp_md", thread_placement_);
+  report_thread_placement(pthread_self(), "ctp_md");
+
   is_connected_ = true;
   spdlog::debug("[CtpMdApi::OnFrontConnectedMD] Connected");
 }
@@ -119,6 +134,7 @@ void CtpMdApi::OnRspUserLogin(CThostFtdcRspUserLoginField *login_rsp,
 
   spdlog::debug("[CtpMdApi::OnRspUserLogin] Success. Login as {}",
                 investor_id_);
+  if (login_rsp) normalizer_.set_trading_day(login_rsp->TradingDay);
   is_logon_ = true;
 }
 
@@ -147,7 +163,7 @@ void CtpMdApi::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *instrument,
     return;
   }
 
-  auto *contract = ContractTable::get_by_symbol(instrument->InstrumentID);
+  auto *contract = normalizer_.find(instrument->InstrumentID);
   if (!contract) {
     spdlog::error(
         "[CtpMdApi::OnRspSubMarketData] Failed. ExchangeID not found in "
@@ -156,7 +172,6 @@ void CtpMdApi::OnRspSubMarketData(CThostFtdcSpecificInstrumentField *instrument,
         instrument->InstrumentID);
     return;
   }
-  symbol2contract_.emplace(contract->symbol, contract);
 
   spdlog::debug("[CtpMdApi::OnRspSubMarketData] Success. Ticker: {}",
                 contract->ticker);
@@ -175,13 +190,15 @@ void CtpMdApi::OnRspUnSubForQuoteRsp(
     CThostFtdcRspInfoField *rsp_info, int req_id, bool is_last) {}
 
 void CtpMdApi::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *md) {
+  uint64_t recv_time = now_ns();
   if (!md) {
     spdlog::error("[CtpMdApi::OnRtnDepthMarketData] Failed. md is nullptr");
     return;
   }
 
-  auto iter = symbol2contract_.find(md->InstrumentID);
-  if (iter == symbol2contract_.end()) {
+  TickData tick;
+  const auto *contract = normalizer_.normalize(*md, recv_time, &tick);
+  if (!contract) {
     spdlog::warn(
         "[CtpMdApi::OnRtnDepthMarketData] Failed. ExchangeID not found in "
         "contract list. "
@@ -190,52 +207,10 @@ void CtpMdApi::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *md) {
     return;
   }
 
-  TickData tick;
-  tick.ticker_index = iter->second->index;
-
-  struct tm _tm;
-  strptime(md->UpdateTime, "%H:%M:%S", &_tm);
-  tick.time_sec = _tm.tm_sec + _tm.tm_min * 60 + _tm.tm_hour * 3600;
-  tick.time_ms = md->UpdateMillisec;
-  // tick.date = md->ActionDay;
-
-  tick.volume = md->Volume;
-  tick.turnover = md->Turnover;
-  tick.open_interest = md->OpenInterest;
-  tick.last_price = adjust_price(md->LastPrice);
-  tick.open_price = adjust_price(md->OpenPrice);
-  tick.highest_price = adjust_price(md->HighestPrice);
-  tick.lowest_price = adjust_price(md->LowestPrice);
-  tick.pre_close_price = adjust_price(md->PreClosePrice);
-  tick.upper_limit_price = adjust_price(md->UpperLimitPrice);
-  tick.lower_limit_price = adjust_price(md->LowerLimitPrice);
-
-  tick.level = 5;
-  tick.ask[0] = adjust_price(md->AskPrice1);
-  tick.ask[1] = adjust_price(md->AskPrice2);
-  tick.ask[2] = adjust_price(md->AskPrice3);
-  tick.ask[3] = adjust_price(md->AskPrice4);
-  tick.ask[4] = adjust_price(md->AskPrice5);
-  tick.bid[0] = adjust_price(md->BidPrice1);
-  tick.bid[1] = adjust_price(md->BidPrice2);
-  tick.bid[2] = adjust_price(md->BidPrice3);
-  tick.bid[3] = adjust_price(md->BidPrice4);
-  tick.bid[4] = adjust_price(md->BidPrice5);
-  tick.ask_volume[0] = md->AskVolume1;
-  tick.ask_volume[1] = md->AskVolume2;
-  tick.ask_volume[2] = md->AskVolume3;
-  tick.ask_volume[3] = md->AskVolume4;
-  tick.ask_volume[4] = md->AskVolume5;
-  tick.bid_volume[0] = md->BidVolume1;
-  tick.bid_volume[1] = md->BidVolume2;
-  tick.bid_volume[2] = md->BidVolume3;
-  tick.bid_volume[3] = md->BidVolume4;
-  tick.bid_volume[4] = md->BidVolume5;
-
-  spdlog::debug(
+  FT_LOG_DEBUG(
       "[CtpMdApi::OnRtnDepthMarketData] Ticker: {}, Time MS: {}, "
       "LastPrice: {:.2f}, Volume: {}, Turnover: {}, Open Interest: {}",
-      iter->second->ticker, tick.time_ms, tick.last_price, tick.volume,
+      contract->ticker.c_str(), tick.time_ms, tick.last_price, tick.volume,
       tick.turnover, tick.open_interest);
 
   engine_->on_tick(&tick);
@@ -15,6 +15,7 @@
 #include "Core/TickData.h"
 #include "Core/TradingEngineInterface.h"
 #include "Gateway/Ctp/CtpCommon.h"
+#include "Gateway/Ctp/CtpMdNormalizer.h"
 
 namespace ft {
 
@@ -76,6 +77,7 @@ class CtpMdApi : public CThostFtdcMdSpi {
   std::string broker_id_;
   std::string investor_id_;
   std::string passwd_;
+  ThreadPlacement thread_placement_;
 
   std::atomic<int> next_req_id_ = 0;
 
@@ -84,7 +86,7 @@ class CtpMdApi : public CThostFtdcMdSpi {
   std::atomic<bool> is_logon_ = false;
 
   std::vector<std::string> subscribed_list_;
-  std::map<std::string, const Contract *> symbol2contract_;
+  CtpMdNormalizer normalizer_;
 };
 
 }  // namespace ft
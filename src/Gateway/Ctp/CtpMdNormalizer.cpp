@@ -0,0 +1,133 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "Gateway/Ctp/CtpMdNormalizer.h"
+
+#include <algorithm>
+#include <ctime>
+
+#include "Core/ContractTable.h"
+#include "Gateway/Ctp/CtpCommon.h"
+
+namespace ft {
+
+bool SymbolIndex::insert(const std::string& symbol, const Contract* contract) {
+  // find会多读取一个字节，补齐后再生成key
+  char padded[kMaxSymbolLen + 1]{};
+  if (symbol.size() > kMaxSymbolLen) return false;
+  memcpy(padded, symbol.data(), symbol.size());
+
+  if ((size_ + 1) * 4 > entries_.size())
+    rehash(std::max<std::size_t>(16, entries_.size() * 2));
+
+  Key key;
+  make_key(padded, &key);
+  for (uint64_t i = hash(key) & mask_;; i = (i + 1) & mask_) {
+    auto& entry = entries_[i];
+    if (!entry.contract) {
+      entry.key = key;
+      entry.contract = contract;
+      ++size_;
+      return true;
+    }
+    if (entry.key.lo == key.lo && entry.key.hi == key.hi) {
+      entry.contract = contract;
+      return true;
+    }
+  }
+}
+
+void SymbolIndex::rehash(std::size_t capacity) {
+  std::vector<Entry> old_entries(capacity);
+  old_entries.swap(entries_);
+  mask_ = capacity - 1;
+
+  for (const auto& old : old_entries) {
+    if (!old.contract) continue;
+    for (uint64_t i = hash(old.key) & mask_;; i = (i + 1) & mask_) {
+      if (!entries_[i].contract) {
+        entries_[i] = old;
+        break;
+      }
+    }
+  }
+}
+
+bool CtpMdNormalizer::add_ticker(const std::string& ticker) {
+  const auto* contract = ContractTable::get_by_ticker(ticker);
+  if (!contract) return false;
+  return symbols_.insert(contract->symbol, contract);
+}
+
+const Contract* CtpMdNormalizer::normalize(
+    const CThostFtdcDepthMarketDataField& md, uint64_t recv_time,
+    TickData* tick) {
+  const auto* contract = symbols_.find(md.InstrumentID);
+  if (!contract) return nullptr;
+
+  if (recv_time >= next_refresh_time_) refresh_local_clock(recv_time);
+
+  tick->ticker_index = contract->index;
+  tick->gateway_time = recv_time;
+
+  tick->date = trading_day_ != 0 ? trading_day_ : parse_date(md.TradingDay);
+  tick->time_sec = parse_time(md.UpdateTime);
+  tick->time_ms = md.UpdateMillisec;
+  int64_t sec = natural_day_of(tick->time_sec) * kSecPerDay +
+                static_cast<int64_t>(tick->time_sec) - kUtcOffsetSec;
+  tick->exchange_time =
+      static_cast<uint64_t>(sec) * 1000000000UL + tick->time_ms * 1000000UL;
+
+  tick->volume = md.Volume;
+  tick->turnover = md.Turnover;
+  tick->open_interest = md.OpenInterest;
+  tick->last_price = adjust_price(md.LastPrice);
+  tick->open_price = adjust_price(md.OpenPrice);
+  tick->highest_price = adjust_price(md.HighestPrice);
+  tick->lowest_price = adjust_price(md.LowestPrice);
+  tick->pre_close_price = adjust_price(md.PreClosePrice);
+  tick->upper_limit_price = adjust_price(md.UpperLimitPrice);
+  tick->lower_limit_price = adjust_price(md.LowerLimitPrice);
+
+  tick->level = 5;
+  tick->ask[0] = adjust_price(md.AskPrice1);
+  tick->ask[1] = adjust_price(md.AskPrice2);
+  tick->ask[2] = adjust_price(md.AskPrice3);
+  tick->ask[3] = adjust_price(md.AskPrice4);
+  tick->ask[4] = adjust_price(md.AskPrice5);
+  tick->bid[0] = adjust_price(md.BidPrice1);
+  tick->bid[1] = adjust_price(md.BidPrice2);
+  tick->bid[2] = adjust_price(md.BidPrice3);
+  tick->bid[3] = adjust_price(md.BidPrice4);
+  tick->bid[4] = adjust_price(md.BidPrice5);
+  tick->ask_volume[0] = md.AskVolume1;
+  tick->ask_volume[1] = md.AskVolume2;
+  tick->ask_volume[2] = md.AskVolume3;
+  tick->ask_volume[3] = md.AskVolume4;
+  tick->ask_volume[4] = md.AskVolume5;
+  tick->bid_volume[0] = md.BidVolume1;
+  tick->bid_volume[1] = md.BidVolume2;
+  tick->bid_volume[2] = md.BidVolume3;
+  tick->bid_volume[3] = md.BidVolume4;
+  tick->bid_volume[4] = md.BidVolume5;
+
+  return contract;
+}
+
+void CtpMdNormalizer::refresh_local_clock(uint64_t recv_time) {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  int64_t local = ts.tv_sec + kUtcOffsetSec;
+  local_day_ = local / kSecPerDay;
+  local_sec_ = local % kSecPerDay;
+  next_refresh_time_ = recv_time + 1000000000UL;
+}
+
+int64_t CtpMdNormalizer::natural_day_of(uint64_t time_sec) const {
+  auto diff = static_cast<int64_t>(time_sec) - local_sec_;
+  // 23:59:59的行情在本地时间0点之后才处理，或者本地时钟略慢于交易所
+  if (diff > kSecPerDay / 2) return local_day_ - 1;
+  if (diff < -kSecPerDay / 2) return local_day_ + 1;
+  return local_day_;
+}
+
+}  // namespace ft
@@ -0,0 +1,174 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_GATEWAY_CTP_CTPMDNORMALIZER_H_
+#define FT_GATEWAY_CTP_CTPMDNORMALIZER_H_
+
+#include <ThostFtdcUserApiStruct.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Core/Contract.h"
+#include "Core/TickData.h"
+
+namespace ft {
+
+/*
+ * 以合约代码为key的开放寻址哈希表
+ *
+ * key固定为16字节，按两个uint64_t比较和计算哈希，CTP的合约代码（包括
+ * 期权）都不超过16个字符。订阅时一次性建好，负载不超过1/4，查找基本上
+ * 只需要一次比较，不分配内存
+ */
+class SymbolIndex {
+ public:
+  static constexpr std::size_t kMaxSymbolLen = 16;
+
+  /*
+   * 合约代码超过kMaxSymbolLen时返回false
+   */
+  bool insert(const std::string& symbol, const Contract* contract);
+
+  /*
+   * symbol后面至少要有kMaxSymbolLen + 1个字节可读，CTP结构体中的
+   * InstrumentID是31字节，满足这个条件
+   */
+  const Contract* find(const char* symbol) const {
+    Key key;
+    if (entries_.empty() || !make_key(symbol, &key)) return nullptr;
+
+    for (uint64_t i = hash(key) & mask_;; i = (i + 1) & mask_) {
+      const auto& entry = entries_[i];
+      if (!entry.contract) return nullptr;
+      if (entry.key.lo == key.lo && entry.key.hi == key.hi)
+        return entry.contract;
+    }
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  struct Key {
+    uint64_t lo;
+    uint64_t hi;
+  };
+
+  struct Entry {
+    Key key{0, 0};
+    const Contract* contract = nullptr;
+  };
+
+  /*
+   * 一次读取8个字节，用位运算找到结尾的'\0'并清掉它之后的字节
+   */
+  static bool make_key(const char* symbol, Key* key) {
+    constexpr uint64_t kOnes = 0x0101010101010101UL;
+    constexpr uint64_t kHighs = 0x8080808080808080UL;
+
+    memcpy(&key->lo, symbol, 8);
+    memcpy(&key->hi, symbol + 8, 8);
+
+    uint64_t zeros = (key->lo - kOnes) & ~key->lo & kHighs;
+    if (zeros) {
+      key->lo &= (1UL << __builtin_ctzll(zeros)) - 1;
+      key->hi = 0;
+      return true;
+    }
+
+    zeros = (key->hi - kOnes) & ~key->hi & kHighs;
+    if (zeros) {
+      key->hi &= (1UL << __builtin_ctzll(zeros)) - 1;
+      return true;
+    }
+    return symbol[kMaxSymbolLen] == '\0';
+  }
+
+  static uint64_t hash(const Key& key) {
+    uint64_t h = key.lo * 0x9E3779B97F4A7C15UL ^ key.hi * 0xC2B2AE3D27D4EB4FUL;
+    return h ^ (h >> 29);
+  }
+
+  void rehash(std::size_t capacity);
+
+ private:
+  std::vector<Entry> entries_;
+  uint64_t mask_ = 0;
+  std::size_t size_ = 0;
+};
+
+/*
+ * 把CTP的深度行情转为TickData，不分配内存，也不调用strptime这类库函数
+ *
+ * 各交易所夜盘的日期字段含义不同：大商所的ActionDay是交易日，郑商所的
+ * TradingDay是自然日，都不能直接使用。这里交易日统一取行情登录时返回的
+ * TradingDay，自然日由本地时钟推算（每秒读取一次），行情时间和本地时间
+ * 相差超过12小时说明跨越了午夜，按行情时间修正到前一天或后一天，最后和
+ * UpdateTime、UpdateMillisec合成exchange_time
+ */
+class CtpMdNormalizer {
+ public:
+  /*
+   * 订阅时调用，ticker不在合约表中时返回false
+   */
+  bool add_ticker(const std::string& ticker);
+
+  /*
+   * 行情登录成功后调用，之前收到的行情使用行情中的TradingDay
+   */
+  void set_trading_day(const char* trading_day) {
+    trading_day_ = parse_date(trading_day);
+  }
+
+  const Contract* find(const char* symbol) const {
+    return symbols_.find(symbol);
+  }
+
+  /*
+   * recv_time是收到行情时的now_ns，合约没有订阅时返回nullptr
+   */
+  const Contract* normalize(const CThostFtdcDepthMarketDataField& md,
+                            uint64_t recv_time, TickData* tick);
+
+  /*
+   * "HH:MM:SS"转为当天的秒数
+   */
+  static uint64_t parse_time(const char* s) {
+    auto num = [s](int i) { return (s[i] - '0') * 10 + (s[i + 1] - '0'); };
+    return num(0) * 3600 + num(3) * 60 + num(6);
+  }
+
+  /*
+   * "YYYYMMDD"转为整数，格式不对时返回0
+   */
+  static uint64_t parse_date(const char* s) {
+    uint64_t date = 0;
+    for (int i = 0; i < 8; ++i) {
+      if (s[i] < '0' || s[i] > '9') return 0;
+      date = date * 10 + (s[i] - '0');
+    }
+    return date;
+  }
+
+ private:
+  void refresh_local_clock(uint64_t recv_time);
+
+  int64_t natural_day_of(uint64_t time_sec) const;
+
+ private:
+  static constexpr int64_t kUtcOffsetSec = 8 * 3600;  // 交易所使用北京时间
+  static constexpr int64_t kSecPerDay = 86400;
+
+  SymbolIndex symbols_;
+  uint64_t trading_day_ = 0;
+
+  // 本地时钟的北京时间，只在行情回调线程中访问
+  int64_t local_day_ = 0;
+  int64_t local_sec_ = 0;
+  uint64_t next_refresh_time_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_GATEWAY_CTP_CTPMDNORMALIZER_H_
@@ -5,6 +5,8 @@
 #include <ThostFtdcTraderApi.h>
 #include <spdlog/spdlog.h>
 
+#include "Utils/Clock.h"
+
 namespace ft {
 
 CtpTradeApi::CtpTradeApi(TradingEngineInterface *engine) : engine_(engine) {}
@@ -29,6 +31,7 @@ bool CtpTradeApi::login(const LoginParams &params) {
   front_addr_ = params.front_addr();
   broker_id_ = params.broker_id();
   investor_id_ = params.investor_id();
+  thread_placement_ = params.trade_thread();
 
   trade_api_->SubscribePrivateTopic(THOST_TERT_QUICK);
   trade_api_->RegisterSpi(this);
@@ -143,6 +146,9 @@ void CtpTradeApi::logout() {
 }
 
 void CtpTradeApi::OnFrontConnected() {
+  pin_current_thread("ctp_trade", thread_placement_);
+  report_thread_placement(pthread_self(), "ctp_trade");
+
   spdlog::debug("[CtpTradeApi::OnFrontConnected] Success. Connected to {}",
                 front_addr_);
   is_error_ = false;
@@ -304,6 +310,8 @@ bool CtpTradeApi::send_order(const OrderReq *order) {
 void CtpTradeApi::OnRspOrderInsert(CThostFtdcInputOrderField *order,
                                    CThostFtdcRspInfoField *rsp_info, int req_id,
                                    bool is_last) {
+  uint64_t recv_time = now_ns();
+
   if (!order) {
     spdlog::warn("[CtpTradeApi::OnRspOrderInsert] nullptr");
     return;
@@ -337,12 +345,14 @@ void CtpTradeApi::OnRspOrderInsert(CThostFtdcInputOrderField *order,
         order_ref);
     return;
   }
-  engine_->on_order_rejected(iter->second.order_id);
+  engine_->on_order_rejected(iter->second.order_id, recv_time);
   id2ref_.erase(iter->second.order_id);
   order_details_.erase(iter);
 }
 
 void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
+  uint64_t recv_time = now_ns();
+
   if (!order) {
     spdlog::warn("[CtpTradeApi::OnRtnOrder] nullptr");
     return;
@@ -373,12 +383,12 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
 
   // 被拒单或撤销被拒，回调相应函数
   if (order->OrderSubmitStatus == THOST_FTDC_OSS_InsertRejected) {
-    engine_->on_order_rejected(detail.order_id);
+    engine_->on_order_rejected(detail.order_id, recv_time);
     id2ref_.erase(detail.order_id);
     order_details_.erase(iter);
     return;
   } else if (order->OrderSubmitStatus == THOST_FTDC_OSS_CancelRejected) {
-    engine_->on_order_cancel_rejected(detail.order_id);
+    engine_->on_order_cancel_rejected(detail.order_id, recv_time);
     return;
   }
 
@@ -389,7 +399,7 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
 
   // 被交易所接收，则回调on_order_accepted
   if (!detail.accepted_ack) {
-    engine_->on_order_accepted(detail.order_id);
+    engine_->on_order_accepted(detail.order_id, recv_time);
     detail.accepted_ack = true;
   }
 
@@ -400,7 +410,8 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
     // 这里是为了防止重接收到撤单回执
     if (detail.canceled_vol == 0) {
       detail.canceled_vol = order->VolumeTotalOriginal - order->VolumeTraded;
-      engine_->on_order_canceled(detail.order_id, detail.canceled_vol);
+      engine_->on_order_canceled(detail.order_id, detail.canceled_vol,
+                                  recv_time);
     }
 
     // 这里是处理撤单比回调先到的情况，如果撤单比成交回执先到，则继续等待成交回执到来
@@ -412,6 +423,8 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
 }
 
 void CtpTradeApi::OnRtnTrade(CThostFtdcTradeField *trade) {
+  uint64_t recv_time = now_ns();
+
   if (!trade) {
     spdlog::warn("[CtpTradeApi::OnRtnTrade] nullptr");
     return;
@@ -440,7 +453,8 @@ void CtpTradeApi::OnRtnTrade(CThostFtdcTradeField *trade) {
 
   auto &detail = iter->second;
   detail.traded_vol += trade->Volume;
-  engine_->on_order_traded(detail.order_id, trade->Volume, trade->Price);
+  engine_->on_order_traded(detail.order_id, trade->Volume, trade->Price,
+                           recv_time);
 
   if (detail.traded_vol + detail.canceled_vol == detail.original_vol) {
     id2ref_.erase(detail.order_id);
@@ -491,6 +505,8 @@ bool CtpTradeApi::cancel_order(uint64_t order_id) {
 void CtpTradeApi::OnRspOrderAction(CThostFtdcInputOrderActionField *action,
                                    CThostFtdcRspInfoField *rsp_info, int req_id,
                                    bool is_last) {
+  uint64_t recv_time = now_ns();
+
   if (!action) {
     spdlog::warn("[CtpTradeApi::OnRspOrderAction] nullptr");
   }
@@ -519,7 +535,7 @@ void CtpTradeApi::OnRspOrderAction(CThostFtdcInputOrderActionField *action,
         order_ref);
     return;
   }
-  engine_->on_order_cancel_rejected(iter->second.order_id);
+  engine_->on_order_cancel_rejected(iter->second.order_id, recv_time);
 }
 
 bool CtpTradeApi::query_contract(const std::string &ticker) {
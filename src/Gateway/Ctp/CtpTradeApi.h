@@ -161,6 +161,7 @@ class CtpTradeApi : public CThostFtdcTraderSpi {
   std::string front_addr_;
   std::string broker_id_;
   std::string investor_id_;
+  ThreadPlacement thread_placement_;
   int front_id_ = 0;
   int session_id_ = 0;
 
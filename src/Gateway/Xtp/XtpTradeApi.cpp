@@ -7,6 +7,7 @@
 #include <cstdlib>
 
 #include "Core/ContractTable.h"
+#include "Utils/Clock.h"
 
 namespace ft {
 
@@ -41,6 +42,8 @@ bool XtpTradeApi::login(const LoginParams& params) {
   XTP_PROTOCOL_TYPE sock_type = XTP_PROTOCOL_TCP;
   if (strcmp(protocol, "udp") == 0) sock_type = XTP_PROTOCOL_UDP;
 
+  thread_placement_ = params.trade_thread();
+
   trade_api_->SubscribePublicTopic(XTP_TERT_QUICK);
   trade_api_->RegisterSpi(this);
   trade_api_->SetSoftwareKey(params.auth_code().c_str());
@@ -121,6 +124,9 @@ bool XtpTradeApi::send_order(const OrderReq* order) {
 
 void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
                                uint64_t session_id) {
+  uint64_t recv_time = now_ns();
+  pin_callback_thread();
+
   if (!order_info) {
     spdlog::warn("[XtpTradeApi::OnOrderEvent] nullptr");
     return;
@@ -138,7 +144,7 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
   if (is_error_rsp(error_info)) {
     spdlog::error("[XtpTradeApi::OnOrderEvent] ErrorMsg: {}",
                   error_info->error_msg);
-    engine_->on_order_rejected(detail.order_id);
+    engine_->on_order_rejected(detail.order_id, recv_time);
     order_id_ft2xtp_.erase(detail.order_id);
     order_details_.erase(iter);
     return;
@@ -146,7 +152,7 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
 
   if (order_info->order_status ==
       XTP_ORDER_STATUS_TYPE::XTP_ORDER_STATUS_REJECTED) {
-    engine_->on_order_rejected(detail.order_id);
+    engine_->on_order_rejected(detail.order_id, recv_time);
     return;
   }
 
@@ -155,7 +161,7 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
     return;
 
   if (!detail.accepted_ack) {
-    engine_->on_order_accepted(detail.order_id);
+    engine_->on_order_accepted(detail.order_id, recv_time);
     detail.accepted_ack = true;
   }
 
@@ -165,7 +171,8 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
           XTP_ORDER_STATUS_TYPE::XTP_ORDER_STATUS_PARTTRADEDNOTQUEUEING) {
     if (detail.canceled_vol == 0) {
       detail.canceled_vol = order_info->qty_left;
-      engine_->on_order_canceled(detail.order_id, detail.canceled_vol);
+      engine_->on_order_canceled(detail.order_id, detail.canceled_vol,
+                                  recv_time);
 
       if (detail.canceled_vol + detail.traded_vol == detail.original_vol) {
         order_id_ft2xtp_.erase(detail.order_id);
@@ -177,6 +184,9 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
 
 void XtpTradeApi::OnTradeEvent(XTPTradeReport* trade_info,
                                uint64_t session_id) {
+  uint64_t recv_time = now_ns();
+  pin_callback_thread();
+
   if (!trade_info) {
     spdlog::warn("[XtpTradeApi::OnTradeEvent] nullptr");
     return;
@@ -193,7 +203,7 @@ void XtpTradeApi::OnTradeEvent(XTPTradeReport* trade_info,
   auto& detail = iter->second;
   detail.traded_vol += trade_info->trade_amount;
   engine_->on_order_traded(detail.order_id, trade_info->trade_amount,
-                           trade_info->price);
+                           trade_info->price, recv_time);
 
   if (detail.traded_vol += detail.canceled_vol == detail.original_vol) {
     order_id_ft2xtp_.erase(detail.order_id);
@@ -227,6 +237,9 @@ bool XtpTradeApi::cancel_order(uint64_t order_id) {
 
 void XtpTradeApi::OnCancelOrderError(XTPOrderCancelInfo* cancel_info,
                                      XTPRI* error_info, uint64_t session_id) {
+  uint64_t recv_time = now_ns();
+  pin_callback_thread();
+
   if (!is_error_rsp(error_info)) return;
 
   if (!cancel_info) {
@@ -246,7 +259,7 @@ void XtpTradeApi::OnCancelOrderError(XTPOrderCancelInfo* cancel_info,
 
   spdlog::error("[XtpTradeApi::OnCancelOrderError] Cancel error. ErrorMsg: {}",
                 error_info->error_msg);
-  engine_->on_order_cancel_rejected(detail.order_id);
+  engine_->on_order_cancel_rejected(detail.order_id, recv_time);
 }
 
 bool XtpTradeApi::query_position(const std::string& ticker) {
@@ -268,6 +281,8 @@ bool XtpTradeApi::query_positions() { return query_position(""); }
 void XtpTradeApi::OnQueryPosition(XTPQueryStkPositionRsp* position,
                                   XTPRI* error_info, int request_id,
                                   bool is_last, uint64_t session_id) {
+  pin_callback_thread();
+
   if (is_error_rsp(error_info)) {
     spdlog::error(
         "[CtpTradeApi::OnRspQryInvestorPosition] Failed. Error Msg: {}",
@@ -64,6 +64,16 @@ class XtpTradeApi : public XTP::API::TraderSpi {
 
   void reset_sync() { is_done_ = false; }
 
+  /*
+   * XTP没有连接成功的回调，在回调线程第一次被调用时设置它的位置
+   */
+  void pin_callback_thread() {
+    if (is_thread_pinned_) return;
+    is_thread_pinned_ = true;
+    pin_current_thread("xtp_trade", thread_placement_);
+    report_thread_placement(pthread_self(), "xtp_trade");
+  }
+
   bool wait_sync() {
     while (!is_done_)
       if (is_error_) return false;
@@ -85,6 +95,8 @@ class XtpTradeApi : public XTP::API::TraderSpi {
   std::unique_ptr<XTP::API::TraderApi, XtpApiDeleter> trade_api_;
 
   uint64_t session_id_ = 0;
+  ThreadPlacement thread_placement_;
+  bool is_thread_pinned_ = false;  // 只在回调线程中访问
   std::atomic<uint32_t> next_client_order_id_ = 1;
   std::atomic<uint32_t> next_req_id_ = 1;
 
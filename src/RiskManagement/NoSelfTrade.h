@@ -1,66 +1,133 @@
 // Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
 
-#ifndef FT_INCLUDE_RISKMANAGEMENT_NOSELFTRADE_H_
-#define FT_INCLUDE_RISKMANAGEMENT_NOSELFTRADE_H_
+#ifndef FT_SRC_RISKMANAGEMENT_NOSELFTRADE_H_
+#define FT_SRC_RISKMANAGEMENT_NOSELFTRADE_H_
 
 #include <spdlog/spdlog.h>
 
-#include <string>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
-#include "ContractTable.h"
-#include "RiskManagement/RiskRuleInterface.h"
+#include "Core/Constants.h"
+#include "Core/ContractTable.h"
+#include "RiskManagement/RiskRule.h"
 
 namespace ft {
 
-// 拦截自成交订单，检查相反方向的挂单
-// 1. 市价单
-// 2. 非市价单的其他订单，且价格可以成功撮合的
-class NoSelfTradeRule : public RiskRuleInterface {
+/*
+ * 拦截自成交订单，检查相反方向的挂单
+ * 1. 任意一方是市价单
+ * 2. 都是限价单，且价格可以成功撮合
+ *
+ * 每个合约的每个方向记录挂单和最优价（买方最高价、卖方最低价），检查时
+ * 只需要和对手方的最优价比较。最优价的挂单结束时才重新计算一次
+ */
+class NoSelfTradeRule : public RiskRule {
  public:
-  explicit NoSelfTradeRule(const TradingPanel* panel) : panel_(panel) {}
+  NoSelfTradeRule() : books_(ContractTable::size() + 1) {}
 
-  bool check(const OrderReq* order) override {
-    const auto* contract = ContractTable::get_by_index(order->ticker_index);
-    assert(contract);
+  bool check(const OrderReq& req, uint64_t now) {
+    if (!is_buy_or_sell(req.direction) || req.ticker_index >= books_.size())
+      return true;
 
-    uint64_t opp_d = opp_direction(order->direction);  // 对手方
-    const Order* pending_order;
-    std::vector<const Order*> order_list;
-    panel_->get_order_list(&order_list, contract->ticker);
+    const auto& opp = side_of(req.ticker_index, opp_direction(req.direction));
+    if (opp.num_market == 0 && opp.limits.empty()) return true;
 
-    for (auto p : order_list) {
-      pending_order = p;
-      if (pending_order->direction != opp_d) continue;
+    bool is_crossed = req.type == OrderType::MARKET || opp.num_market > 0;
+    if (!is_crossed && req.direction == Direction::BUY)
+      is_crossed = req.price >= opp.best_price - 1e-5;
+    else if (!is_crossed)
+      is_crossed = req.price <= opp.best_price + 1e-5;
+    if (!is_crossed) return true;
 
-      // 存在市价单直接拒绝
-      if (pending_order->type == OrderType::MARKET) goto catch_order;
+    spdlog::error(
+        "[NoSelfTradeRule::check] Self trade! TickerIndex: {}. This Order: "
+        "[Direction: {}, Type: {}, Price: {:.2f}]. Opposite pending orders: "
+        "[Market: {}, Best price: {:.2f}]",
+        req.ticker_index, direction_str(req.direction),
+        ordertype_str(req.type), req.price, opp.num_market, opp.best_price);
+    return false;
+  }
 
-      if (order->direction == Direction::BUY) {
-        if (order->price >= pending_order->price + 1e-5) goto catch_order;
-      } else {
-        if (order->price <= pending_order->price - 1e-5) goto catch_order;
-      }
+  void on_check_passed(const OrderReq& req, uint64_t now) {
+    if (!is_buy_or_sell(req.direction) || req.ticker_index >= books_.size())
+      return;
+
+    auto& side = side_of(req.ticker_index, req.direction);
+    if (req.type == OrderType::MARKET) {
+      ++side.num_market;
+      return;
     }
 
-    return true;
+    if (side.limits.empty() ||
+        is_better(req.direction, req.price, side.best_price))
+      side.best_price = req.price;
+    side.limits.push_back({req.order_id, req.price});
+  }
 
-  catch_order:
-    spdlog::error(
-        "[RiskMgr] Self trade! Ticker: {}. This Order: "
-        "[Direction: {}, Type: {}, Price: {:.2f}]. "
-        "Pending Order: [Direction: {}, Type: {}, Price: {:.2f}]",
-        contract->ticker, direction_str(order->direction),
-        ordertype_str(order->type), order->price,
-        direction_str(pending_order->direction),
-        ordertype_str(pending_order->type), pending_order->price);
-    return false;
+  void on_order_completed(const OrderReq& req) {
+    if (!is_buy_or_sell(req.direction) || req.ticker_index >= books_.size())
+      return;
+
+    auto& side = side_of(req.ticker_index, req.direction);
+    if (req.type == OrderType::MARKET) {
+      if (side.num_market > 0) --side.num_market;
+      return;
+    }
+
+    auto& limits = side.limits;
+    auto iter =
+        std::find_if(limits.begin(), limits.end(),
+                     [&](const auto& p) { return p.order_id == req.order_id; });
+    if (iter == limits.end()) return;
+
+    double price = iter->price;
+    *iter = limits.back();
+    limits.pop_back();
+
+    if (price != side.best_price || limits.empty()) return;
+    side.best_price = limits.front().price;
+    for (const auto& pending : limits) {
+      if (is_better(req.direction, pending.price, side.best_price))
+        side.best_price = pending.price;
+    }
+  }
+
+ private:
+  struct Pending {
+    uint64_t order_id;
+    double price;
+  };
+
+  struct Side {
+    uint32_t num_market = 0;
+    double best_price = 0;
+    std::vector<Pending> limits;
+  };
+
+  struct Book {
+    Side buy;
+    Side sell;
+  };
+
+  static bool is_buy_or_sell(uint64_t direction) {
+    return direction == Direction::BUY || direction == Direction::SELL;
+  }
+
+  static bool is_better(uint64_t direction, double price, double best) {
+    return direction == Direction::BUY ? price > best : price < best;
+  }
+
+  Side& side_of(uint64_t ticker_index, uint64_t direction) {
+    auto& book = books_[ticker_index];
+    return direction == Direction::BUY ? book.buy : book.sell;
   }
 
  private:
-  const TradingPanel* panel_;
+  std::vector<Book> books_;  // 以ticker_index为下标
 };
 
 }  // namespace ft
 
-#endif  // FT_INCLUDE_RISKMANAGEMENT_NOSELFTRADE_H_
+#endif  // FT_SRC_RISKMANAGEMENT_NOSELFTRADE_H_
@@ -0,0 +1,69 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_RISKMANAGEMENT_ORDERSIZELIMIT_H_
+#define FT_SRC_RISKMANAGEMENT_ORDERSIZELIMIT_H_
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "Core/Constants.h"
+#include "Core/ContractTable.h"
+#include "RiskManagement/RiskRule.h"
+
+namespace ft {
+
+/*
+ * 单笔订单的数量必须在合约规定的范围内（上限为0表示不限制）
+ * 构造时从ContractTable取出每个合约的限制，检查时直接按ticker_index索引
+ */
+class OrderSizeLimit : public RiskRule {
+ public:
+  OrderSizeLimit() : limits_(ContractTable::size() + 1) {
+    for (uint64_t i = 1; i <= ContractTable::size(); ++i) {
+      const auto* contract = ContractTable::get_by_index(i);
+      limits_[i] = {contract->min_limit_order_volume,
+                    contract->max_limit_order_volume,
+                    contract->min_market_order_volume,
+                    contract->max_market_order_volume};
+    }
+  }
+
+  bool check(const OrderReq& req, uint64_t now) {
+    if (req.ticker_index >= limits_.size() || req.volume <= 0) {
+      spdlog::error("[OrderSizeLimit::check] Invalid order. Volume: {}",
+                    req.volume);
+      return false;
+    }
+
+    const auto& limit = limits_[req.ticker_index];
+    bool is_market = req.type == OrderType::MARKET;
+    int64_t min_volume = is_market ? limit.min_market : limit.min_limit;
+    int64_t max_volume = is_market ? limit.max_market : limit.max_limit;
+    if (req.volume < min_volume ||
+        (max_volume > 0 && req.volume > max_volume)) {
+      spdlog::error(
+          "[OrderSizeLimit::check] Volume out of range. Volume: {}, "
+          "Range: [{}, {}]",
+          req.volume, min_volume, max_volume);
+      return false;
+    }
+
+    return true;
+  }
+
+ private:
+  struct Limit {
+    int64_t min_limit = 0;
+    int64_t max_limit = 0;
+    int64_t min_market = 0;
+    int64_t max_market = 0;
+  };
+
+  std::vector<Limit> limits_;  // 以ticker_index为下标
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_RISKMANAGEMENT_ORDERSIZELIMIT_H_
@@ -16,6 +16,8 @@ bool RiskManager::check_order_req(const OrderReq* order) {
   return true;
 }
 
+void RiskManager::on_order_sent(uint64_t order_id) {}
+
 void RiskManager::on_order_traded(uint64_t order_id, int64_t this_traded,
                                   double traded_price) {}
 
@@ -0,0 +1,43 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_RISKMANAGEMENT_RISKRULE_H_
+#define FT_SRC_RISKMANAGEMENT_RISKRULE_H_
+
+#include <cstdint>
+
+#include "Core/Protocol.h"
+
+namespace ft {
+
+/*
+ * RiskRuleChain中规则的基类，提供默认的空实现
+ *
+ * 规则不是虚函数，派生类直接隐藏需要的函数即可，由RiskRuleChain在编译期
+ * 组合起来，调用可以被内联
+ *
+ * check只做检查，不修改状态；整条规则链都通过后才回调on_check_passed，
+ * 需要计数的规则在这里更新状态。now是本次检查的时间（now_ns），只有链上
+ * 有规则把kUseTime设为true时才会取时间，否则为0
+ */
+class RiskRule {
+ public:
+  static constexpr bool kUseTime = false;
+
+  bool check(const OrderReq& req, uint64_t now) { return true; }
+
+  void on_check_passed(const OrderReq& req, uint64_t now) {}
+
+  void on_order_sent(const OrderReq& req) {}
+
+  void on_order_traded(const OrderReq& req, int64_t this_traded,
+                       double traded_price) {}
+
+  /*
+   * 订单结束（全部成交、撤单、被拒或整批未执行）时回调
+   */
+  void on_order_completed(const OrderReq& req) {}
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_RISKMANAGEMENT_RISKRULE_H_
@@ -0,0 +1,118 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_RISKMANAGEMENT_RISKRULECHAIN_H_
+#define FT_SRC_RISKMANAGEMENT_RISKRULECHAIN_H_
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Core/RiskManagementInterface.h"
+#include "RiskManagement/RiskRule.h"
+#include "Utils/Clock.h"
+
+namespace ft {
+
+/*
+ * 编译期组合的规则链，按模板参数的顺序检查，任意一个规则不通过则拦截
+ *
+ * 引擎只通过RiskManagementInterface做一次虚函数调用，链上的规则都是
+ * 普通的成员函数调用。通过检查的订单按order_id保存在预分配的槽位中，
+ * 之后的回报只带order_id，从槽位中取回订单交给各个规则
+ */
+template <class... Rules>
+class RiskRuleChain : public RiskManagementInterface {
+ public:
+  explicit RiskRuleChain(Rules... rules, std::size_t capacity = 65536)
+      : rules_(std::move(rules)...) {
+    std::size_t size = 1;
+    while (size < capacity) size <<= 1;
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  bool check_order_req(const OrderReq* req) override {
+    uint64_t now = 0;
+    if constexpr ((Rules::kUseTime || ...)) now = now_ns();
+
+    // 槽位还被占用说明有订单一直没有结束，先让各个规则释放它的状态，
+    // 否则覆盖之后再也没有机会释放
+    auto& slot = slots_[req->order_id & mask_];
+    if (slot.is_used) {
+      spdlog::error(
+          "[RiskRuleChain::check_order_req] Slot is still used by order {}. "
+          "Complete it",
+          slot.req.order_id);
+      std::apply(
+          [&](auto&... rule) { (rule.on_order_completed(slot.req), ...); },
+          rules_);
+      slot.is_used = false;
+    }
+
+    bool is_passed = std::apply(
+        [&](auto&... rule) { return (rule.check(*req, now) && ...); }, rules_);
+    if (!is_passed) return false;
+
+    std::apply([&](auto&... rule) { (rule.on_check_passed(*req, now), ...); },
+               rules_);
+
+    slot.req = *req;
+    slot.is_used = true;
+    return true;
+  }
+
+  void on_order_sent(uint64_t order_id) override {
+    const auto* req = find(order_id);
+    if (!req) return;
+    std::apply([&](auto&... rule) { (rule.on_order_sent(*req), ...); },
+               rules_);
+  }
+
+  void on_order_traded(uint64_t order_id, int64_t this_traded,
+                       double traded_price) override {
+    const auto* req = find(order_id);
+    if (!req) return;
+    std::apply(
+        [&](auto&... rule) {
+          (rule.on_order_traded(*req, this_traded, traded_price), ...);
+        },
+        rules_);
+  }
+
+  void on_order_completed(uint64_t order_id) override {
+    const auto* req = find(order_id);
+    if (!req) return;
+    std::apply([&](auto&... rule) { (rule.on_order_completed(*req), ...); },
+               rules_);
+    slots_[order_id & mask_].is_used = false;
+  }
+
+  template <std::size_t I>
+  auto& rule() {
+    return std::get<I>(rules_);
+  }
+
+ private:
+  struct Slot {
+    OrderReq req;
+    bool is_used = false;
+  };
+
+  const OrderReq* find(uint64_t order_id) const {
+    const auto& slot = slots_[order_id & mask_];
+    if (!slot.is_used || slot.req.order_id != order_id) return nullptr;
+    return &slot.req;
+  }
+
+ private:
+  std::tuple<Rules...> rules_;
+  std::vector<Slot> slots_;
+  uint64_t mask_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_RISKMANAGEMENT_RISKRULECHAIN_H_
@@ -1,93 +1,187 @@
 // Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
 
-#ifndef FT_INCLUDE_RISKMANAGEMENT_VELOCITYLIMIT_H_
-#define FT_INCLUDE_RISKMANAGEMENT_VELOCITYLIMIT_H_
+#ifndef FT_SRC_RISKMANAGEMENT_VELOCITYLIMIT_H_
+#define FT_SRC_RISKMANAGEMENT_VELOCITYLIMIT_H_
 
 #include <spdlog/spdlog.h>
 
-#include <list>
-#include <string>
-#include <utility>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
 
-#include "Base/Order.h"
-#include "RiskManagement/RiskRuleInterface.h"
+#include "RiskManagement/RiskRule.h"
 
 namespace ft {
 
-inline uint64_t get_current_ms() {
-  timespec ts;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  return ts.tv_nsec / 1000000 + ts.tv_sec * 1000;
-}
-
-class VelocityLimit : public RiskRuleInterface {
+/*
+ * 限制period_ms内的订单数和下单量，limit为0表示不限制
+ *
+ * 订单数用大小为order_limit的环形缓冲区记录最近order_limit个订单的时间，
+ * 缓冲区满且最早的一个仍在period内时拒绝，检查是O(1)的且不分配内存
+ * 下单量用令牌桶近似：桶的容量为volume_limit，每period_ms匀速补满一次
+ *
+ * 通过检查但没有发出的订单（整批回滚、发送失败）结束时退还占用的次数和
+ * 下单量。这些订单总是最近通过检查的几个，记录在unsent_中，和环形缓冲区
+ * 中最后写入的几个时间一一对应
+ */
+class VelocityLimit : public RiskRule {
  public:
+  static constexpr bool kUseTime = true;
+
   VelocityLimit(uint64_t period_ms, uint64_t order_limit, uint64_t volume_limit)
-      : period_ms_(period_ms),
-        order_limit_(order_limit),
-        volume_limit_(volume_limit) {}
+      : period_ns_(period_ms * 1000000UL),
+        order_limit_(period_ms > 0 ? order_limit : 0),
+        volume_limit_(period_ms > 0 ? volume_limit : 0),
+        order_times_(order_limit_),
+        volume_tokens_(volume_limit_),
+        volume_per_ns_(period_ms > 0 ? static_cast<double>(volume_limit_) /
+                                           period_ns_
+                                     : 0) {}
+
+  bool check(const OrderReq& req, uint64_t now) {
+    if (order_limit_ > 0 && num_orders_ == order_limit_ &&
+        now - order_times_[oldest_] < period_ns_) {
+      spdlog::error(
+          "[VelocityLimit::check] Order num reached limit within {} ms. "
+          "Limit: {}",
+          period_ns_ / 1000000UL, order_limit_);
+      return false;
+    }
 
-  // 返回false则拦截订单
-  bool check(const Order* order) {
-    if (order_limit_ == 0 && volume_limit_ == 0 || period_ms_ == 0) return true;
+    if (volume_limit_ > 0) {
+      refill(now);
+      if (volume_tokens_ < req.volume) {
+        spdlog::error(
+            "[VelocityLimit::check] Volume reached limit within {} ms. "
+            "This Order: {}, Available: {:.0f}, Limit: {}",
+            period_ns_ / 1000000UL, req.volume, volume_tokens_,
+            volume_limit_);
+        return false;
+      }
+    }
 
-    uint64_t current_ms = get_current_ms();
-    uint64_t lower_bound_ms = current_ms - period_ms_;
+    return true;
+  }
+
+  void on_check_passed(const OrderReq& req, uint64_t now) {
+    // 正常情况下不会超过一个批次，超出时最早的一个不再退还
+    if (num_unsent_ == unsent_.size() ||
+        (order_limit_ > 0 && num_unsent_ == order_limit_))
+      forget_unsent(1);
+
+    auto& unsent = unsent_[num_unsent_++];
+    unsent.order_id = req.order_id;
+    unsent.volume = req.volume;
+    unsent.is_evicted = false;
 
     if (order_limit_ > 0) {
-      for (auto iter = order_tm_record_.begin();
-           iter != order_tm_record_.end();) {
-        if (*iter > lower_bound_ms) break;
-        --order_count_;
-        iter = order_tm_record_.erase(iter);
+      // 缓冲区满时oldest_即是下一个写入的位置，覆盖的时间留着退还时恢复
+      if (num_orders_ == order_limit_) {
+        unsent.evicted = order_times_[oldest_];
+        unsent.is_evicted = true;
       }
+      order_times_[oldest_] = now;
+      if (++oldest_ == order_limit_) oldest_ = 0;
+      num_orders_ = std::min(num_orders_ + 1, order_limit_);
+    }
 
-      if (order_count_ + 1 > order_limit_) {
-        spdlog::error(
-            "[VelocityLimit::check] Order num reached limit within {} ms. "
-            "Current: {}, Limit: {}",
-            period_ms_, order_count_, order_limit_);
-        return false;
+    if (volume_limit_ > 0) volume_tokens_ -= req.volume;
+  }
+
+  void on_order_sent(const OrderReq& req) {
+    // 同一批次的订单按检查的顺序发送，之前的订单都已经发出或者退还
+    for (std::size_t i = 0; i < num_unsent_; ++i) {
+      if (unsent_[i].order_id == req.order_id) {
+        forget_unsent(i + 1);
+        return;
       }
+    }
+  }
 
-      ++order_count_;
-      order_tm_record_.emplace_back(current_ms);
+  void on_order_completed(const OrderReq& req) {
+    for (std::size_t i = 0; i < num_unsent_; ++i) {
+      if (unsent_[i].order_id == req.order_id) {
+        refund(i);
+        return;
+      }
     }
+  }
 
+ private:
+  struct Unsent {
+    uint64_t order_id;
+    int64_t volume;
+    // 写入这个位置时覆盖的时间，属于位置而不是订单
+    uint64_t evicted;
+    bool is_evicted;
+  };
+
+  /*
+   * 之后的订单在环形缓冲区中前移一位，最后一次写入覆盖的时间放回原处，
+   * 相当于这个订单没有通过过检查
+   */
+  void refund(std::size_t i) {
     if (volume_limit_ > 0) {
-      for (auto iter = volume_tm_record_.begin();
-           iter != volume_tm_record_.end();) {
-        if (iter->first > lower_bound_ms) break;
-        volume_count_ -= iter->second;
-        iter = volume_tm_record_.erase(iter);
-      }
+      volume_tokens_ = std::min(volume_tokens_ + unsent_[i].volume,
+                                static_cast<double>(volume_limit_));
+    }
 
-      if (volume_count_ + order->volume > volume_limit_) {
-        spdlog::error(
-            "[VelocityLimit::check] Volume reach limit within {} ms. "
-            "This Order: {}, Current: {}, Limit: {}",
-            period_ms_, order->volume, volume_count_, volume_limit_);
-        return false;
+    if (order_limit_ > 0) {
+      uint64_t pos = (oldest_ + order_limit_ - num_unsent_ + i) % order_limit_;
+      for (std::size_t j = i + 1; j < num_unsent_; ++j) {
+        uint64_t next = pos + 1 == order_limit_ ? 0 : pos + 1;
+        order_times_[pos] = order_times_[next];
+        pos = next;
       }
+      oldest_ = pos;
 
-      volume_count_ += order->volume;
-      volume_tm_record_.emplace_back(std::pair{current_ms, order->volume});
+      const auto& last = unsent_[num_unsent_ - 1];
+      if (last.is_evicted)
+        order_times_[pos] = last.evicted;
+      else
+        --num_orders_;
     }
 
-    return true;
+    for (std::size_t j = i; j + 1 < num_unsent_; ++j) {
+      unsent_[j].order_id = unsent_[j + 1].order_id;
+      unsent_[j].volume = unsent_[j + 1].volume;
+    }
+    --num_unsent_;
+  }
+
+  void forget_unsent(std::size_t count) {
+    std::copy(unsent_.begin() + count, unsent_.begin() + num_unsent_,
+              unsent_.begin());
+    num_unsent_ -= count;
+  }
+
+  void refill(uint64_t now) {
+    if (now <= last_refill_time_) return;
+
+    double refilled = (now - last_refill_time_) * volume_per_ns_;
+    volume_tokens_ = std::min(volume_tokens_ + refilled,
+                              static_cast<double>(volume_limit_));
+    last_refill_time_ = now;
   }
 
  private:
-  uint64_t order_limit_ = 0;
-  uint64_t volume_limit_ = 0;
-  uint64_t period_ms_ = 0;
-
-  uint64_t order_count_ = 0;
-  uint64_t volume_count_ = 0;
-  std::list<uint64_t> order_tm_record_;
-  std::list<std::pair<uint64_t, int64_t>> volume_tm_record_;
+  uint64_t period_ns_;
+  uint64_t order_limit_;
+  uint64_t volume_limit_;
+
+  std::vector<uint64_t> order_times_;
+  uint64_t oldest_ = 0;
+  uint64_t num_orders_ = 0;
+
+  double volume_tokens_;
+  double volume_per_ns_;
+  uint64_t last_refill_time_ = 0;
+
+  std::array<Unsent, kMaxCmdBatchSize> unsent_;
+  std::size_t num_unsent_ = 0;
 };
 
 }  // namespace ft
 
-#endif  // FT_INCLUDE_RISKMANAGEMENT_VELOCITYLIMIT_H_
+#endif  // FT_SRC_RISKMANAGEMENT_VELOCITYLIMIT_H_
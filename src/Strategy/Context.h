@@ -4,79 +4,252 @@
 #define FT_STRATEGY_CONTEXT_H_
 
 #include <algorithm>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Core/Constants.h"
 #include "Core/ContractTable.h"
 #include "Core/Position.h"
 #include "Core/Protocol.h"
+#include "Core/WireFormat.h"
+#include "IPC/doorbell.h"
+#include "IPC/file_lock.h"
 #include "IPC/redis.h"
+#include "IPC/shm.h"
+#include "Utils/Clock.h"
+#include "Utils/DeferredLog.h"
+#include "Utils/LatencyRecorder.h"
 
 namespace ft {
 
 class PositionHelper {
  public:
-  PositionHelper() : redis_("127.0.0.1", 6379) {}
+  PositionHelper() {}
+
+  /*
+   * 设置仓位的获取方式，需要和引擎保持一致
+   */
+  bool set_transport(IpcTransport transport) {
+    if (transport == IpcTransport::SHM) {
+      if (!pos_shm_.open(POSITION_SHM_NAME, false)) {
+        spdlog::error("[PositionHelper::set_transport] Failed to open shm");
+        return false;
+      }
+      pos_table_ = pos_shm_.get();
+    } else {
+      pos_table_ = nullptr;
+    }
+
+    return true;
+  }
 
   Position get_position(const std::string& ticker) const {
-    Position pos;
+    Position pos{};
 
-    auto reply = redis_.get(fmt::format("pos-{}", ticker));
+    if (pos_table_) {
+      const auto* contract = ContractTable::get_by_ticker(ticker);
+      if (!contract || contract->index >= kMaxTickers) return pos;
+      return pos_table_->positions[contract->index].load();
+    }
+
+    auto reply = redis()->get(proto_pos_key(ticker));
     if (reply->len == 0) return pos;
 
-    memcpy(&pos, reply->str, sizeof(pos));
+    WireView<Position> view(reply->str, reply->len);
+    if (view.is_valid() && view.count() > 0) pos = view[0];
     return pos;
   }
 
   double get_realized_pnl() const {
-    auto reply = redis_.get("realized_pnl");
+    if (pos_table_) return pos_table_->realized_pnl.load();
+
+    auto reply = redis()->get("realized_pnl");
     if (reply->len == 0) return 0;
     return *reinterpret_cast<double*>(reply->str);
   }
 
   double get_float_pnl() const {
-    auto reply = redis_.get("float_pnl");
+    if (pos_table_) return pos_table_->float_pnl.load();
+
+    auto reply = redis()->get("float_pnl");
     if (reply->len == 0) return 0;
     return *reinterpret_cast<double*>(reply->str);
   }
 
  private:
-  RedisSession redis_;
+  RedisSession* redis() const {
+    if (!redis_) redis_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+    return redis_.get();
+  }
+
+ private:
+  mutable std::unique_ptr<RedisSession> redis_;
+  ShmSegment<PositionTable> pos_shm_;
+  const PositionTable* pos_table_ = nullptr;
 };
 
 class AlgoTradeContext {
  public:
-  AlgoTradeContext() : cmd_redis_("127.0.0.1", 6379) {}
+  using CmdHandler =
+      std::function<void(const TraderCommand* cmds, uint32_t count)>;
 
-  void buy_open(const std::string& ticker, int volume, double price,
-                uint64_t type = OrderType::FAK) {
-    send_order(ticker, volume, Direction::BUY, Offset::OPEN, type, price);
+  AlgoTradeContext() {}
+
+  /*
+   * 设置交易指令的传输方式，需要和引擎保持一致
+   * strategy_id在所有同时运行的策略中必须唯一
+   */
+  bool set_cmd_transport(IpcTransport transport, uint32_t strategy_id) {
+    if (!claim_strategy_id(strategy_id)) return false;
+
+    cmd_transport_ = transport;
+    if (transport == IpcTransport::SHM &&
+        !cmd_shm_.open(TRADER_CMD_SHM_NAME, false)) {
+      spdlog::error(
+          "[AlgoTradeContext::set_cmd_transport] Failed to open shm of trader "
+          "cmd");
+      return false;
+    }
+
+    // 引擎还没启动时会打开失败，之后唤醒引擎时再重试
+    if (transport == IpcTransport::SHM)
+      cmd_doorbell_.open_writer(TRADER_CMD_DOORBELL_PATH);
+
+    open_order_view();
+    return true;
   }
 
-  void buy_close(const std::string& ticker, int volume, double price,
-                 uint64_t type = OrderType::FAK) {
-    send_order(ticker, volume, Direction::BUY, Offset::CLOSE_TODAY, type,
-               price);
+  /*
+   * 策略运行在引擎进程内时使用，交易指令不经过任何传输，直接交给引擎提供
+   * 的handler处理
+   */
+  bool set_cmd_handler(uint32_t strategy_id, CmdHandler handler) {
+    if (!claim_strategy_id(strategy_id)) return false;
+
+    cmd_handler_ = std::move(handler);
+    open_order_view();
+    return true;
+  }
+
+  /*
+   * 下单函数返回client_order_id，订单回报（OrderEvent）中会带上这个id
+   * 批次已满时指令不会加入批次，返回0
+   */
+  uint64_t buy_open(const std::string& ticker, int volume, double price,
+                    uint64_t type = OrderType::FAK) {
+    return send_order(ticker, volume, Direction::BUY, Offset::OPEN, type,
+                      price);
   }
 
-  void sell_open(const std::string& ticker, int volume, double price,
-                 uint64_t type = OrderType::FAK) {
-    send_order(ticker, volume, Direction::SELL, Offset::OPEN, type, price);
+  uint64_t buy_close(const std::string& ticker, int volume, double price,
+                     uint64_t type = OrderType::FAK) {
+    return send_order(ticker, volume, Direction::BUY, Offset::CLOSE_TODAY,
+                      type, price);
   }
 
-  void sell_close(const std::string& ticker, int volume, double price,
-                  uint64_t type = OrderType::FAK) {
-    send_order(ticker, volume, Direction::SELL, Offset::CLOSE_TODAY, type,
-               price);
+  uint64_t sell_open(const std::string& ticker, int volume, double price,
+                     uint64_t type = OrderType::FAK) {
+    return send_order(ticker, volume, Direction::SELL, Offset::OPEN, type,
+                      price);
   }
 
-  void cancel_order(uint64_t order_id) {
+  uint64_t sell_close(const std::string& ticker, int volume, double price,
+                      uint64_t type = OrderType::FAK) {
+    return send_order(ticker, volume, Direction::SELL, Offset::CLOSE_TODAY,
+                      type, price);
+  }
+
+  /*
+   * order_id是引擎分配的订单号，从订单回报中获得。批次已满时返回false
+   */
+  bool cancel_order(uint64_t order_id) {
     TraderCommand cmd{};
     cmd.magic = TRADER_CMD_MAGIC;
     cmd.type = CANCEL_ORDER;
     cmd.cancel_req.order_id = order_id;
-    cmd_redis_.publish(TRADER_CMD_TOPIC, &cmd, sizeof(cmd));
+    return send_cmd(&cmd);
+  }
+
+  /*
+   * 本策略当前未结束的订单，直接读取引擎写入的共享内存，不需要和引擎交互
+   * 刚发出的指令在引擎处理之前不会出现在这里
+   */
+  std::vector<OpenOrder> get_open_orders() const {
+    std::vector<OpenOrder> orders;
+    if (open_orders_) {
+      open_orders_->for_each(
+          [&](const OpenOrder& order) { orders.emplace_back(order); });
+    }
+    return orders;
+  }
+
+  /*
+   * 撤销本策略在ticker上的所有挂单，ticker为空时撤销本策略的所有挂单
+   * 和CANCEL_TICKER/CANCEL_ALL不同，不会影响其他策略的订单
+   *
+   * 在调用者的批次中执行时，批次满了之后的撤单不会发出，返回false。否则
+   * 只有撤单的批次不需要原子执行，满了就先提交
+   */
+  bool cancel_open_orders(const std::string& ticker = "") {
+    if (!open_orders_) return true;
+
+    uint64_t ticker_index = 0;
+    if (!ticker.empty()) {
+      const auto* contract = ContractTable::get_by_ticker(ticker);
+      if (!contract) return false;
+      ticker_index = contract->index;
+    }
+
+    bool is_batching = is_batching_;
+    bool is_all_sent = true;
+    if (!is_batching) begin_batch();
+    open_orders_->for_each([&](const OpenOrder& order) {
+      if (ticker_index != 0 && order.ticker_index != ticker_index) return;
+      if (cancel_order(order.order_id)) return;
+      if (is_batching) {
+        is_all_sent = false;
+        return;
+      }
+      commit();
+      begin_batch();
+      cancel_order(order.order_id);
+    });
+    if (!is_batching) commit();
+    return is_all_sent;
+  }
+
+  /*
+   * 开始一个批次，之后的下单和撤单指令先缓存起来，commit时一次性发给引擎
+   * 引擎对整个批次只做一次风控检查，任意一个新订单不通过则整批都不执行，
+   * 可用于撤单+下单这类需要原子执行的改单操作。一个批次最多
+   * kMaxCmdBatchSize条指令，超出的指令不会加入批次，也不会拆成多个批次
+   */
+  void begin_batch() {
+    is_batching_ = true;
+    batch_size_ = 0;
+  }
+
+  void commit() {
+    is_batching_ = false;
+    if (batch_size_ == 0) return;
+
+    uint64_t send_time = now_ns();
+    for (uint32_t i = 0; i < batch_size_; ++i) {
+      batch_[i].batch_size = batch_size_;
+      batch_[i].send_time = send_time;
+    }
+    deliver(batch_, batch_size_);
+    batch_size_ = 0;
+  }
+
+  /*
+   * 设置仓位的获取方式，需要和引擎保持一致
+   */
+  bool set_pos_transport(IpcTransport transport) {
+    return portfolio_.set_transport(transport);
   }
 
   Position get_position(const std::string& ticker) const {
@@ -87,21 +260,70 @@ class AlgoTradeContext {
 
   double get_float_pnl() const { return portfolio_.get_float_pnl(); }
 
+  uint32_t strategy_id() const { return strategy_id_; }
+
  private:
-  void send_order(const std::string& ticker, int volume, uint64_t direction,
-                  uint64_t offset, uint64_t type, double price) {
-    spdlog::info(
-        "[AlgoTradeContext::send_order] ticker: {}, volume: {}, price: {}, "
-        "type: {}, direction: {}, offset: {}",
-        ticker, volume, price, ordertype_str(type), direction_str(direction),
-        offset_str(offset));
+  friend class Strategy;
+
+  /*
+   * 策略进程内各阶段的延迟
+   * md_gateway_to_engine: 网关收到行情 -> 引擎转发行情
+   * md_engine_to_strategy: 引擎转发行情 -> 策略收到行情
+   * tick_to_send: 策略收到行情 -> 策略在on_tick中下单
+   */
+  enum LatencyStage {
+    MD_GATEWAY_TO_ENGINE = 0,
+    MD_ENGINE_TO_STRATEGY,
+    TICK_TO_SEND
+  };
+
+  static constexpr uint64_t kLatencyReportIntervalNs = 60'000'000'000UL;
+
+  /*
+   * 由Strategy在回调on_tick之前调用，on_tick中的下单都会带上这个行情的时间
+   */
+  void begin_tick(const TickData* tick) {
+    uint64_t recv_time = now_ns();
+    latency_.record(MD_GATEWAY_TO_ENGINE, tick->gateway_time,
+                    tick->engine_time);
+    latency_.record(MD_ENGINE_TO_STRATEGY, tick->engine_time, recv_time);
+    trigger_time_ = tick->gateway_time;
+    tick_recv_time_ = recv_time;
+
+    if (last_latency_report_time_ == 0) last_latency_report_time_ = recv_time;
+    if (recv_time - last_latency_report_time_ >= kLatencyReportIntervalNs) {
+      latency_.report("AlgoTradeContext::report_latency");
+      latency_.reset();
+      last_latency_report_time_ = recv_time;
+    }
+  }
+
+  void end_tick() {
+    trigger_time_ = 0;
+    tick_recv_time_ = 0;
+  }
 
+  void dump_latency() const {
+    latency_.report("AlgoTradeContext::dump_latency");
+  }
+
+  uint64_t send_order(const std::string& ticker, int volume,
+                      uint64_t direction, uint64_t offset, uint64_t type,
+                      double price) {
     auto contract = ContractTable::get_by_ticker(ticker);
     assert(contract);
 
+    FT_LOG_INFO(
+        "[AlgoTradeContext::send_order] ticker: {}, volume: {}, price: {}, "
+        "type: {}, direction: {}, offset: {}",
+        contract->ticker.c_str(), volume, price, LazyStr<ordertype_str>{type},
+        LazyStr<direction_str>{direction}, LazyStr<offset_str>{offset});
+    latency_.record(TICK_TO_SEND, tick_recv_time_, now_ns());
+
     TraderCommand cmd{};
     cmd.magic = TRADER_CMD_MAGIC;
     cmd.type = NEW_ORDER;
+    cmd.order_req.client_order_id = next_client_order_id_;
     cmd.order_req.ticker_index = contract->index;
     cmd.order_req.volume = volume;
     cmd.order_req.direction = direction;
@@ -109,12 +331,120 @@ class AlgoTradeContext {
     cmd.order_req.type = type;
     cmd.order_req.price = price;
 
-    cmd_redis_.publish(TRADER_CMD_TOPIC, &cmd, sizeof(cmd));
+    if (!send_cmd(&cmd)) return 0;
+    return next_client_order_id_++;
+  }
+
+  /*
+   * 批次已满时拒绝指令并返回false，拆成两个批次会破坏批次的原子性
+   */
+  bool send_cmd(TraderCommand* cmd) {
+    cmd->strategy_id = strategy_id_;
+    cmd->batch_size = 1;
+    cmd->send_time = now_ns();
+    cmd->trigger_time = trigger_time_;
+
+    if (!is_batching_) {
+      deliver(cmd, 1);
+      return true;
+    }
+
+    if (batch_size_ == kMaxCmdBatchSize) {
+      spdlog::error(
+          "[AlgoTradeContext::send_cmd] Batch is full. Cmd refused. Size: {}",
+          batch_size_);
+      return false;
+    }
+    batch_[batch_size_++] = *cmd;
+    return true;
+  }
+
+  /*
+   * 一直持有strategy_id的文件锁直到退出，两个策略使用同一个id时会写入
+   * 同一个单生产者队列，破坏队列
+   */
+  bool claim_strategy_id(uint32_t strategy_id) {
+    if (strategy_id >= kMaxStrategies) {
+      spdlog::error(
+          "[AlgoTradeContext::claim_strategy_id] Invalid strategy id {}",
+          strategy_id);
+      return false;
+    }
+
+    if (!id_lock_.try_lock(proto_strategy_lock_path(strategy_id))) {
+      spdlog::error(
+          "[AlgoTradeContext::claim_strategy_id] Strategy id {} is in use",
+          strategy_id);
+      return false;
+    }
+
+    strategy_id_ = strategy_id;
+    return true;
+  }
+
+  void open_order_view() {
+    if (!open_order_shm_.open(proto_open_order_shm_name(strategy_id_),
+                              false)) {
+      spdlog::warn(
+          "[AlgoTradeContext::open_order_view] Failed to open shm of open "
+          "orders");
+      open_orders_ = nullptr;
+      return;
+    }
+    open_orders_ = open_order_shm_.get();
+  }
+
+  void deliver(const TraderCommand* cmds, uint32_t count) {
+    if (cmd_handler_) {
+      cmd_handler_(cmds, count);
+      return;
+    }
+
+    if (cmd_transport_ == IpcTransport::SHM && cmd_shm_.is_open()) {
+      auto* queue = cmd_shm_.get();
+      if (!queue->push(strategy_id_, cmds, count)) {
+        // 引擎处理不过来时等待，交易指令不能丢
+        spdlog::warn("[AlgoTradeContext::deliver] Cmd queue is full");
+        while (!queue->push(strategy_id_, cmds, count)) cpu_relax();
+      }
+      if (queue->is_consumer_sleeping()) cmd_doorbell_.ring();
+      return;
+    }
+
+    if (!cmd_redis_)
+      cmd_redis_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+
+    WireMsg<TraderCommand, kMaxCmdBatchSize> msg;
+    msg.set_header(cmd_seq_++, count);
+    memcpy(msg.body, cmds, sizeof(*cmds) * count);
+    cmd_redis_->publish(TRADER_CMD_TOPIC, msg.data(), msg.size());
   }
 
  private:
-  RedisSession cmd_redis_;
+  uint32_t strategy_id_ = 0;
+  FileLock id_lock_;
+  uint64_t next_client_order_id_ = 1;
+  IpcTransport cmd_transport_ = IpcTransport::REDIS;
+  std::unique_ptr<RedisSession> cmd_redis_;
+  uint64_t cmd_seq_ = 0;
+  ShmSegment<TraderCmdQueue> cmd_shm_;
+  Doorbell cmd_doorbell_;
+  CmdHandler cmd_handler_;
+
+  ShmSegment<OpenOrderTable> open_order_shm_;
+  const OpenOrderTable* open_orders_ = nullptr;
+
+  bool is_batching_ = false;
+  uint32_t batch_size_ = 0;
+  TraderCommand batch_[kMaxCmdBatchSize];
+
   PositionHelper portfolio_;
+
+  LatencyRecorder latency_{
+      {"md_gateway_to_engine", "md_engine_to_strategy", "tick_to_send"}};
+  uint64_t trigger_time_ = 0;
+  uint64_t tick_recv_time_ = 0;
+  uint64_t last_latency_report_time_ = 0;
 };
 
 }  // namespace ft
@@ -0,0 +1,176 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_STRATEGY_MDREADER_H_
+#define FT_STRATEGY_MDREADER_H_
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Core/BarData.h"
+#include "Core/Protocol.h"
+#include "Core/TickData.h"
+#include "Core/WireFormat.h"
+#include "IPC/shm.h"
+
+namespace ft {
+
+/*
+ * 从共享内存的行情广播队列中读取订阅的行情
+ *
+ * 每个MdReader有自己的读取位置，落后于引擎超过max_lag条时切换为合并模式：
+ * 跳过队列中积压的数据，对每个订阅的ticker只回调一次最新的行情，然后从
+ * 队列的最新位置继续读取。跳过的数据（包括未订阅的ticker）计入
+ * dropped_ticks
+ *
+ * 引擎合成的bar在另一个广播队列中，有自己的读取位置，数量很少，不做合并
+ */
+class MdReader {
+ public:
+  bool open(uint64_t max_lag) {
+    if (!shm_.open(MD_SHM_NAME, false)) {
+      spdlog::error("[MdReader::open] Failed to open shm of md");
+      return false;
+    }
+
+    md_ = shm_.get();
+    cursor_ = md_->ring.head();
+    bar_cursor_ = md_->bars.head();
+    max_lag_ = std::min<uint64_t>(max_lag, md_->ring.capacity());
+    return true;
+  }
+
+  bool is_open() const { return md_ != nullptr; }
+
+  void subscribe(uint64_t ticker_index) {
+    if (ticker_index >= kMaxTickers) return;
+
+    if (ticker_index >= is_subscribed_.size())
+      is_subscribed_.resize(ticker_index + 1, false);
+    if (is_subscribed_[ticker_index]) return;
+
+    is_subscribed_[ticker_index] = true;
+    tickers_.emplace_back(ticker_index);
+  }
+
+  /*
+   * 回调所有新到的订阅行情，返回回调的次数
+   * 队列中的数据随时可能被覆盖，所以先拷贝出来再回调
+   */
+  template <class Handler>
+  std::size_t poll(Handler&& handler) {
+    uint64_t head = md_->ring.head();
+    if (head == cursor_) return 0;
+    if (head - cursor_ > max_lag_) return conflate(head, handler);
+
+    std::size_t count = 0;
+    for (; cursor_ < head; ++cursor_) {
+      if (!md_->ring.read(cursor_, &tick_)) {
+        // 读取过程中被覆盖
+        return count + conflate(md_->ring.head(), handler);
+      }
+
+      if (!is_subscribed(tick_.ticker_index)) continue;
+      handler(&tick_);
+      ++count;
+    }
+
+    return count;
+  }
+
+  /*
+   * 回调所有新到的订阅合约的bar，返回回调的次数。被覆盖的bar直接跳过
+   */
+  template <class Handler>
+  std::size_t poll_bars(Handler&& handler) {
+    uint64_t head = md_->bars.head();
+    std::size_t count = 0;
+    for (; bar_cursor_ < head; ++bar_cursor_) {
+      if (!md_->bars.read(bar_cursor_, &bar_)) {
+        spdlog::warn("[MdReader::poll_bars] Bars overwritten: {}",
+                     md_->bars.head() - bar_cursor_);
+        bar_cursor_ = md_->bars.head();
+        break;
+      }
+
+      if (!is_subscribed(bar_.ticker_index)) continue;
+      handler(&bar_);
+      ++count;
+    }
+    return count;
+  }
+
+  uint64_t dropped_ticks() const { return dropped_ticks_; }
+
+  /*
+   * 队列中是否有还没读取的数据，包括未订阅的ticker
+   */
+  bool has_pending() const {
+    return md_->ring.head() != cursor_ || md_->bars.head() != bar_cursor_;
+  }
+
+  /*
+   * 引擎最近一次写入行情的时间
+   */
+  uint64_t publish_time() const {
+    return md_->publish_time.load(std::memory_order_relaxed);
+  }
+
+  /*
+   * 引擎写入行情和订单回报后都会通过它唤醒策略
+   */
+  Notifier* notifier() { return &md_->notifier; }
+
+ private:
+  bool is_subscribed(uint64_t ticker_index) const {
+    return ticker_index < is_subscribed_.size() &&
+           is_subscribed_[ticker_index];
+  }
+
+  /*
+   * 跳到head，[cursor_, head)之间的数据只回调每个ticker的最新一条
+   * latest的序号不小于head的tick之后会从队列中读到，这里不用回调
+   */
+  template <class Handler>
+  std::size_t conflate(uint64_t head, Handler&& handler) {
+    std::size_t count = 0;
+    for (auto ticker_index : tickers_) {
+      if (!md_->latest[ticker_index].is_written()) continue;
+
+      auto latest = md_->latest[ticker_index].load();
+      if (latest.seq < cursor_ || latest.seq >= head) continue;
+
+      tick_ = latest.tick;
+      handler(&tick_);
+      ++count;
+    }
+
+    dropped_ticks_ += head - cursor_ - count;
+    spdlog::warn(
+        "[MdReader::conflate] Lagging behind by {} ticks, conflated into {}. "
+        "Dropped: {}",
+        head - cursor_, count, dropped_ticks_);
+
+    cursor_ = head;
+    return count;
+  }
+
+ private:
+  ShmSegment<MarketDataBroadcast> shm_;
+  MarketDataBroadcast* md_ = nullptr;
+  uint64_t cursor_ = 0;
+  uint64_t max_lag_ = 0;
+  uint64_t dropped_ticks_ = 0;
+
+  std::vector<bool> is_subscribed_;
+  std::vector<uint64_t> tickers_;
+  TickData tick_;
+
+  uint64_t bar_cursor_ = 0;
+  BarData bar_;
+};
+
+}  // namespace ft
+
+#endif  // FT_STRATEGY_MDREADER_H_
@@ -3,47 +3,348 @@
 #ifndef FT_STRATEGY_STRATEGY_H_
 #define FT_STRATEGY_STRATEGY_H_
 
+#include <poll.h>
+
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "Core/BarData.h"
+#include "Core/ContractTable.h"
+#include "Core/Protocol.h"
 #include "Core/TickData.h"
+#include "Core/WireFormat.h"
 #include "IPC/redis.h"
+#include "IPC/shm.h"
 #include "Strategy/Context.h"
+#include "Strategy/MdReader.h"
+#include "Strategy/WaitPolicy.h"
 
 namespace ft {
 
 class Strategy {
  public:
-  Strategy() : redis_tick_("127.0.0.1", 6379) {}
+  Strategy() {}
 
   virtual ~Strategy() {}
 
+  /*
+   * 选择行情的传输方式，需要和引擎保持一致，在run之前调用
+   */
+  void set_md_transport(IpcTransport transport) { md_transport_ = transport; }
+
+  /*
+   * 共享内存行情落后超过max_lag条时，跳过积压的数据，只处理每个ticker的
+   * 最新行情，在subscribe之前调用
+   */
+  void set_md_max_lag(uint64_t max_lag) { md_max_lag_ = max_lag; }
+
+  /*
+   * 没有新数据时的等待方式，spin_count只对SPIN_THEN_FUTEX有效，在run之前调用
+   */
+  void set_wait_policy(WaitPolicy policy, uint64_t spin_count) {
+    wait_policy_ = policy;
+    spin_count_ = spin_count;
+    wakeup_stats_.set_policy(policy);
+  }
+
+  /*
+   * 选择交易指令的传输方式，需要和引擎保持一致，在run之前调用
+   * strategy_id在所有同时运行的策略中必须唯一
+   */
+  bool set_cmd_transport(IpcTransport transport, uint32_t strategy_id) {
+    return ctx_.set_cmd_transport(transport, strategy_id);
+  }
+
+  /*
+   * 选择仓位的获取方式，需要和引擎保持一致，在run之前调用
+   */
+  bool set_pos_transport(IpcTransport transport) {
+    return ctx_.set_pos_transport(transport);
+  }
+
   void subscribe(const std::vector<std::string>& sub_list) {
+    if (is_in_process_) {
+      for (const auto& ticker : sub_list) {
+        const auto* contract = ContractTable::get_by_ticker(ticker);
+        if (!contract) {
+          spdlog::error("[Strategy::subscribe] Contract not found: {}", ticker);
+          continue;
+        }
+        if (contract->index >= is_subscribed_.size())
+          is_subscribed_.resize(contract->index + 1, false);
+        is_subscribed_[contract->index] = true;
+      }
+      return;
+    }
+
+    if (md_transport_ == IpcTransport::SHM) {
+      if (!md_reader_.is_open() && !md_reader_.open(md_max_lag_)) return;
+
+      for (const auto& ticker : sub_list) {
+        const auto* contract = ContractTable::get_by_ticker(ticker);
+        if (!contract) {
+          spdlog::error("[Strategy::subscribe] Contract not found: {}", ticker);
+          continue;
+        }
+        md_reader_.subscribe(contract->index);
+      }
+      return;
+    }
+
     std::vector<std::string> topics;
-    for (const auto& ticker : sub_list)
+    for (const auto& ticker : sub_list) {
       topics.emplace_back(proto_md_topic(ticker));
-    redis_tick_.subscribe(topics);
+      topics.emplace_back(proto_bar_topic(ticker));
+    }
+
+    // run_redis之前（如on_init中）先记下来，和订单回报一起一次订阅
+    if (!redis_tick_) {
+      redis_topics_.insert(redis_topics_.end(), topics.begin(), topics.end());
+      return;
+    }
+    redis_tick_->append_subscribe(topics);
   }
 
   virtual void on_init(AlgoTradeContext* ctx) {}
 
   virtual void on_tick(AlgoTradeContext* ctx, const TickData* tick) {}
 
+  /*
+   * 引擎合成的bar（见引擎的--bars参数），订阅的合约的所有bar都会回调，
+   * 按bar->type和bar->interval区分。进行中的bar定期回调，bar->is_closed
+   * 为1时这个bar已经结束，不会再变化
+   */
+  virtual void on_bar(AlgoTradeContext* ctx, const BarData* bar) {}
+
+  /*
+   * 订单状态变化时回调（被接受、被拒、撤单成功、撤单被拒）
+   */
+  virtual void on_order(AlgoTradeContext* ctx, const OrderEvent* event) {}
+
+  /*
+   * 订单成交时回调
+   */
+  virtual void on_trade(AlgoTradeContext* ctx, const OrderEvent* event) {}
+
   virtual void on_exit(AlgoTradeContext* ctx) {}
 
+  /*
+   * 各阶段的延迟每分钟输出一次，kill -USR1 <pid>时立即输出
+   */
   void run() {
+    install_latency_dump_handler();
+    on_init(&ctx_);
+
+    if (md_transport_ == IpcTransport::SHM)
+      run_shm();
+    else
+      run_redis();
+  }
+
+  /*
+   * 由引擎加载到进程内运行时代替run调用，不再需要set_md_transport和
+   * set_cmd_transport。交易指令直接交给handler处理，行情和订单回报由引擎
+   * 通过dispatch_tick、dispatch_bar和dispatch_order_event回调
+   */
+  bool init_in_process(uint32_t strategy_id,
+                       AlgoTradeContext::CmdHandler handler) {
+    if (!ctx_.set_cmd_handler(strategy_id, std::move(handler))) return false;
+
+    is_in_process_ = true;
     on_init(&ctx_);
+    return true;
+  }
+
+  void dispatch_tick(const TickData* tick) {
+    if (tick->ticker_index < is_subscribed_.size() &&
+        is_subscribed_[tick->ticker_index])
+      process_tick(tick);
+  }
+
+  void dispatch_bar(const BarData* bar) {
+    if (bar->ticker_index < is_subscribed_.size() &&
+        is_subscribed_[bar->ticker_index])
+      on_bar(&ctx_, bar);
+  }
+
+  void dispatch_order_event(const OrderEvent* event) {
+    process_order_event(event);
+  }
+
+  void dump_latency() const { ctx_.dump_latency(); }
+
+ private:
+  void run_redis() {
+    // 订单回报和行情共用一个连接，通过channel区分
+    auto event_topic = proto_order_event_topic(ctx_.strategy_id());
+    redis_topics_.emplace_back(event_topic);
+    redis_tick_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+    redis_tick_->subscribe(redis_topics_);
+
+    auto handler = [this, &event_topic](const RedisReply& reply) {
+      process_redis_msg(event_topic, reply);
+    };
+
+    pollfd pfd{redis_tick_->fd(), POLLIN, 0};
+    uint64_t idle_rounds = 0;
     for (;;) {
-      auto reply = redis_tick_.get_sub_reply();
-      auto tick = reinterpret_cast<const TickData*>(reply->element[2]->str);
-      on_tick(&ctx_, tick);
+      if (take_latency_dump_request()) ctx_.dump_latency();
+
+      bool will_sleep = should_sleep(idle_rounds);
+      if (::poll(&pfd, 1, will_sleep ? -1 : 0) <= 0) {
+        ++idle_rounds;
+        continue;
+      }
+
+      is_waking_up_ = idle_rounds > 0 || will_sleep;
+      has_slept_ = will_sleep;
+      idle_rounds = 0;
+      redis_tick_->poll_sub_replies(handler);
     }
   }
 
+  void process_redis_msg(const std::string& event_topic,
+                         const RedisReply& reply) {
+    if (!is_sub_message(reply)) return;
+
+    const auto* msg = reply->element[2];
+    if (event_topic == reply->element[1]->str) {
+      WireView<OrderEvent> events(msg->str, msg->len);
+      if (!events.is_valid()) return;
+
+      record_wakeup(events.header().send_time);
+      for (std::size_t i = 0; i < events.count(); ++i)
+        process_order_event(&events[i]);
+      return;
+    }
+
+    if (is_bar_topic(reply->element[1]->str)) {
+      WireView<BarData> bars(msg->str, msg->len);
+      if (!bars.is_valid()) return;
+
+      record_wakeup(bars.header().send_time);
+      for (std::size_t i = 0; i < bars.count(); ++i) on_bar(&ctx_, &bars[i]);
+      return;
+    }
+
+    WireView<TickData> ticks(msg->str, msg->len);
+    if (!ticks.is_valid()) return;
+
+    record_wakeup(ticks.header().send_time);
+    for (std::size_t i = 0; i < ticks.count(); ++i) process_tick(&ticks[i]);
+  }
+
+  void run_shm() {
+    ShmSegment<OrderEventRing> event_shm;
+    if (!event_shm.open(proto_order_event_shm_name(ctx_.strategy_id()),
+                        false)) {
+      spdlog::error("[Strategy::run] Failed to open shm of order event");
+      return;
+    }
+    auto* event_ring = event_shm.get();
+
+    // 没有订阅行情的策略也要睡眠在行情的唤醒点上
+    if (!md_reader_.is_open() && !md_reader_.open(md_max_lag_)) return;
+    auto* notifier = md_reader_.notifier();
+
+    auto tick_handler = [this](const TickData* tick) {
+      record_wakeup(md_reader_.publish_time());
+      process_tick(tick);
+    };
+    auto bar_handler = [this](const BarData* bar) { on_bar(&ctx_, bar); };
+
+    uint64_t idle_rounds = 0;
+    for (;;) {
+      if (take_latency_dump_request()) ctx_.dump_latency();
+
+      std::size_t count = 0;
+      while (const auto* event = event_ring->front()) {
+        record_wakeup(event->engine_time);
+        process_order_event(event);
+        event_ring->pop_front();
+        ++count;
+      }
+      count += md_reader_.poll(tick_handler);
+      count += md_reader_.poll_bars(bar_handler);
+
+      if (count > 0) {
+        idle_rounds = 0;
+        continue;
+      }
+
+      ++idle_rounds;
+      is_waking_up_ = true;
+      has_slept_ = false;
+      if (!should_sleep(idle_rounds)) {
+        cpu_relax();
+        continue;
+      }
+
+      auto seq = notifier->prepare_wait();
+      if (event_ring->empty() && !md_reader_.has_pending()) {
+        notifier->wait(seq);
+        has_slept_ = true;
+      }
+      notifier->finish_wait();
+    }
+  }
+
+  bool should_sleep(uint64_t idle_rounds) const {
+    switch (wait_policy_) {
+      case WaitPolicy::SPIN:
+        return false;
+      case WaitPolicy::SPIN_THEN_FUTEX:
+        return idle_rounds >= spin_count_;
+      case WaitPolicy::BLOCK:
+        return true;
+    }
+    return true;
+  }
+
+  /*
+   * 只记录等待之后的第一条数据
+   */
+  void record_wakeup(uint64_t publish_time) {
+    if (!is_waking_up_) return;
+
+    wakeup_stats_.record(publish_time, has_slept_);
+    is_waking_up_ = false;
+  }
+
+  void process_tick(const TickData* tick) {
+    ctx_.begin_tick(tick);
+    on_tick(&ctx_, tick);
+    ctx_.end_tick();
+  }
+
+  void process_order_event(const OrderEvent* event) {
+    if (event->type == ORDER_TRADED)
+      on_trade(&ctx_, event);
+    else
+      on_order(&ctx_, event);
+  }
+
  private:
   AlgoTradeContext ctx_;
-  RedisSession redis_tick_;
+  IpcTransport md_transport_ = IpcTransport::REDIS;
+
+  std::unique_ptr<RedisSession> redis_tick_;  // 在run_redis中创建
+  std::vector<std::string> redis_topics_;
+
+  MdReader md_reader_;
+  uint64_t md_max_lag_ = 1024;
+
+  WaitPolicy wait_policy_ = WaitPolicy::SPIN_THEN_FUTEX;
+  uint64_t spin_count_ = 100000;
+  WakeupStats wakeup_stats_;
+  bool is_waking_up_ = false;
+  bool has_slept_ = false;
+
+  // 运行在引擎进程内时按ticker_index记录订阅的合约
+  bool is_in_process_ = false;
+  std::vector<bool> is_subscribed_;
 };
 
 #define EXPORT_STRATEGY(type) \
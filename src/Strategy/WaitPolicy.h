@@ -0,0 +1,96 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_STRATEGY_WAITPOLICY_H_
+#define FT_STRATEGY_WAITPOLICY_H_
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "Utils/Clock.h"
+#include "Utils/Histogram.h"
+
+namespace ft {
+
+/*
+ * 策略没有新数据时的等待方式
+ * SPIN: 一直轮询，独占一个核，唤醒延迟最低
+ * SPIN_THEN_FUTEX: 连续空闲spin_count轮后睡眠，有数据时由引擎唤醒
+ * BLOCK: 没有数据立即睡眠，CPU占用最低，适合和其他进程共用机器
+ *
+ * 共享内存模式下睡眠在MarketDataBroadcast::notifier上，redis模式下睡眠
+ * 在连接的fd上
+ */
+enum class WaitPolicy { SPIN = 0, SPIN_THEN_FUTEX, BLOCK };
+
+inline WaitPolicy string2waitpolicy(const std::string& name) {
+  static const std::map<std::string, WaitPolicy> policy_map = {
+      {"spin", WaitPolicy::SPIN},
+      {"spin-futex", WaitPolicy::SPIN_THEN_FUTEX},
+      {"block", WaitPolicy::BLOCK}};
+
+  auto iter = policy_map.find(name);
+  if (iter == policy_map.end()) return WaitPolicy::SPIN_THEN_FUTEX;
+  return iter->second;
+}
+
+inline const char* waitpolicy2string(WaitPolicy policy) {
+  switch (policy) {
+    case WaitPolicy::SPIN:
+      return "spin";
+    case WaitPolicy::SPIN_THEN_FUTEX:
+      return "spin-futex";
+    case WaitPolicy::BLOCK:
+      return "block";
+  }
+  return "unknown";
+}
+
+/*
+ * 唤醒延迟：从引擎写入数据（now_ns）到策略开始处理之间的时间
+ * 只统计每次等待之后的第一条数据，持续有数据时的排队延迟不计入
+ * 自旋时发现的和睡眠后被唤醒的分开统计，定期输出后清零
+ */
+class WakeupStats {
+ public:
+  static constexpr uint64_t kReportIntervalNs = 60'000'000'000UL;
+
+  void set_policy(WaitPolicy policy) { policy_ = policy; }
+
+  void record(uint64_t publish_time, bool has_slept) {
+    uint64_t now = now_ns();
+    // 引擎没有记录时间或者时间异常
+    if (publish_time > 0 && publish_time <= now) {
+      if (has_slept)
+        sleep_latency_.record(now - publish_time);
+      else
+        spin_latency_.record(now - publish_time);
+    }
+
+    if (last_report_time_ == 0) last_report_time_ = now;
+    if (now - last_report_time_ >= kReportIntervalNs) report(now);
+  }
+
+  void report(uint64_t now) {
+    spdlog::info("[WakeupStats::report] Policy: {}, Spin(ns): {}",
+                 waitpolicy2string(policy_), spin_latency_.summary());
+    spdlog::info("[WakeupStats::report] Policy: {}, Sleep(ns): {}",
+                 waitpolicy2string(policy_), sleep_latency_.summary());
+
+    spin_latency_.reset();
+    sleep_latency_.reset();
+    last_report_time_ = now;
+  }
+
+ private:
+  WaitPolicy policy_ = WaitPolicy::SPIN_THEN_FUTEX;
+  Histogram spin_latency_;
+  Histogram sleep_latency_;
+  uint64_t last_report_time_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_STRATEGY_WAITPOLICY_H_
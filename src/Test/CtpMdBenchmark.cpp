@@ -0,0 +1,202 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <ThostFtdcUserApiStruct.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <getopt.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Core/ContractTable.h"
+#include "Gateway/Ctp/CtpCommon.h"
+#include "Gateway/Ctp/CtpMdNormalizer.h"
+#include "Utils/Clock.h"
+
+/*
+ * 比较CtpMdApi旧的行情转换方式（std::map查找合约、strptime解析时间）和
+ * CtpMdNormalizer的耗时
+ *
+ * --capture-file是按顺序写入的CThostFtdcDepthMarketDataField原始结构体，
+ * 可以在OnRtnDepthMarketData中用fwrite(md, sizeof(*md), 1, fp)录制。
+ * 没有指定时用合约表中的前--num-tickers个合约生成行情
+ */
+
+using MdField = CThostFtdcDepthMarketDataField;
+
+static bool load_capture(const std::string& file, std::vector<MdField>* mds) {
+  std::ifstream ifs(file, std::ios::binary);
+  if (!ifs) return false;
+
+  MdField md;
+  while (ifs.read(reinterpret_cast<char*>(&md), sizeof(md)))
+    mds->emplace_back(md);
+  return !mds->empty();
+}
+
+static void generate(uint64_t num_tickers, std::vector<MdField>* mds) {
+  num_tickers = std::min<uint64_t>(num_tickers, ft::ContractTable::size());
+  for (uint64_t i = 0; i < 100000; ++i) {
+    const auto* contract = ft::ContractTable::get_by_index(1 + i % num_tickers);
+    uint64_t sec = 9 * 3600 + i / 2;
+
+    MdField md{};
+    snprintf(md.TradingDay, sizeof(md.TradingDay), "20200618");
+    snprintf(md.ActionDay, sizeof(md.ActionDay), "20200618");
+    snprintf(md.InstrumentID, sizeof(md.InstrumentID), "%s",
+             contract->symbol.c_str());
+    snprintf(md.UpdateTime, sizeof(md.UpdateTime), "%02lu:%02lu:%02lu",
+             sec / 3600, sec / 60 % 60, sec % 60);
+    md.UpdateMillisec = i % 2 * 500;
+    md.LastPrice = 3000 + i % 7;
+    md.OpenPrice = 3000;
+    md.HighestPrice = 3010;
+    md.LowestPrice = 2990;
+    md.PreClosePrice = 3000;
+    md.UpperLimitPrice = 3300;
+    md.LowerLimitPrice = 2700;
+    md.Volume = i;
+    md.Turnover = i * 3000;
+    md.OpenInterest = 10000;
+    md.AskPrice1 = md.LastPrice + 1;
+    md.BidPrice1 = md.LastPrice;
+    md.AskPrice2 = md.AskPrice3 = md.AskPrice4 = md.AskPrice5 = 1.7e308;
+    md.BidPrice2 = md.BidPrice3 = md.BidPrice4 = md.BidPrice5 = 1.7e308;
+    md.AskVolume1 = 1 + i % 13;
+    md.BidVolume1 = 1 + i % 11;
+    mds->emplace_back(md);
+  }
+}
+
+/*
+ * 改动前CtpMdApi::OnRtnDepthMarketData中的实现
+ */
+static bool legacy_normalize(
+    const std::map<std::string, const ft::Contract*>& symbol2contract,
+    const MdField* md, ft::TickData* tick) {
+  auto iter = symbol2contract.find(md->InstrumentID);
+  if (iter == symbol2contract.end()) return false;
+
+  tick->ticker_index = iter->second->index;
+
+  struct tm _tm;
+  strptime(md->UpdateTime, "%H:%M:%S", &_tm);
+  tick->time_sec = _tm.tm_sec + _tm.tm_min * 60 + _tm.tm_hour * 3600;
+  tick->time_ms = md->UpdateMillisec;
+
+  tick->volume = md->Volume;
+  tick->turnover = md->Turnover;
+  tick->open_interest = md->OpenInterest;
+  tick->last_price = ft::adjust_price(md->LastPrice);
+  tick->open_price = ft::adjust_price(md->OpenPrice);
+  tick->highest_price = ft::adjust_price(md->HighestPrice);
+  tick->lowest_price = ft::adjust_price(md->LowestPrice);
+  tick->pre_close_price = ft::adjust_price(md->PreClosePrice);
+  tick->upper_limit_price = ft::adjust_price(md->UpperLimitPrice);
+  tick->lower_limit_price = ft::adjust_price(md->LowerLimitPrice);
+
+  tick->level = 5;
+  tick->ask[0] = ft::adjust_price(md->AskPrice1);
+  tick->ask[1] = ft::adjust_price(md->AskPrice2);
+  tick->ask[2] = ft::adjust_price(md->AskPrice3);
+  tick->ask[3] = ft::adjust_price(md->AskPrice4);
+  tick->ask[4] = ft::adjust_price(md->AskPrice5);
+  tick->bid[0] = ft::adjust_price(md->BidPrice1);
+  tick->bid[1] = ft::adjust_price(md->BidPrice2);
+  tick->bid[2] = ft::adjust_price(md->BidPrice3);
+  tick->bid[3] = ft::adjust_price(md->BidPrice4);
+  tick->bid[4] = ft::adjust_price(md->BidPrice5);
+  tick->ask_volume[0] = md->AskVolume1;
+  tick->ask_volume[1] = md->AskVolume2;
+  tick->ask_volume[2] = md->AskVolume3;
+  tick->ask_volume[3] = md->AskVolume4;
+  tick->ask_volume[4] = md->AskVolume5;
+  tick->bid_volume[0] = md->BidVolume1;
+  tick->bid_volume[1] = md->BidVolume2;
+  tick->bid_volume[2] = md->BidVolume3;
+  tick->bid_volume[3] = md->BidVolume4;
+  tick->bid_volume[4] = md->BidVolume5;
+  return true;
+}
+
+template <class Func>
+static void run_benchmark(const std::string& name,
+                          const std::vector<MdField>& mds, uint64_t num_ticks,
+                          Func&& normalize) {
+  // 累加结果，避免被编译器优化掉
+  uint64_t checksum = 0;
+  ft::TickData tick;
+  uint64_t begin = ft::now_ns();
+  for (uint64_t i = 0; i < num_ticks; ++i) {
+    if (normalize(mds[i % mds.size()], &tick))
+      checksum += tick.ticker_index + tick.time_sec + tick.bid_volume[0];
+  }
+  uint64_t total_ns = ft::now_ns() - begin;
+
+  spdlog::info("{:<16} {:>6.1f} ns/tick, checksum: {}", name,
+               static_cast<double>(total_ns) / num_ticks, checksum);
+}
+
+int main() {
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts-file");
+  std::string capture_file = getarg("", "--capture-file");
+  uint64_t num_tickers = getarg(64UL, "--num-tickers");
+  uint64_t num_ticks = getarg(10000000UL, "--num-ticks");
+
+  if (!ft::ContractTable::init(contracts_file) ||
+      ft::ContractTable::size() == 0) {
+    spdlog::error("Invalid file of contract list");
+    exit(-1);
+  }
+
+  std::vector<MdField> mds;
+  if (!capture_file.empty() && !load_capture(capture_file, &mds)) {
+    spdlog::error("Invalid capture file");
+    exit(-1);
+  }
+  if (mds.empty()) generate(num_tickers, &mds);
+
+  // 和CtpMdApi一样只索引收到的合约
+  std::map<std::string, const ft::Contract*> symbol2contract;
+  ft::CtpMdNormalizer normalizer;
+  for (const auto& md : mds) {
+    const auto* contract = ft::ContractTable::get_by_symbol(md.InstrumentID);
+    if (!contract || symbol2contract.count(contract->symbol) > 0) continue;
+    symbol2contract.emplace(contract->symbol, contract);
+    normalizer.add_ticker(contract->ticker);
+  }
+  normalizer.set_trading_day(mds.front().TradingDay);
+
+  spdlog::info("Records: {}, Tickers: {}", mds.size(), symbol2contract.size());
+
+  // 两种方式的结果应该一致
+  uint64_t num_mismatched = 0;
+  for (const auto& md : mds) {
+    ft::TickData legacy{};
+    ft::TickData normalized{};
+    bool found = legacy_normalize(symbol2contract, &md, &legacy);
+    if (found != (normalizer.normalize(md, ft::now_ns(), &normalized) !=
+                  nullptr) ||
+        legacy.ticker_index != normalized.ticker_index ||
+        legacy.time_sec != normalized.time_sec ||
+        legacy.last_price != normalized.last_price)
+      ++num_mismatched;
+  }
+  if (num_mismatched > 0)
+    spdlog::warn("Mismatched records: {}", num_mismatched);
+
+  run_benchmark("legacy", mds, num_ticks,
+                [&](const MdField& md, ft::TickData* tick) {
+                  return legacy_normalize(symbol2contract, &md, tick);
+                });
+
+  uint64_t recv_time = ft::now_ns();
+  run_benchmark("CtpMdNormalizer", mds, num_ticks,
+                [&](const MdField& md, ft::TickData* tick) {
+                  return normalizer.normalize(md, recv_time, tick) != nullptr;
+                });
+}
@@ -1,24 +1,38 @@
 // Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
 
+#include <signal.h>
 #include <spdlog/spdlog.h>
 
-#include <atomic>
+#include <ctime>
 #include <getopt.hpp>
-#include <iostream>
-
-#include "Base/EventEngine.h"
-#include "ContractTable.h"
-#include "Gateway.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/ContractTable.h"
+#include "Core/Gateway.h"
+#include "Core/TradingEngineInterface.h"
+#include "Journal/TickJournal.h"
 #include "TestCommon.h"
 
-class DataCollector {
+/*
+ * 把收到的行情原样写入行情日志（见Journal/TickJournal.h），每个交易日一个
+ * 文件，用TickJournalReader读取
+ *
+ * --all-tickers订阅合约表中的所有合约，否则订阅登录配置中的ticker
+ *
+ * 收到SIGINT或者SIGTERM时先停止网关，再关闭行情日志，文件以JournalEnd
+ * 结尾，读取方可以知道已经写完
+ */
+class DataCollector : public ft::TradingEngineInterface {
  public:
-  DataCollector() : engine_(new ft::EventEngine) {
-    engine_->set_handler(ft::EV_TICK, MEM_HANDLER(DataCollector::on_tick));
+  bool open(const std::string& path, uint64_t segment_size,
+            uint64_t flush_interval_ms) {
+    return journal_.open(path, segment_size, flush_interval_ms);
   }
 
   bool login(const ft::LoginParams& params) {
-    gateway_.reset(create_gateway(params.api(), engine_.get()));
+    gateway_.reset(ft::create_gateway(params.api(), this));
     if (!gateway_) {
       spdlog::error("[DataCollector::login] Unknown API");
       return false;
@@ -28,79 +42,41 @@ class DataCollector {
       spdlog::error("[DataCollector::login] Failed to login into md server");
       return false;
     }
-    is_login_ = true;
     return true;
   }
 
-  void set_output_path(const std::string& path) {
-    if (path.empty()) return;
-
-    path_ = path;
-    if (path_.back() == '/') path_.pop_back();
-  }
-
-  void run() { engine_->run(); }
-
-  void on_tick(cppex::Any* data) {
-    auto* tick = data->cast<ft::TickData>();
-    const auto* contract = ft::ContractTable::get_by_index(tick->ticker_index);
-    assert(contract);
-    auto iter = ofs_map_.find(contract->ticker);
-    if (iter == ofs_map_.end()) {
-      std::string file =
-          fmt::format("{}/{}-{}.csv", path_, contract->ticker, tick->date);
-      std::ofstream ofs(file, std::ios_base::app);
-      if (!ofs) {
-        spdlog::error("Failed to open file '{}'", file);
-        return;
+  /*
+   * 行情在网关的回调线程中写入，这里只定期输出统计信息，直到收到
+   * stop_signals中的信号。这些信号需要在所有线程中屏蔽
+   */
+  void run(const sigset_t& stop_signals) {
+    const timespec interval{60, 0};
+    for (;;) {
+      int sig = sigtimedwait(&stop_signals, nullptr, &interval);
+      if (sig > 0) {
+        spdlog::info("[DataCollector::run] Signal {} received. Stop", sig);
+        break;
       }
-      if (ofs.tellp() == 0) {
-        ofs << fmt::format(
-            "sec,msec,volume,turnover,open_interest,last_price,"
-            "open,highest,lowest,pre_close,upper_limit,lower_limit,"
-            "ask1,ask2,ask3,ask4,ask5,"
-            "bid1,bid2,bid3,bid4,bid5,"
-            "ask1_vol,ask2_vol,ask3_vol,ask4_vol,ask5_vol,"
-            "bid1_vol,bid2_vol,bid3_vol,bid4_vol,bid5_vol\n");
-        ofs.flush();
-      }
-
-      auto res = ofs_map_.emplace(std::move(file), std::move(ofs));
-      iter = res.first;
+      report_stats();
     }
 
-    auto& ofs = iter->second;
-    auto line = fmt::format(
-        "{},{},{},{},{},{},"
-        "{},{},{},{},{},{},"
-        "{},{},{},{},{},"
-        "{},{},{},{},{},"
-        "{},{},{},{},{},"
-        "{},{},{},{},{}\n",
-        tick->time_sec, tick->time_ms, tick->volume, tick->turnover,
-        tick->open_interest, tick->last_price, tick->open_price,
-        tick->highest_price, tick->lowest_price, tick->pre_close_price,
-        tick->upper_limit_price, tick->lower_limit_price, tick->ask[0],
-        tick->ask[1], tick->ask[2], tick->ask[3], tick->ask[4], tick->bid[0],
-        tick->bid[1], tick->bid[2], tick->bid[3], tick->bid[4],
-        tick->ask_volume[0], tick->ask_volume[1], tick->ask_volume[2],
-        tick->ask_volume[3], tick->ask_volume[4], tick->bid_volume[0],
-        tick->bid_volume[1], tick->bid_volume[2], tick->bid_volume[3],
-        tick->bid_volume[4]);
-    spdlog::info(line);
-    ofs << line;
-    ofs.flush();
+    // 网关析构后不会再有回调，之后才能关闭行情日志
+    gateway_.reset();
+    journal_.close();
+    report_stats();
   }
 
- private:
-  std::unique_ptr<ft::EventEngine> engine_;
-  std::unique_ptr<ft::Gateway> gateway_;
-  std::map<std::string, ft::Contract> contracts_;
-  std::atomic<bool> is_login_ = false;
+  void on_tick(const ft::TickData* tick) override { journal_.append(*tick); }
 
-  std::map<std::string, std::ofstream> ofs_map_;
+ private:
+  void report_stats() const {
+    spdlog::info("[DataCollector::run] Ticks: {}, Stalls: {}, Dropped: {}",
+                 journal_.num_ticks(), journal_.num_stalls(),
+                 journal_.num_dropped());
+  }
 
-  std::string path_ = ".";
+  std::unique_ptr<ft::Gateway> gateway_;
+  ft::TickJournalWriter journal_;
 };
 
 int main() {
@@ -110,6 +86,9 @@ int main() {
   std::string contracts_file =
       getarg("../config/contracts.csv", "--contracts-file");
   std::string log_level = getarg("info", "--loglevel");
+  bool all_tickers = getarg(false, "--all-tickers");
+  uint64_t segment_mb = getarg(64UL, "--segment-mb");
+  uint64_t flush_ms = getarg(1000UL, "--flush-interval-ms");
 
   spdlog::set_level(spdlog::level::from_str(log_level));
 
@@ -118,18 +97,29 @@ int main() {
     spdlog::error("Invalid file of login config");
     exit(-1);
   }
-  params.set_front_addr("");
 
   if (!ft::ContractTable::init(contracts_file)) {
     spdlog::error("Invalid file of contract list");
     exit(-1);
   }
 
-  auto* collector = new DataCollector;
-  if (!collector->login(params)) {
-    exit(-1);
+  if (all_tickers) {
+    std::vector<std::string> sub_list;
+    for (std::size_t i = 1; i <= ft::ContractTable::size(); ++i)
+      sub_list.emplace_back(ft::ContractTable::get_by_index(i)->ticker);
+    params.set_subscribed_list(sub_list);
   }
 
-  collector->set_output_path(path);
-  collector->run();
+  // 在创建任何线程之前屏蔽，新线程会继承，只由run同步地接收
+  sigset_t stop_signals;
+  sigemptyset(&stop_signals);
+  sigaddset(&stop_signals, SIGINT);
+  sigaddset(&stop_signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
+  auto* collector = new DataCollector;
+  if (!collector->open(path, segment_mb << 20, flush_ms)) exit(-1);
+  if (!collector->login(params)) exit(-1);
+
+  collector->run(stop_signals);
 }
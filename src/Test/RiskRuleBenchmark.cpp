@@ -0,0 +1,93 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <spdlog/spdlog.h>
+
+#include <getopt.hpp>
+#include <string>
+
+#include "Core/ContractTable.h"
+#include "RiskManagement/NoSelfTrade.h"
+#include "RiskManagement/OrderSizeLimit.h"
+#include "RiskManagement/RiskRuleChain.h"
+#include "RiskManagement/VelocityLimit.h"
+#include "Utils/Clock.h"
+
+/*
+ * 测量规则链上每增加一个规则后check_order_req的耗时
+ *
+ * 每批下kBatchSize个买单，只统计检查的耗时，整批检查完后再结束这些订单，
+ * 对手方始终有一个不会成交的卖单，自成交检查会走完整的比较流程
+ */
+static constexpr uint64_t kBatchSize = 1000;
+
+static ft::OrderReq make_req(uint64_t order_id, uint64_t direction,
+                             double price) {
+  ft::OrderReq req{};
+  req.order_id = order_id;
+  req.ticker_index = 1;
+  req.type = ft::OrderType::LIMIT;
+  req.direction = direction;
+  req.offset = ft::Offset::OPEN;
+  req.volume = 1;
+  req.price = price;
+  return req;
+}
+
+template <class Chain>
+static void run_benchmark(const std::string& name, Chain* chain,
+                          uint64_t num_orders) {
+  auto resting = make_req(1, ft::Direction::SELL, 1e9);
+  chain->check_order_req(&resting);
+  chain->on_order_sent(1);
+
+  // 每批的订单都已结束，下一批复用同样的order_id
+  uint64_t total_ns = 0;
+  uint64_t num_rejected = 0;
+  for (uint64_t n = 0; n < num_orders; n += kBatchSize) {
+    uint64_t begin = ft::now_ns();
+    for (uint64_t i = 0; i < kBatchSize; ++i) {
+      auto req = make_req(2 + i, ft::Direction::BUY, 100.0 + i % 10);
+      if (!chain->check_order_req(&req)) ++num_rejected;
+    }
+    total_ns += ft::now_ns() - begin;
+
+    for (uint64_t i = 0; i < kBatchSize; ++i) {
+      chain->on_order_sent(2 + i);
+      chain->on_order_completed(2 + i);
+    }
+  }
+
+  spdlog::info("{:<48} {:>6.1f} ns/check, rejected: {}", name,
+               static_cast<double>(total_ns) / num_orders, num_rejected);
+}
+
+int main() {
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts-file");
+  uint64_t num_orders = getarg(10000000UL, "--num-orders");
+
+  if (!ft::ContractTable::init(contracts_file) ||
+      !ft::ContractTable::get_by_index(1)) {
+    spdlog::error("Invalid file of contract list");
+    exit(-1);
+  }
+
+  // 限制设得足够大，测量的是检查通过时的耗时
+  auto velocity = [] { return ft::VelocityLimit(1, 100000, 1000000000); };
+
+  ft::RiskRuleChain<> empty;
+  run_benchmark("<>", &empty, num_orders);
+
+  ft::RiskRuleChain<ft::OrderSizeLimit> size_only{ft::OrderSizeLimit()};
+  run_benchmark("<OrderSizeLimit>", &size_only, num_orders);
+
+  ft::RiskRuleChain<ft::OrderSizeLimit, ft::NoSelfTradeRule> no_self_trade{
+      ft::OrderSizeLimit(), ft::NoSelfTradeRule()};
+  run_benchmark("<OrderSizeLimit, NoSelfTradeRule>", &no_self_trade,
+                num_orders);
+
+  ft::RiskRuleChain<ft::OrderSizeLimit, ft::NoSelfTradeRule, ft::VelocityLimit>
+      all{ft::OrderSizeLimit(), ft::NoSelfTradeRule(), velocity()};
+  run_benchmark("<OrderSizeLimit, NoSelfTradeRule, VelocityLimit>", &all,
+                num_orders);
+}
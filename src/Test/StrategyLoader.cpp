@@ -8,21 +8,43 @@
 
 #include "Core/ContractTable.h"
 #include "Strategy/Strategy.h"
-#include "TestCommon.h"
+#include "TradingSystem/Config.h"
+#include "Utils/DeferredLog.h"
 
 int main() {
   std::string contracts_file =
       getarg("../config/contracts.csv", "--contracts-file");
   std::string strategy_file = getarg("", "--strategy");
   std::string log_level = getarg("info", "--loglevel");
+  std::string md_transport = getarg("redis", "--md-transport");
+  std::string cmd_transport = getarg("redis", "--cmd-transport");
+  std::string pos_transport = getarg("redis", "--pos-transport");
+  uint32_t strategy_id = getarg(ft::kMaxStrategies, "--strategy-id");
+  uint64_t md_max_lag = getarg(1024UL, "--md-max-lag");
+  std::string wait_policy = getarg("spin-futex", "--wait-policy");
+  uint64_t spin_count = getarg(100000UL, "--spin-count");
+  std::string topology_file = getarg("", "--topology-config");
 
   spdlog::set_level(spdlog::level::from_str(log_level));
 
+  // 两个策略使用同一个strategy_id会写入同一个单生产者队列，不能有默认值
+  if (strategy_id >= ft::kMaxStrategies) {
+    spdlog::error("--strategy-id is required, range: [0, {})",
+                  ft::kMaxStrategies);
+    exit(-1);
+  }
+
   if (!ft::ContractTable::init(contracts_file)) {
     spdlog::error("Invalid file of contract list");
     exit(-1);
   }
 
+  ft::ThreadTopology topology;
+  if (!load_thread_topology(topology_file, &topology)) {
+    spdlog::error("Invalid file of thread topology");
+    exit(-1);
+  }
+
   void* handle = dlopen(strategy_file.c_str(), RTLD_LAZY);
   if (!handle) {
     spdlog::error("Invalid strategy .so");
@@ -38,5 +60,27 @@ int main() {
   }
 
   auto strategy = create_strategy();
+  strategy->set_md_transport(ft::string2transport(md_transport));
+  strategy->set_md_max_lag(md_max_lag);
+  strategy->set_wait_policy(ft::string2waitpolicy(wait_policy), spin_count);
+  if (!strategy->set_cmd_transport(ft::string2transport(cmd_transport),
+                                   strategy_id)) {
+    spdlog::error("Failed to init cmd transport");
+    exit(-1);
+  }
+  if (!strategy->set_pos_transport(ft::string2transport(pos_transport))) {
+    spdlog::error("Failed to init pos transport");
+    exit(-1);
+  }
+
+  // 日志线程先创建好，避免继承策略线程的绑核
+  auto& logger = ft::DeferredLogger::instance();
+  logger.set_placement(topology.log_writer);
+  ft::report_thread_placement(logger.native_handle(), "log_writer");
+
+  auto name = fmt::format("strategy_{}", strategy_id);
+  ft::pin_current_thread(name, topology.strategies[strategy_id]);
+  ft::report_thread_placement(pthread_self(), name);
+
   strategy->run();
 }
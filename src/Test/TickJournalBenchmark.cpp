@@ -0,0 +1,106 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <getopt.hpp>
+#include <string>
+#include <thread>
+
+#include "Core/ContractTable.h"
+#include "Journal/TickJournal.h"
+#include "Journal/TickJournalReader.h"
+#include "Utils/Clock.h"
+
+/*
+ * 测试TickJournalWriter::append的耗时，然后用TickJournalReader读回来校验
+ *
+ * --rate是每秒写入的行情数，为0时不限速。全市场的CTP行情峰值约为每秒
+ * 几万条，按这个速率写入时可以看到后台线程是否来得及预先分配空间
+ * （stalls为0）
+ */
+
+static void make_tick(uint64_t i, uint64_t num_tickers, ft::TickData* tick) {
+  tick->ticker_index = 1 + i % num_tickers;
+  tick->date = 20200618;
+  tick->time_sec = 9 * 3600 + i / 1000 % 20000;
+  tick->time_ms = i % 2 * 500;
+  tick->last_price = 3000 + i % 7;
+  tick->volume = i;
+  tick->level = 5;
+  tick->ask[0] = tick->last_price + 1;
+  tick->bid[0] = tick->last_price;
+  tick->ask_volume[0] = 1 + i % 13;
+  tick->bid_volume[0] = 1 + i % 11;
+}
+
+int main() {
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts-file");
+  std::string dir = getarg(".", "--dir");
+  uint64_t num_tickers = getarg(1000UL, "--num-tickers");
+  uint64_t num_ticks = getarg(5000000UL, "--num-ticks");
+  uint64_t rate = getarg(0UL, "--rate");
+  bool keep_file = getarg(false, "--keep-file");
+
+  if (!ft::ContractTable::init(contracts_file) ||
+      ft::ContractTable::size() == 0) {
+    spdlog::error("Invalid file of contract list");
+    exit(-1);
+  }
+  num_tickers = std::min<uint64_t>(num_tickers, ft::ContractTable::size());
+
+  auto file = ft::journal_file_name(dir, 20200618);
+  std::remove(file.c_str());
+
+  ft::TickJournalWriter writer;
+  if (!writer.open(dir)) exit(-1);
+
+  // 只统计append本身的耗时
+  ft::TickData tick{};
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+  uint64_t begin = ft::now_ns();
+  for (uint64_t i = 0; i < num_ticks; ++i) {
+    if (rate > 0) {
+      uint64_t due = begin + i * 1000000000UL / rate;
+      while (ft::now_ns() < due) std::this_thread::yield();
+    }
+
+    make_tick(i, num_tickers, &tick);
+    uint64_t start = ft::now_ns();
+    writer.append(tick);
+    uint64_t elapsed = ft::now_ns() - start;
+    total_ns += elapsed;
+    max_ns = std::max(max_ns, elapsed);
+  }
+
+  spdlog::info(
+      "append: {:.1f} ns/tick, max: {} ns, ticks: {}, stalls: {}, "
+      "dropped: {}",
+      static_cast<double>(total_ns) / num_ticks, max_ns, writer.num_ticks(),
+      writer.num_stalls(), writer.num_dropped());
+  writer.close();
+
+  ft::TickJournalReader reader;
+  if (!reader.open(file)) exit(-1);
+
+  uint64_t num_mismatched = 0;
+  uint64_t i = 0;
+  begin = ft::now_ns();
+  while (const auto* record = reader.next()) {
+    make_tick(i++, num_tickers, &tick);
+    if (record->ticker_index != tick.ticker_index ||
+        record->volume != tick.volume ||
+        reader.ticker(record->ticker_index).empty())
+      ++num_mismatched;
+  }
+  total_ns = ft::now_ns() - begin;
+
+  spdlog::info("read: {:.1f} ns/tick, ticks: {}, mismatched: {}",
+               static_cast<double>(total_ns) / std::max(i, 1UL),
+               reader.num_ticks(), num_mismatched);
+
+  if (!keep_file) std::remove(file.c_str());
+}
@@ -0,0 +1,331 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <cppex/split.h>
+#include <dirent.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.hpp>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Core/ContractTable.h"
+#include "Journal/TickJournalReader.h"
+#include "Store/TickStore.h"
+#include "Store/TickStoreReader.h"
+#include "Utils/Clock.h"
+
+/*
+ * 把行情转换为行情库文件（见Store/TickStore.h），每个交易日一个文件
+ *
+ * --input目录中可以有两种文件：
+ *   {ticker}-{date}.csv: 旧版DataCollector输出的csv
+ *   ticks-{date}.journal: DataCollector输出的行情日志
+ * 同一个交易日的同一个合约两种文件都有时只使用行情日志
+ *
+ * --verify在写完后读回所有合约，和原来的行情比较
+ */
+
+static const char* kCsvHeader =
+    "sec,msec,volume,turnover,open_interest,last_price,"
+    "open,highest,lowest,pre_close,upper_limit,lower_limit,"
+    "ask1,ask2,ask3,ask4,ask5,"
+    "bid1,bid2,bid3,bid4,bid5,"
+    "ask1_vol,ask2_vol,ask3_vol,ask4_vol,ask5_vol,"
+    "bid1_vol,bid2_vol,bid3_vol,bid4_vol,bid5_vol";
+
+struct DayFiles {
+  std::vector<std::string> journals;
+  std::vector<std::pair<std::string, std::string>> csvs;  // ticker, file
+};
+
+/*
+ * 按交易日整理input中的文件
+ */
+static bool scan_input(const std::string& dir,
+                       std::map<uint64_t, DayFiles>* days) {
+  DIR* dp = opendir(dir.c_str());
+  if (!dp) return false;
+
+  while (auto* ent = readdir(dp)) {
+    std::string name = ent->d_name;
+    uint64_t day = 0;
+    if (sscanf(name.c_str(), "ticks-%lu.journal", &day) == 1 &&
+        name == fmt::format("ticks-{}.journal", day)) {
+      (*days)[day].journals.emplace_back(dir + "/" + name);
+      continue;
+    }
+
+    // 合约名中可能有'-'，如期权合约
+    auto sep = name.rfind('-');
+    if (sep == std::string::npos || sep == 0 ||
+        sscanf(name.c_str() + sep, "-%lu.csv", &day) != 1 ||
+        name.substr(sep) != fmt::format("-{}.csv", day))
+      continue;
+    (*days)[day].csvs.emplace_back(name.substr(0, sep), dir + "/" + name);
+  }
+  closedir(dp);
+  return true;
+}
+
+static bool parse_csv_line(const std::string& line, uint64_t date,
+                           ft::TickData* tick) {
+  std::vector<std::string> fields;
+  split(line, ",", fields);
+  if (fields.size() != 32) return false;
+
+  auto u = [&fields](int i) {
+    return strtoull(fields[i].c_str(), nullptr, 10);
+  };
+  auto d = [&fields](int i) { return strtod(fields[i].c_str(), nullptr); };
+
+  *tick = ft::TickData{};
+  tick->date = date;
+  tick->time_sec = u(0);
+  tick->time_ms = u(1);
+  tick->volume = u(2);
+  tick->turnover = u(3);
+  tick->open_interest = u(4);
+  tick->last_price = d(5);
+  tick->open_price = d(6);
+  tick->highest_price = d(7);
+  tick->lowest_price = d(8);
+  tick->pre_close_price = d(9);
+  tick->upper_limit_price = d(10);
+  tick->lower_limit_price = d(11);
+  tick->level = 5;
+  for (int i = 0; i < 5; ++i) {
+    tick->ask[i] = d(12 + i);
+    tick->bid[i] = d(17 + i);
+    tick->ask_volume[i] = u(22 + i);
+    tick->bid_volume[i] = u(27 + i);
+  }
+  return true;
+}
+
+/*
+ * 按文件中的顺序对一个交易日的每一条行情调用f(ticker, tick)
+ */
+template <class F>
+static bool for_each_tick(uint64_t day, const DayFiles& files, F&& f) {
+  std::set<std::string> journal_tickers;
+  for (const auto& file : files.journals) {
+    ft::TickJournalReader reader;
+    if (!reader.open(file)) return false;
+    while (const auto* tick = reader.next()) {
+      const auto& ticker = reader.ticker(tick->ticker_index);
+      if (ticker.empty()) continue;
+      journal_tickers.emplace(ticker);
+      f(ticker, *tick);
+    }
+  }
+
+  ft::TickData tick;
+  for (const auto& [ticker, file] : files.csvs) {
+    if (journal_tickers.count(ticker) > 0) continue;
+
+    std::ifstream ifs(file);
+    std::string line;
+    if (!ifs || !std::getline(ifs, line) || line != kCsvHeader) {
+      spdlog::error("Invalid csv file: {}", file);
+      return false;
+    }
+    while (std::getline(ifs, line)) {
+      if (line.empty()) continue;
+      if (!parse_csv_line(line, day, &tick)) {
+        spdlog::error("Invalid line in {}: {}", file, line);
+        return false;
+      }
+      f(ticker, tick);
+    }
+  }
+  return true;
+}
+
+/*
+ * 按保存的字段计算行情的校验和（FNV-1a），用于逐条比较原来的行情和读回的
+ * 行情，不需要把整个交易日的行情放在内存中
+ */
+static void checksum(const ft::TickData& tick, uint64_t* sum) {
+  auto mix = [sum](uint64_t v) {
+    for (int i = 0; i < 8; ++i, v >>= 8) {
+      *sum ^= v & 0xff;
+      *sum *= 1099511628211UL;
+    }
+  };
+  auto mix_price = [&mix](double price) {
+    uint64_t v;
+    memcpy(&v, &price, sizeof(v));
+    mix(v);
+  };
+
+  mix(tick.time_sec);
+  mix(tick.time_ms);
+  mix(tick.exchange_time / 1000000);
+  mix_price(tick.last_price);
+  mix_price(tick.open_price);
+  mix_price(tick.highest_price);
+  mix_price(tick.lowest_price);
+  mix_price(tick.pre_close_price);
+  mix_price(tick.upper_limit_price);
+  mix_price(tick.lower_limit_price);
+  mix(tick.volume);
+  mix(tick.turnover);
+  mix(tick.open_interest);
+  mix(tick.level);
+  for (int i = 0; i < tick.level && i < static_cast<int>(ft::kMarketLevel);
+       ++i) {
+    mix_price(tick.ask[i]);
+    mix_price(tick.bid[i]);
+    mix(tick.ask_volume[i]);
+    mix(tick.bid_volume[i]);
+  }
+}
+
+static bool convert(uint64_t day, const DayFiles& files,
+                    const std::string& output) {
+  std::map<std::string, std::unique_ptr<ft::TickBlockEncoder>> encoders;
+  uint64_t begin = ft::now_ns();
+  bool ok = for_each_tick(day, files, [&](const std::string& ticker,
+                                          const ft::TickData& tick) {
+    auto& encoder = encoders[ticker];
+    if (!encoder) {
+      double price_tick = 0;
+      if (const auto* contract = ft::ContractTable::get_by_ticker(ticker))
+        price_tick = contract->price_tick;
+      else
+        spdlog::warn("{} is not in the contract table, price_tick=0.0001",
+                     ticker);
+      encoder = std::make_unique<ft::TickBlockEncoder>(price_tick);
+    }
+    encoder->append(tick);
+  });
+  if (!ok) return false;
+
+  auto file = ft::tick_store_file_name(output, day);
+  ft::TickStoreWriter writer;
+  if (!writer.open(file, day)) return false;
+
+  uint64_t num_ticks = 0;
+  uint64_t data_size = 0;
+  for (auto& [ticker, encoder] : encoders) {
+    if (!writer.write_block(ticker, encoder.get())) return false;
+    if (encoder->num_off_grid() > 0)
+      spdlog::warn("{}: {} prices are not multiples of price_tick {}", ticker,
+                   encoder->num_off_grid(), encoder->price_tick());
+    num_ticks += encoder->num_ticks();
+    data_size += encoder->data().size();
+  }
+  if (!writer.close()) return false;
+
+  spdlog::info(
+      "{}: {} tickers, {} ticks, {:.1f} bytes/tick, {:.1f} ns/tick to encode",
+      file, encoders.size(), num_ticks,
+      static_cast<double>(data_size) / std::max(num_ticks, 1UL),
+      static_cast<double>(ft::now_ns() - begin) / std::max(num_ticks, 1UL));
+  return true;
+}
+
+static bool verify(uint64_t day, const DayFiles& files,
+                   const std::string& output) {
+  auto file = ft::tick_store_file_name(output, day);
+  ft::TickStoreReader reader;
+  if (!reader.open(file)) return false;
+
+  struct Checksum {
+    uint64_t num_ticks = 0;
+    uint64_t sum = 14695981039346656037UL;
+  };
+
+  std::map<std::string, Checksum> expected;
+  bool ok = for_each_tick(day, files, [&](const std::string& ticker,
+                                          const ft::TickData& tick) {
+    auto& cs = expected[ticker];
+    ++cs.num_ticks;
+    checksum(tick, &cs.sum);
+  });
+  if (!ok) return false;
+
+  // 每次解码一个合约的全天行情
+  uint64_t num_ticks = 0;
+  uint64_t num_mismatched = 0;
+  uint64_t decode_ns = 0;
+  std::vector<ft::TickData> ticks;
+  for (std::size_t i = 0; i < reader.num_blocks(); ++i) {
+    const auto& entry = reader.block(i);
+    ticks.clear();
+    ticks.reserve(entry.num_ticks);
+    uint64_t begin = ft::now_ns();
+    if (!reader.read(entry.ticker, &ticks)) return false;
+    decode_ns += ft::now_ns() - begin;
+
+    Checksum cs;
+    for (const auto& tick : ticks) {
+      ++cs.num_ticks;
+      checksum(tick, &cs.sum);
+    }
+    const auto& ex = expected[entry.ticker];
+    if (cs.num_ticks != ex.num_ticks || cs.sum != ex.sum) ++num_mismatched;
+    num_ticks += ticks.size();
+  }
+  if (reader.num_blocks() != expected.size()) ++num_mismatched;
+
+  // 按时间段读取的结果合起来应该和全天的结果一致
+  uint64_t num_ranged = 0;
+  for (std::size_t i = 0; i < reader.num_blocks(); ++i) {
+    for (uint64_t hour = 18; hour < 18 + 24; ++hour) {
+      ticks.clear();
+      if (!reader.read(reader.block(i).ticker, hour % 24 * 3600,
+                       (hour + 1) % 24 * 3600, &ticks))
+        return false;
+      num_ranged += ticks.size();
+    }
+  }
+
+  spdlog::info(
+      "{}: {} ticks, {:.1f} ns/tick to decode, mismatched tickers: {}, "
+      "ranged: {}",
+      file, num_ticks,
+      static_cast<double>(decode_ns) / std::max(num_ticks, 1UL),
+      num_mismatched, num_ranged);
+  return num_mismatched == 0 && num_ranged == num_ticks;
+}
+
+int main() {
+  std::string input = getarg(".", "--input");
+  std::string output = getarg(".", "--output");
+  std::string contracts_file =
+      getarg("../config/contracts.csv", "--contracts-file");
+  bool verify_output = getarg(false, "--verify");
+  std::string log_level = getarg("info", "--loglevel");
+
+  spdlog::set_level(spdlog::level::from_str(log_level));
+
+  if (!ft::ContractTable::init(contracts_file)) {
+    spdlog::error("Invalid file of contract list");
+    exit(-1);
+  }
+
+  std::map<uint64_t, DayFiles> days;
+  if (!scan_input(input, &days)) {
+    spdlog::error("Invalid input dir: {}", input);
+    exit(-1);
+  }
+
+  for (const auto& [day, files] : days) {
+    if (!convert(day, files, output)) {
+      spdlog::error("Failed to convert ticks of {}", day);
+      exit(-1);
+    }
+    if (verify_output && !verify(day, files, output)) {
+      spdlog::error("Failed to verify ticks of {}", day);
+      exit(-1);
+    }
+  }
+}
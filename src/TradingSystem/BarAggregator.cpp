@@ -0,0 +1,233 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/BarAggregator.h"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "Utils/Clock.h"
+#include "Utils/Counter.h"
+
+namespace ft {
+
+namespace {
+
+constexpr uint64_t kNsPerSec = 1000000000UL;
+constexpr uint64_t kSecPerDay = 86400;
+constexpr uint64_t kUtcOffsetNs = 8 * 3600 * kNsPerSec;  // 按北京时间对齐
+
+std::vector<std::string> split(const std::string& str) {
+  std::vector<std::string> tokens;
+  std::stringstream ss(str);
+  std::string token;
+  while (std::getline(ss, token, ','))
+    if (!token.empty()) tokens.emplace_back(token);
+  return tokens;
+}
+
+/*
+ * 正整数，不接受0
+ */
+bool parse_uint(const std::string& s, uint64_t* value) {
+  if (s.empty() || s.size() > 18) return false;
+
+  *value = 0;
+  for (char c : s) {
+    if (c < '0' || c > '9') return false;
+    *value = *value * 10 + (c - '0');
+  }
+  return *value > 0;
+}
+
+/*
+ * "HH:MM"转为当天的秒数
+ */
+bool parse_hhmm(const std::string& s, uint64_t* sec) {
+  if (s.size() != 5 || s[2] != ':') return false;
+  for (int i : {0, 1, 3, 4})
+    if (s[i] < '0' || s[i] > '9') return false;
+
+  uint64_t hour = (s[0] - '0') * 10 + (s[1] - '0');
+  uint64_t minute = (s[3] - '0') * 10 + (s[4] - '0');
+  if (hour >= 24 || minute >= 60) return false;
+  *sec = hour * 3600 + minute * 60;
+  return true;
+}
+
+}  // namespace
+
+BarAggregator::BarAggregator(std::size_t num_tickers,
+                             std::vector<BarSpec> specs,
+                             std::vector<TradingSession> sessions,
+                             uint64_t update_interval_ms, BarHandler handler)
+    : specs_(std::move(specs)),
+      sessions_(std::move(sessions)),
+      update_interval_(update_interval_ms * 1000000UL),
+      handler_(std::move(handler)),
+      states_(num_tickers * specs_.size()),
+      is_active_(num_tickers, false) {}
+
+void BarAggregator::on_tick(const TickData& tick) {
+  // 还没有成交的合约（如开盘前的快照）没有最新价，不计入bar
+  if (tick.last_price <= 0 || tick.ticker_index >= is_active_.size()) return;
+
+  if (!is_active_[tick.ticker_index]) {
+    is_active_[tick.ticker_index] = true;
+    active_tickers_.emplace_back(tick.ticker_index);
+  }
+
+  uint64_t time = bar_time(tick);
+  auto* states = &states_[tick.ticker_index * specs_.size()];
+  for (std::size_t i = 0; i < specs_.size(); ++i)
+    update(specs_[i], tick, time, &states[i]);
+}
+
+void BarAggregator::flush(uint64_t wall_time) {
+  for (auto ticker_index : active_tickers_) {
+    auto* states = &states_[ticker_index * specs_.size()];
+    for (std::size_t i = 0; i < specs_.size(); ++i) {
+      auto* state = &states[i];
+      if (!state->is_open || specs_[i].type != BAR_TIME) continue;
+      if (state->bar.end_time + kPostCloseSec * kNsPerSec <= wall_time)
+        close_bar(state);
+    }
+  }
+}
+
+uint64_t BarAggregator::bar_time(const TickData& tick) const {
+  uint64_t sub_sec = std::min<uint64_t>(tick.time_ms, 999) * 1000000UL;
+
+  for (const auto& session : sessions_) {
+    uint64_t after_end =
+        (tick.time_sec + kSecPerDay - session.end_sec) % kSecPerDay;
+    if (after_end < kPostCloseSec)
+      return tick.exchange_time - after_end * kNsPerSec - sub_sec - 1;
+
+    uint64_t before_begin =
+        (session.begin_sec + kSecPerDay - tick.time_sec) % kSecPerDay;
+    if (before_begin > 0 && before_begin <= kPreOpenSec)
+      return tick.exchange_time + before_begin * kNsPerSec - sub_sec;
+  }
+  return tick.exchange_time;
+}
+
+void BarAggregator::update(const BarSpec& spec, const TickData& tick,
+                           uint64_t time, BarState* state) {
+  auto& bar = state->bar;
+  if (state->is_open && bar.date != tick.date) close_bar(state);
+
+  if (spec.type == BAR_TIME) {
+    if (time < state->closed_until ||
+        (state->is_open && time < bar.start_time)) {
+      increase_counter(&late_ticks_);
+      return;
+    }
+    if (state->is_open && time >= bar.end_time) close_bar(state);
+  }
+
+  if (!state->is_open) open_bar(spec, tick, time, state);
+
+  bar.high = std::max(bar.high, tick.last_price);
+  bar.low = std::min(bar.low, tick.last_price);
+  bar.close = tick.last_price;
+  bar.volume += tick.analytics.volume_delta;
+  bar.turnover += tick.analytics.turnover_delta;
+  bar.open_interest = tick.open_interest;
+  ++bar.num_ticks;
+  if (spec.type != BAR_TIME) bar.end_time = tick.exchange_time;
+
+  if ((spec.type == BAR_VOLUME && bar.volume >= spec.interval) ||
+      (spec.type == BAR_TICK && bar.num_ticks >= spec.interval)) {
+    close_bar(state);
+    return;
+  }
+
+  if (update_interval_ > 0 && tick.engine_time >= state->next_update_time) {
+    state->next_update_time = tick.engine_time + update_interval_;
+    publish(&bar);
+  }
+}
+
+void BarAggregator::open_bar(const BarSpec& spec, const TickData& tick,
+                             uint64_t time, BarState* state) {
+  auto& bar = state->bar;
+  bar = BarData();
+  bar.ticker_index = tick.ticker_index;
+  bar.type = spec.type;
+  bar.is_closed = 0;
+  bar.interval = spec.interval;
+  bar.date = tick.date;
+  bar.open = bar.high = bar.low = tick.last_price;
+
+  if (spec.type == BAR_TIME) {
+    uint64_t period = spec.interval * kNsPerSec;
+    bar.start_time = (time + kUtcOffsetNs) / period * period - kUtcOffsetNs;
+    bar.end_time = bar.start_time + period;
+  } else {
+    bar.start_time = tick.exchange_time;
+    bar.end_time = tick.exchange_time;
+  }
+
+  state->is_open = true;
+  state->next_update_time = tick.engine_time + update_interval_;
+}
+
+void BarAggregator::close_bar(BarState* state) {
+  state->is_open = false;
+  state->bar.is_closed = 1;
+  if (state->bar.type == BAR_TIME) state->closed_until = state->bar.end_time;
+
+  publish(&state->bar);
+  increase_counter(&num_bars_);
+}
+
+void BarAggregator::publish(BarData* bar) {
+  bar->engine_time = now_ns();
+  handler_(*bar);
+}
+
+bool BarAggregator::parse_specs(const std::string& str,
+                                std::vector<BarSpec>* specs) {
+  specs->clear();
+  for (const auto& token : split(str)) {
+    BarSpec spec;
+    uint64_t value;
+    if (token[0] == 'v' || token[0] == 't') {
+      if (!parse_uint(token.substr(1), &value)) return false;
+      spec.type = token[0] == 'v' ? BAR_VOLUME : BAR_TICK;
+      spec.interval = value;
+    } else {
+      uint64_t unit = 0;
+      if (token.back() == 's') unit = 1;
+      if (token.back() == 'm') unit = 60;
+      if (token.back() == 'h') unit = 3600;
+      if (unit == 0 || !parse_uint(token.substr(0, token.size() - 1), &value))
+        return false;
+
+      // 周期能整除一天时，每天的bar边界都相同
+      spec.type = BAR_TIME;
+      spec.interval = value * unit;
+      if (kSecPerDay % spec.interval != 0) return false;
+    }
+    specs->emplace_back(spec);
+  }
+  return true;
+}
+
+bool BarAggregator::parse_sessions(const std::string& str,
+                                   std::vector<TradingSession>* sessions) {
+  sessions->clear();
+  for (const auto& token : split(str)) {
+    TradingSession session;
+    if (token.size() != 11 || token[5] != '-' ||
+        !parse_hhmm(token.substr(0, 5), &session.begin_sec) ||
+        !parse_hhmm(token.substr(6), &session.end_sec) ||
+        session.begin_sec == session.end_sec)
+      return false;
+    sessions->emplace_back(session);
+  }
+  return true;
+}
+
+}  // namespace ft
@@ -0,0 +1,135 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_BARAGGREGATOR_H_
+#define FT_TRADINGSYSTEM_BARAGGREGATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Core/BarData.h"
+#include "Core/TickData.h"
+
+namespace ft {
+
+struct BarSpec {
+  uint32_t type;      // BarType
+  uint64_t interval;  // 含义同BarData::interval
+};
+
+/*
+ * 一个连续交易时段，北京时间当天的秒数，end小于begin时跨越午夜
+ */
+struct TradingSession {
+  uint64_t begin_sec;
+  uint64_t end_sec;
+};
+
+/*
+ * 由引擎转发的行情增量合成bar，以ticker_index和BarSpec为key保存每个bar
+ * 的当前状态，每条行情只更新对应合约的几个bar，不保存历史行情
+ *
+ * 成交量和成交额直接累加TickAnalytics中的增量。时间bar按exchange_time
+ * 对齐到北京时间的整周期，夜盘跨越午夜时也是连续的；交易日变化时所有
+ * 未结束的bar先结束再开始新的bar
+ *
+ * 交易时段只用于处理边界上的行情：开盘前kPreOpenSec以内的行情（集合
+ * 竞价）计入开盘后的第一个bar，收盘后kPostCloseSec以内的行情（收盘时的
+ * 快照）计入收盘前的最后一个bar，不会单独生成一个bar
+ *
+ * 时间bar在下一个周期的行情到来时结束，行情稀疏的合约由flush按本地时钟
+ * 在周期结束kPostCloseSec之后结束。之后才到的属于已结束周期的行情不再
+ * 计入bar，只计数
+ *
+ * on_tick在行情回调线程中调用，flush在引擎的bar_flusher线程中调用，
+ * 两者都持有引擎的md_mutex_。bar通过构造时传入的handler发布
+ */
+class BarAggregator {
+ public:
+  using BarHandler = std::function<void(const BarData&)>;
+
+  /*
+   * update_interval_ms为0时不发布进行中的bar
+   */
+  BarAggregator(std::size_t num_tickers, std::vector<BarSpec> specs,
+                std::vector<TradingSession> sessions,
+                uint64_t update_interval_ms, BarHandler handler);
+
+  /*
+   * tick需要已经计算过analytics，并且填写了engine_time
+   */
+  void on_tick(const TickData& tick);
+
+  /*
+   * 结束周期已经过去的时间bar，wall_time为本地的UTC纳秒数
+   */
+  void flush(uint64_t wall_time);
+
+  // 统计信息可以在其他线程中读取，不需要持有调用on_tick时的锁
+  uint64_t num_bars() const {
+    return num_bars_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t late_ticks() const {
+    return late_ticks_.load(std::memory_order_relaxed);
+  }
+
+  /*
+   * "1s,1m,5m,v1000,t100"：s、m、h结尾的是时间bar，v开头的是成交量bar，
+   * t开头的是tick bar
+   */
+  static bool parse_specs(const std::string& str, std::vector<BarSpec>* specs);
+
+  /*
+   * "09:00-10:15,10:30-11:30,21:00-02:30"
+   */
+  static bool parse_sessions(const std::string& str,
+                             std::vector<TradingSession>* sessions);
+
+ private:
+  struct BarState {
+    BarData bar;
+    bool is_open = false;
+    uint64_t closed_until = 0;      // 已经结束的时间bar的end_time
+    uint64_t next_update_time = 0;  // 下一次发布进行中的bar的engine_time
+  };
+
+  /*
+   * 按交易时段修正后用于划分时间bar的时间
+   */
+  uint64_t bar_time(const TickData& tick) const;
+
+  void update(const BarSpec& spec, const TickData& tick, uint64_t time,
+              BarState* state);
+
+  void open_bar(const BarSpec& spec, const TickData& tick, uint64_t time,
+                BarState* state);
+
+  void close_bar(BarState* state);
+
+  void publish(BarData* bar);
+
+ private:
+  static constexpr uint64_t kPreOpenSec = 300;
+  static constexpr uint64_t kPostCloseSec = 3;
+
+  std::vector<BarSpec> specs_;
+  std::vector<TradingSession> sessions_;
+  uint64_t update_interval_;
+  BarHandler handler_;
+
+  // 以ticker_index * specs_.size() + spec的下标为下标
+  std::vector<BarState> states_;
+  std::vector<bool> is_active_;
+  std::vector<uint64_t> active_tickers_;  // 收到过行情的合约，flush时遍历
+
+  // 只有持有锁的线程修改
+  std::atomic<uint64_t> num_bars_ = 0;
+  std::atomic<uint64_t> late_ticks_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_BARAGGREGATOR_H_
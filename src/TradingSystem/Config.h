@@ -6,16 +6,96 @@
 #include <yaml-cpp/yaml.h>
 
 #include <fstream>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "Core/LoginParams.h"
+#include "Core/Protocol.h"
+#include "Utils/ThreadAffinity.h"
 
-inline bool load_login_params(const std::string& file,
-                              ft::LoginParams* params) {
-  std::ifstream ifs(file);
-  if (!ifs) return false;
+namespace ft {
 
-  YAML::Node config = YAML::LoadFile(file);
+/*
+ * 各个线程运行在哪个核上，以及是否使用SCHED_FIFO，没有配置的线程保持
+ * 系统默认的调度。引擎和strategy_loader可以共用同一个配置文件，strategy_loader
+ * 按自己的strategy_id在strategies中查找
+ */
+struct ThreadTopology {
+  ThreadPlacement engine_loop;
+  ThreadPlacement log_writer;
+  ThreadPlacement pos_publisher;
+
+  // 网关的回调线程由柜台API创建，在第一次回调时设置。每个账户的网关各有
+  // 一组，按accounts中的顺序对应，没有配置的账户保持系统默认的调度
+  struct GatewayThreads {
+    ThreadPlacement md;
+    ThreadPlacement trade;
+  };
+  std::vector<GatewayThreads> gateways;
+
+  std::map<uint32_t, ThreadPlacement> strategies;
+};
+
+// 引擎运行时的配置，由命令行参数指定
+struct EngineConfig {
+  IpcTransport md_transport = IpcTransport::REDIS;
+  IpcTransport cmd_transport = IpcTransport::REDIS;
+  IpcTransport pos_transport = IpcTransport::REDIS;
+
+  // 仓位使用共享内存传输时，是否同时写入redis供监控使用
+  bool pos_redis_monitor = false;
+
+  // 事件循环空闲时，是一直轮询还是自旋cmd_spin_count轮后阻塞等待
+  bool cmd_busy_poll = false;
+  uint64_t cmd_spin_count = 100000;
+
+  // 策略发出后超过这个时间才被引擎取出的交易指令不执行，新订单直接拒绝，
+  // 为0时不限制。引擎启动之前发出的指令总是不执行
+  uint64_t cmd_max_age_ms = 1000;
+
+  // 定期查询账户的间隔，为0时不查询。查询是同步的，会阻塞事件循环
+  uint64_t account_refresh_sec = 0;
+
+  // 订单发出后超过这个时间仍未被交易所接受或拒绝时告警
+  uint64_t order_ack_timeout_sec = 5;
+
+  // 单写者模式：网关回调线程只把回报放入无锁队列，订单、仓位和风控只在
+  // 事件循环线程中访问，不再需要加锁
+  bool single_writer = false;
+
+  // 是否做风控检查，规则见TradingEngine.cpp中的EngineRiskRules
+  bool risk_check = false;
+
+  // 每velocity_period_ms内最多的订单数和下单量，为0表示不限制
+  uint64_t velocity_period_ms = 1000;
+  uint64_t velocity_order_limit = 0;
+  uint64_t velocity_volume_limit = 0;
+
+  // 在引擎进程内运行的策略.so，strategy_id从inproc_strategy_id开始依次分配，
+  // 不能和进程外的策略重复。加载了策略时总是使用单写者模式
+  std::vector<std::string> inproc_strategies;
+  uint32_t inproc_strategy_id = 0;
+
+  // 丢弃和上一次转发的行情完全相同的行情；conflate时最新价和买一卖一都
+  // 没有变化的行情也不转发
+  bool tick_dedup = true;
+  bool tick_conflate = false;
+
+  // 在引擎中合成的bar，如"1s,1m,5m,v1000,t100"，为空时不合成。进行中的bar
+  // 每bar_update_ms发布一次，为0时只发布已结束的bar。bar_sessions是交易
+  // 时段，用于把集合竞价和收盘时的行情计入相邻的bar
+  std::string bar_specs;
+  std::string bar_sessions = "09:00-10:15,10:30-11:30,13:30-15:00,21:00-23:00";
+  uint64_t bar_update_ms = 1000;
+
+  ThreadTopology topology;
+};
+
+}  // namespace ft
+
+inline void load_login_node(const YAML::Node& config,
+                            ft::LoginParams* params) {
   params->set_api(config["api"].as<std::string>());
   params->set_front_addr(config["front_addr"].as<std::string>());
   params->set_md_server_addr(config["md_server_addr"].as<std::string>());
@@ -25,7 +105,75 @@ inline bool load_login_params(const std::string& file,
   params->set_auth_code(config["auth_code"].as<std::string>());
   params->set_app_id(config["app_id"].as<std::string>());
   params->set_subscribed_list({config["ticker"].as<std::string>()});
+  if (config["exchanges"])
+    params->set_exchanges(config["exchanges"].as<std::vector<std::string>>());
+}
+
+inline bool load_login_params(const std::string& file,
+                              ft::LoginParams* params) {
+  std::ifstream ifs(file);
+  if (!ifs) return false;
+
+  YAML::Node config = YAML::LoadFile(file);
+  load_login_node(config, params);
+
+  return true;
+}
+
+/*
+ * 多个账户时每个账户是accounts下的一项，只有一个账户时直接写在顶层
+ */
+inline bool load_login_params_list(const std::string& file,
+                                   std::vector<ft::LoginParams>* params_list) {
+  std::ifstream ifs(file);
+  if (!ifs) return false;
+
+  YAML::Node config = YAML::LoadFile(file);
+  if (!config["accounts"]) {
+    params_list->emplace_back();
+    load_login_node(config, &params_list->back());
+    return true;
+  }
+
+  for (const auto& node : config["accounts"]) {
+    params_list->emplace_back();
+    load_login_node(node, &params_list->back());
+  }
+  return !params_list->empty();
+}
+
+inline void load_thread_placement(const YAML::Node& node,
+                                  ft::ThreadPlacement* placement) {
+  if (!node) return;
+  if (node["cpu"]) placement->cpu = node["cpu"].as<int>();
+  if (node["fifo_priority"])
+    placement->fifo_priority = node["fifo_priority"].as<int>();
+}
+
+/*
+ * 格式见config/topology.yml，文件名为空时不做任何设置
+ */
+inline bool load_thread_topology(const std::string& file,
+                                 ft::ThreadTopology* topology) {
+  if (file.empty()) return true;
+
+  std::ifstream ifs(file);
+  if (!ifs) return false;
+
+  YAML::Node config = YAML::LoadFile(file);
+  load_thread_placement(config["engine_loop"], &topology->engine_loop);
+  load_thread_placement(config["log_writer"], &topology->log_writer);
+  load_thread_placement(config["pos_publisher"], &topology->pos_publisher);
+  for (const auto& item : config["gateways"]) {
+    auto& threads = topology->gateways.emplace_back();
+    load_thread_placement(item["md"], &threads.md);
+    load_thread_placement(item["trade"], &threads.trade);
+  }
 
+  for (const auto& item : config["strategies"]) {
+    load_thread_placement(item.second,
+                          &topology->strategies[item.first.as<uint32_t>()]);
+  }
   return true;
 }
 
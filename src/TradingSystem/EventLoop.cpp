@@ -0,0 +1,199 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/EventLoop.h"
+
+#include <spdlog/spdlog.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "IPC/spsc_ring.h"
+#include "Utils/Clock.h"
+
+namespace ft {
+
+// 有轮询源时，每隔这么多轮才检查一次fd和定时器，避免每轮都产生系统调用
+static const uint64_t kCheckEventsInterval = 64;
+
+EventLoop::EventLoop() {}
+
+EventLoop::~EventLoop() {
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+  if (timer_fd_ >= 0) close(timer_fd_);
+  if (event_fd_ >= 0) close(event_fd_);
+}
+
+bool EventLoop::init(bool busy_poll, uint64_t spin_count, uint64_t tick_ms) {
+  busy_poll_ = busy_poll;
+  spin_count_ = spin_count;
+  tick_ms_ = tick_ms > 0 ? tick_ms : 1;
+  start_ns_ = now_ns();
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epoll_fd_ < 0 || timer_fd_ < 0 || event_fd_ < 0) {
+    spdlog::error("[EventLoop::init] Failed to create fd");
+    return false;
+  }
+
+  if (!add_fd(timer_fd_, [this] { on_timer(); }) ||
+      !add_fd(event_fd_, [this] { on_wakeup(); }))
+    return false;
+
+  timer_handler_ = &fd_handlers_[timer_fd_];
+  return true;
+}
+
+bool EventLoop::add_fd(int fd, Callback on_readable) {
+  auto& handler = fd_handlers_[fd];
+  handler = std::move(on_readable);
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = &handler;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+    spdlog::error("[EventLoop::add_fd] Failed to add fd {}", fd);
+    fd_handlers_.erase(fd);
+    return false;
+  }
+  return true;
+}
+
+void EventLoop::add_poller(PollFunc poll, PrepareSleepFunc prepare_sleep,
+                           Callback finish_sleep) {
+  pollers_.emplace_back(Poller{std::move(poll), std::move(prepare_sleep),
+                               std::move(finish_sleep)});
+}
+
+void EventLoop::add_timer(uint64_t interval_ms, Callback callback) {
+  // 时间轮只在定时器触发时前进，可能落后于当前时间，到期时间要加上落后的部分
+  uint64_t ticks = (interval_ms + tick_ms_ - 1) / tick_ms_;
+  uint64_t lag = current_tick() - timers_.now_tick();
+  timers_.add(lag + ticks, ticks, std::move(callback));
+  arm_timer();
+}
+
+void EventLoop::run() {
+  is_running_ = true;
+
+  uint64_t round = 0;
+  uint64_t idle_rounds = 0;
+  while (is_running_) {
+    ++round;
+    if (poll_all() > 0) {
+      idle_rounds = 0;
+      // 持续有数据时也要定期检查fd和定时器
+      if (round % kCheckEventsInterval == 0) wait_events(0);
+      continue;
+    }
+
+    ++idle_rounds;
+    if (busy_poll_ || idle_rounds < spin_count_) {
+      if (pollers_.empty() || round % kCheckEventsInterval == 0) {
+        if (wait_events(0) > 0) idle_rounds = 0;
+      } else {
+        cpu_relax();
+      }
+      continue;
+    }
+
+    // 空闲足够长的时间，阻塞等待
+    if (!prepare_sleep()) {
+      idle_rounds = 0;
+      continue;
+    }
+    // 只是被定时器唤醒时不用重新自旋，否则阻塞模式下每个tick都会自旋
+    if (wait_events(-1) > 0) idle_rounds = 0;
+    finish_sleep();
+  }
+}
+
+void EventLoop::stop() {
+  is_running_ = false;
+  wakeup();
+}
+
+std::size_t EventLoop::poll_all() {
+  std::size_t count = 0;
+  for (auto& poller : pollers_) count += poller.poll();
+  return count;
+}
+
+bool EventLoop::prepare_sleep() {
+  for (std::size_t i = 0; i < pollers_.size(); ++i) {
+    auto& poller = pollers_[i];
+    if (!poller.prepare_sleep || poller.prepare_sleep()) continue;
+
+    // 撤销已经准备好的轮询源
+    for (std::size_t j = 0; j < i; ++j) {
+      if (pollers_[j].finish_sleep) pollers_[j].finish_sleep();
+    }
+    return false;
+  }
+  return true;
+}
+
+void EventLoop::finish_sleep() {
+  for (auto& poller : pollers_) {
+    if (poller.finish_sleep) poller.finish_sleep();
+  }
+}
+
+std::size_t EventLoop::wait_events(int timeout_ms) {
+  epoll_event events[64];
+  int n = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+
+  std::size_t count = 0;
+  for (int i = 0; i < n; ++i) {
+    auto* handler = reinterpret_cast<Callback*>(events[i].data.ptr);
+    (*handler)();
+    if (handler != timer_handler_) ++count;
+  }
+  return count;
+}
+
+void EventLoop::on_timer() {
+  uint64_t expirations = 0;
+  if (read(timer_fd_, &expirations, sizeof(expirations)) < 0) return;
+
+  uint64_t tick = current_tick();
+  if (tick > timers_.now_tick()) timers_.advance(tick - timers_.now_tick());
+  arm_timer();
+}
+
+uint64_t EventLoop::current_tick() const {
+  return (now_ns() - start_ns_) / (tick_ms_ * 1000000UL);
+}
+
+void EventLoop::arm_timer() {
+  // 全为0时停止timerfd
+  itimerspec spec{};
+  uint64_t next_tick = timers_.next_expire_tick();
+  if (next_tick > 0) {
+    // 使用绝对时间，处理定时器的耗时不会累积成误差
+    uint64_t expire_ns = start_ns_ + next_tick * tick_ms_ * 1000000UL;
+    spec.it_value.tv_sec = expire_ns / 1000000000UL;
+    spec.it_value.tv_nsec = expire_ns % 1000000000UL;
+  }
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0)
+    spdlog::error("[EventLoop::arm_timer] Failed to set timerfd");
+}
+
+void EventLoop::on_wakeup() {
+  // 只需要清空计数，醒来后run会重新轮询所有数据源
+  uint64_t value;
+  while (read(event_fd_, &value, sizeof(value)) > 0) {
+  }
+}
+
+void EventLoop::wakeup() {
+  uint64_t value = 1;
+  if (write(event_fd_, &value, sizeof(value)) < 0)
+    spdlog::error("[EventLoop::wakeup] Failed to write eventfd");
+}
+
+}  // namespace ft
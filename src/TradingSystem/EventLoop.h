@@ -0,0 +1,125 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_EVENTLOOP_H_
+#define FT_TRADINGSYSTEM_EVENTLOOP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "TradingSystem/TimerWheel.h"
+
+namespace ft {
+
+/*
+ * 基于epoll的单线程事件循环，在同一个线程中处理：
+ *   fd事件：如redis连接、唤醒共享内存队列的命名管道
+ *   轮询源：无法用fd等待的数据源，如共享内存队列，每轮循环都会调用
+ *   定时器：由timerfd驱动的时间轮，timerfd只在最近的定时器到期时触发，
+ *           空闲时不会被定期唤醒
+ *   唤醒：其他线程通过eventfd唤醒阻塞中的事件循环，如stop
+ *
+ * busy_poll模式下一直轮询不睡眠，延迟最低；否则连续空闲spin_count轮之后
+ * 阻塞在epoll_wait上，CPU占用最低
+ */
+class EventLoop {
+ public:
+  using Callback = std::function<void()>;
+  using PollFunc = std::function<std::size_t()>;
+  using PrepareSleepFunc = std::function<bool()>;
+
+  EventLoop();
+
+  ~EventLoop();
+
+  /*
+   * tick_ms是定时器的精度
+   */
+  bool init(bool busy_poll, uint64_t spin_count, uint64_t tick_ms);
+
+  /*
+   * fd可读时回调，使用水平触发，回调中需要读完数据或者下次继续回调
+   */
+  bool add_fd(int fd, Callback on_readable);
+
+  /*
+   * poll在每轮循环中调用，返回处理的数据量
+   * prepare_sleep在睡眠之前调用，返回false表示有新数据，不能睡眠，
+   * 返回true时醒来后会调用finish_sleep
+   */
+  void add_poller(PollFunc poll, PrepareSleepFunc prepare_sleep = nullptr,
+                  Callback finish_sleep = nullptr);
+
+  /*
+   * 添加周期定时器，只能在事件循环线程中调用
+   */
+  void add_timer(uint64_t interval_ms, Callback callback);
+
+  /*
+   * 线程安全，唤醒阻塞中的事件循环，用于通知轮询源有了新数据
+   */
+  void wakeup();
+
+  void run();
+
+  /*
+   * 线程安全
+   */
+  void stop();
+
+ private:
+  struct Poller {
+    PollFunc poll;
+    PrepareSleepFunc prepare_sleep;
+    Callback finish_sleep;
+  };
+
+  std::size_t poll_all();
+
+  bool prepare_sleep();
+
+  void finish_sleep();
+
+  /*
+   * 返回处理的事件数，不包括定时器
+   */
+  std::size_t wait_events(int timeout_ms);
+
+  void on_timer();
+
+  /*
+   * 从init开始经过的tick数
+   */
+  uint64_t current_tick() const;
+
+  /*
+   * 把timerfd设置为在最早的定时器到期时触发一次
+   */
+  void arm_timer();
+
+  void on_wakeup();
+
+ private:
+  int epoll_fd_ = -1;
+  int timer_fd_ = -1;
+  int event_fd_ = -1;
+
+  bool busy_poll_ = false;
+  uint64_t spin_count_ = 0;
+  uint64_t tick_ms_ = 1;
+
+  // std::map的节点地址不会变，可以直接作为epoll_event的data
+  std::map<int, Callback> fd_handlers_;
+  const Callback* timer_handler_ = nullptr;
+  std::vector<Poller> pollers_;
+  TimerWheel timers_;
+  uint64_t start_ns_ = 0;
+
+  std::atomic<bool> is_running_ = false;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_EVENTLOOP_H_
@@ -0,0 +1,92 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/OpenOrderPublisher.h"
+
+#include <spdlog/spdlog.h>
+
+namespace ft {
+
+OpenOrderPublisher::OpenOrderPublisher() {
+  for (uint32_t i = 0; i < kMaxStrategies; ++i) {
+    if (!views_[i].open(proto_open_order_shm_name(i), true)) {
+      spdlog::error(
+          "[OpenOrderPublisher::OpenOrderPublisher] Failed to open shm of "
+          "strategy {}",
+          i);
+      continue;
+    }
+    clear(views_[i].get());
+  }
+}
+
+void OpenOrderPublisher::add(Order* order) {
+  auto* table = get_table(order->strategy_id);
+  if (!table) return;
+
+  // 引擎是唯一的写者，位图不会被其他线程修改
+  uint32_t index = kMaxOpenOrders;
+  for (uint32_t i = 0; i < kMaxOpenOrders / 64; ++i) {
+    uint64_t free_bits = ~table->used[i].load(std::memory_order_relaxed);
+    if (free_bits) {
+      index = i * 64 + __builtin_ctzll(free_bits);
+      break;
+    }
+  }
+
+  if (index == kMaxOpenOrders) {
+    spdlog::warn(
+        "[OpenOrderPublisher::add] Too many open orders of strategy {}. "
+        "OrderID: {}",
+        order->strategy_id, order->order_id);
+    return;
+  }
+
+  order->view_index = index;
+  table->orders[index].store(make_open_order(*order));
+  table->used[index / 64].fetch_or(1UL << (index % 64),
+                                   std::memory_order_release);
+}
+
+void OpenOrderPublisher::update(const Order& order) {
+  if (order.view_index == UINT32_MAX) return;
+
+  auto* table = get_table(order.strategy_id);
+  table->orders[order.view_index].store(make_open_order(order));
+}
+
+void OpenOrderPublisher::remove(Order* order) {
+  if (order->view_index == UINT32_MAX) return;
+
+  uint32_t index = order->view_index;
+  auto* table = get_table(order->strategy_id);
+  table->used[index / 64].fetch_and(~(1UL << (index % 64)),
+                                    std::memory_order_release);
+  table->orders[index].store(OpenOrder{});
+  order->view_index = UINT32_MAX;
+}
+
+void OpenOrderPublisher::clear(OpenOrderTable* table) {
+  // 先清位图，策略不会再读这些槽位，再通过顺序锁清空订单，正在读取的策略
+  // 会重试并读到order_id为0
+  for (auto& bits : table->used) bits.store(0, std::memory_order_release);
+  for (auto& order : table->orders) order.store(OpenOrder{});
+}
+
+OpenOrder OpenOrderPublisher::make_open_order(const Order& order) {
+  OpenOrder open_order;
+  open_order.order_id = order.order_id;
+  open_order.client_order_id = order.client_order_id;
+  open_order.ticker_index = order.contract->index;
+  open_order.direction = order.direction;
+  open_order.offset = order.offset;
+  open_order.type = order.type;
+  open_order.price = order.price;
+  open_order.volume = order.volume;
+  open_order.traded_volume = order.traded_volume;
+  open_order.canceled_volume = order.canceled_volume;
+  open_order.status = order.status;
+  open_order.insert_time = order.insert_time;
+  return open_order;
+}
+
+}  // namespace ft
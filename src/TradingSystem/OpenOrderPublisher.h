@@ -0,0 +1,55 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_OPENORDERPUBLISHER_H_
+#define FT_TRADINGSYSTEM_OPENORDERPUBLISHER_H_
+
+#include <array>
+#include <cstdint>
+
+#include "Core/Protocol.h"
+#include "Core/WireFormat.h"
+#include "IPC/shm.h"
+#include "TradingSystem/Order.h"
+
+namespace ft {
+
+/*
+ * 把每个策略的未结束订单写入共享内存（OpenOrderTable），策略可以直接
+ * 遍历和撤销自己的挂单，不需要和引擎交互
+ *
+ * 构造时打开所有策略的视图并清空上次运行留下的订单，之后策略随时连上来
+ * 看到的都是本次运行的订单。槽位由引擎分配，记录在Order::view_index中，
+ * 空闲的槽位直接从used位图中查找，下单路径上没有内存分配和系统调用
+ *
+ * 和订单状态一样，调用方需要持有TradingEngine::mutex_，单写者模式下只在
+ * 事件循环线程中调用
+ */
+class OpenOrderPublisher {
+ public:
+  OpenOrderPublisher();
+
+  /*
+   * 订单发出后调用，槽位用完时订单不出现在视图中
+   */
+  void add(Order* order);
+
+  void update(const Order& order);
+
+  void remove(Order* order);
+
+ private:
+  OpenOrderTable* get_table(uint32_t strategy_id) const {
+    return strategy_id < kMaxStrategies ? views_[strategy_id].get() : nullptr;
+  }
+
+  static void clear(OpenOrderTable* table);
+
+  static OpenOrder make_open_order(const Order& order);
+
+ private:
+  std::array<ShmSegment<OpenOrderTable>, kMaxStrategies> views_;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_OPENORDERPUBLISHER_H_
@@ -3,28 +3,20 @@
 #ifndef FT_TRADINGSYSTEM_ORDER_H_
 #define FT_TRADINGSYSTEM_ORDER_H_
 
-#include <map>
-#include <string>
+#include <cstdint>
 
 #include "Core/Constants.h"
 #include "Core/Contract.h"
 
 namespace ft {
 
-enum class OrderStatus {
-  CREATED = 0,
-  SUBMITTING,
-  REJECTED,
-  NO_TRADED,
-  PART_TRADED,
-  ALL_TRADED,
-  CANCELED,
-  CANCEL_REJECTED
-};
-
 struct Order {
   const Contract* contract;
   uint64_t order_id;
+  uint32_t strategy_id = 0;
+  uint32_t account_index = 0;        // 订单发往的账户
+  uint32_t view_index = UINT32_MAX;  // 在策略的未结束订单视图中的位置
+  uint64_t client_order_id = 0;
   uint64_t type;
   uint64_t direction;
   uint64_t offset;
@@ -34,19 +26,32 @@ struct Order {
   int64_t canceled_volume = 0;
   OrderStatus status;
   uint64_t insert_time;
+  uint64_t trigger_time = 0;  // 触发下单的行情被网关收到的时间
+  uint64_t sent_time = 0;     // 发送给网关完成的时间
 };
 
-inline const std::string& to_string(OrderStatus s) {
-  static const std::map<OrderStatus, std::string> s_str = {
-      {OrderStatus::SUBMITTING, "Submitting"},
-      {OrderStatus::REJECTED, "Rejected"},
-      {OrderStatus::NO_TRADED, "No traded"},
-      {OrderStatus::PART_TRADED, "Part traded"},
-      {OrderStatus::ALL_TRADED, "All traded"},
-      {OrderStatus::CANCELED, "Canceled"},
-      {OrderStatus::CANCEL_REJECTED, "Cancel rejected"}};
-
-  return s_str.find(s)->second;
+/*
+ * 订单状态是否可以从from转为to。成交回报可能先于委托回报到达，所以
+ * SUBMITTING可以直接转为成交或撤单状态。柜台接受的订单仍可能被交易所
+ * 拒绝，所以NO_TRADED可以转为REJECTED。撤单之后到达的成交回报不改变
+ * CANCELED状态，由handle_order_traded处理
+ */
+inline bool is_valid_transition(OrderStatus from, OrderStatus to) {
+  switch (from) {
+    case OrderStatus::CREATED:
+      return to == OrderStatus::SUBMITTING || to == OrderStatus::REJECTED;
+    case OrderStatus::SUBMITTING:
+      return to != OrderStatus::CREATED && to != OrderStatus::SUBMITTING &&
+             to != OrderStatus::CANCEL_REJECTED;
+    case OrderStatus::NO_TRADED:
+      return to == OrderStatus::PART_TRADED || to == OrderStatus::ALL_TRADED ||
+             to == OrderStatus::CANCELED || to == OrderStatus::REJECTED;
+    case OrderStatus::PART_TRADED:
+      return to == OrderStatus::PART_TRADED || to == OrderStatus::ALL_TRADED ||
+             to == OrderStatus::CANCELED;
+    default:
+      return false;
+  }
 }
 
 }  // namespace ft
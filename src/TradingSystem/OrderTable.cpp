@@ -0,0 +1,93 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/OrderTable.h"
+
+#include "Core/Protocol.h"
+
+namespace ft {
+
+OrderTable::OrderTable(std::size_t capacity) {
+  // 向上取整到2的幂，用掩码代替取模
+  std::size_t size = 1;
+  while (size < capacity) size <<= 1;
+
+  slots_.resize(size);
+  mask_ = size - 1;
+  ticker_heads_.resize(kMaxTickers, kNull);
+  strategy_heads_.resize(kMaxStrategies, kNull);
+}
+
+Order* OrderTable::insert(const Order& order) {
+  uint32_t index = slot_of(order.order_id);
+  auto& slot = slots_[index];
+  if (slot.is_used) return nullptr;
+
+  slot.order = order;
+  slot.is_used = true;
+  link(index, ALL_LIST);
+  link(index, TICKER_LIST);
+  link(index, STRATEGY_LIST);
+  ++size_;
+  return &slot.order;
+}
+
+Order* OrderTable::find(uint64_t order_id) {
+  auto& slot = slots_[slot_of(order_id)];
+  if (!slot.is_used || slot.order.order_id != order_id) return nullptr;
+  return &slot.order;
+}
+
+void OrderTable::erase(uint64_t order_id) {
+  uint32_t index = slot_of(order_id);
+  auto& slot = slots_[index];
+  if (!slot.is_used || slot.order.order_id != order_id) return;
+
+  unlink(index, ALL_LIST);
+  unlink(index, TICKER_LIST);
+  unlink(index, STRATEGY_LIST);
+  slot.is_used = false;
+  --size_;
+}
+
+uint32_t* OrderTable::head_of(const Order& order, ListType list) {
+  switch (list) {
+    case TICKER_LIST: {
+      // 超出预分配范围的ticker很少见，只在第一次出现时扩容
+      uint64_t ticker_index = order.contract->index;
+      if (ticker_index >= ticker_heads_.size())
+        ticker_heads_.resize(ticker_index + 1, kNull);
+      return &ticker_heads_[ticker_index];
+    }
+    case STRATEGY_LIST:
+      if (order.strategy_id >= strategy_heads_.size())
+        strategy_heads_.resize(order.strategy_id + 1, kNull);
+      return &strategy_heads_[order.strategy_id];
+    default:
+      return &all_head_;
+  }
+}
+
+void OrderTable::link(uint32_t slot_index, ListType list) {
+  auto& slot = slots_[slot_index];
+  auto* head = head_of(slot.order, list);
+
+  slot.prev[list] = kNull;
+  slot.next[list] = *head;
+  if (*head != kNull) slots_[*head].prev[list] = slot_index;
+  *head = slot_index;
+}
+
+void OrderTable::unlink(uint32_t slot_index, ListType list) {
+  auto& slot = slots_[slot_index];
+  uint32_t prev = slot.prev[list];
+  uint32_t next = slot.next[list];
+
+  if (prev != kNull)
+    slots_[prev].next[list] = next;
+  else
+    *head_of(slot.order, list) = next;
+
+  if (next != kNull) slots_[next].prev[list] = prev;
+}
+
+}  // namespace ft
@@ -0,0 +1,102 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_ORDERTABLE_H_
+#define FT_TRADINGSYSTEM_ORDERTABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "TradingSystem/Order.h"
+
+namespace ft {
+
+/*
+ * 未结束订单的索引
+ *
+ * order_id是连续递增的，所以直接用order_id % capacity作为槽位，槽位预先
+ * 分配好，插入、查找和删除都是O(1)且不分配内存。每个订单同时挂在三个
+ * 侵入式双向链表上：所有订单、同一个ticker的订单、同一个策略的订单，
+ * 按ticker或策略撤单时只需要遍历相关的订单
+ *
+ * 槽位仍被更早的未结束订单占用时插入失败，capacity需要远大于同时存在的
+ * 订单数
+ */
+class OrderTable {
+ public:
+  explicit OrderTable(std::size_t capacity = 65536);
+
+  /*
+   * 返回插入的订单，槽位被占用时返回nullptr
+   */
+  Order* insert(const Order& order);
+
+  Order* find(uint64_t order_id);
+
+  void erase(uint64_t order_id);
+
+  std::size_t size() const { return size_; }
+
+  std::size_t capacity() const { return slots_.size(); }
+
+  /*
+   * 以下遍历函数的回调中可以删除当前订单
+   */
+  template <class Func>
+  void for_each(Func&& func) {
+    for_each_in(all_head_, ALL_LIST, func);
+  }
+
+  template <class Func>
+  void for_each_of_ticker(uint64_t ticker_index, Func&& func) {
+    if (ticker_index >= ticker_heads_.size()) return;
+    for_each_in(ticker_heads_[ticker_index], TICKER_LIST, func);
+  }
+
+  template <class Func>
+  void for_each_of_strategy(uint32_t strategy_id, Func&& func) {
+    if (strategy_id >= strategy_heads_.size()) return;
+    for_each_in(strategy_heads_[strategy_id], STRATEGY_LIST, func);
+  }
+
+ private:
+  static constexpr uint32_t kNull = UINT32_MAX;
+
+  enum ListType { ALL_LIST = 0, TICKER_LIST, STRATEGY_LIST, kNumLists };
+
+  struct Slot {
+    Order order;
+    bool is_used = false;
+    uint32_t prev[kNumLists];
+    uint32_t next[kNumLists];
+  };
+
+  uint32_t slot_of(uint64_t order_id) const { return order_id & mask_; }
+
+  uint32_t* head_of(const Order& order, ListType list);
+
+  void link(uint32_t slot_index, ListType list);
+
+  void unlink(uint32_t slot_index, ListType list);
+
+  template <class Func>
+  void for_each_in(uint32_t head, ListType list, Func&& func) {
+    for (uint32_t i = head; i != kNull;) {
+      uint32_t next = slots_[i].next[list];
+      func(slots_[i].order);
+      i = next;
+    }
+  }
+
+ private:
+  std::vector<Slot> slots_;
+  uint64_t mask_ = 0;
+  std::size_t size_ = 0;
+
+  uint32_t all_head_ = kNull;
+  std::vector<uint32_t> ticker_heads_;    // 以ticker_index为下标
+  std::vector<uint32_t> strategy_heads_;  // 以strategy_id为下标
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_ORDERTABLE_H_
@@ -8,16 +8,54 @@
 
 namespace ft {
 
-PositionManager::PositionManager(const std::string& ip, int port)
-    : redis_(ip, port) {}
+PositionManager::PositionManager(IpcTransport transport, bool redis_monitor,
+                                 const std::string& ip, int port) {
+  if (transport == IpcTransport::SHM) {
+    if (pos_shm_.open(POSITION_SHM_NAME, true))
+      pos_table_ = pos_shm_.get();
+    else
+      spdlog::error("[PositionManager::PositionManager] Failed to open shm");
+  }
+
+  if (transport == IpcTransport::REDIS || redis_monitor)
+    redis_publisher_ = std::make_unique<PositionPublisher>(ip, port);
+}
+
+void PositionManager::set_publisher_placement(
+    const ThreadPlacement& placement) {
+  if (!redis_publisher_) return;
+
+  redis_publisher_->set_placement(placement);
+  report_thread_placement(redis_publisher_->native_handle(), "pos_publisher");
+}
+
+void PositionManager::publish(const Position& pos) {
+  if (pos_table_ && pos.ticker_index < kMaxTickers)
+    pos_table_->positions[pos.ticker_index].store(pos);
+
+  if (redis_publisher_) redis_publisher_->publish_position(pos);
+}
+
+void PositionManager::publish_realized_pnl() {
+  if (pos_table_) pos_table_->realized_pnl.store(realized_pnl_);
+
+  if (redis_publisher_) redis_publisher_->publish_realized_pnl(realized_pnl_);
+}
+
+void PositionManager::publish_float_pnl() {
+  if (pos_table_) pos_table_->float_pnl.store(float_pnl_);
+
+  if (redis_publisher_) redis_publisher_->publish_float_pnl(float_pnl_);
+}
 
 void PositionManager::set_position(const Position* pos) {
-  pos_map_.emplace(pos->ticker_index, *pos);
+  auto& old_pos = find_or_create_pos(pos->ticker_index);
+  float_pnl_ -= old_pos.long_pos.float_pnl + old_pos.short_pos.float_pnl;
+  old_pos = *pos;
+  float_pnl_ += pos->long_pos.float_pnl + pos->short_pos.float_pnl;
 
-  const auto* contract = ContractTable::get_by_index(pos->ticker_index);
-  assert(contract);
-  auto key = proto_pos_key(contract->ticker);
-  redis_.set(key, pos, sizeof(Position));
+  publish(*pos);
+  publish_float_pnl();
 }
 
 void PositionManager::update_pending(uint64_t ticker_index, uint64_t direction,
@@ -44,9 +82,7 @@ void PositionManager::update_pending(uint64_t ticker_index, uint64_t direction,
     spdlog::warn("[Portfolio::update_pending] correct close_pending");
   }
 
-  const auto* contract = ContractTable::get_by_index(pos.ticker_index);
-  assert(contract);
-  redis_.set(proto_pos_key(contract->ticker), &pos, sizeof(pos));
+  publish(pos);
 }
 
 void PositionManager::update_traded(uint64_t ticker_index, uint64_t direction,
@@ -105,12 +141,14 @@ void PositionManager::update_traded(uint64_t ticker_index, uint64_t direction,
   }
 
   if (pos_detail.volume == 0) {
+    float_pnl_ -= pos_detail.float_pnl;
     pos_detail.float_pnl = 0;
     pos_detail.cost_price = 0;
   }
 
-  redis_.set(proto_pos_key(contract->ticker), &pos, sizeof(pos));
-  redis_.set("realized_pnl", &realized_pnl_, sizeof(realized_pnl_));
+  publish(pos);
+  publish_realized_pnl();
+  publish_float_pnl();
 }
 
 void PositionManager::update_float_pnl(uint64_t ticker_index,
@@ -122,6 +160,7 @@ void PositionManager::update_float_pnl(uint64_t ticker_index,
 
     auto& lp = pos->long_pos;
     auto& sp = pos->short_pos;
+    double old_float_pnl = lp.float_pnl + sp.float_pnl;
 
     if (lp.volume > 0)
       lp.float_pnl = lp.volume * contract->size * (last_price - lp.cost_price);
@@ -129,8 +168,11 @@ void PositionManager::update_float_pnl(uint64_t ticker_index,
     if (sp.volume > 0)
       sp.float_pnl = sp.volume * contract->size * (sp.cost_price - last_price);
 
-    if (lp.volume > 0 || sp.volume > 0)
-      redis_.set(proto_pos_key(contract->ticker), pos, sizeof(*pos));
+    if (lp.volume > 0 || sp.volume > 0) {
+      float_pnl_ += lp.float_pnl + sp.float_pnl - old_float_pnl;
+      publish(*pos);
+      publish_float_pnl();
+    }
   }
 }
 
@@ -8,13 +8,22 @@
 #include <string>
 
 #include "Core/Position.h"
-#include "IPC/redis.h"
+#include "Core/Protocol.h"
+#include "Core/WireFormat.h"
+#include "IPC/shm.h"
+#include "TradingSystem/PositionPublisher.h"
 
 namespace ft {
 
 class PositionManager {
  public:
-  PositionManager(const std::string& ip, int port);
+  /*
+   * transport为REDIS时仓位只写入redis
+   * transport为SHM时仓位写入共享内存，如果redis_monitor为true则同时写入redis供监控使用
+   * 写redis都是在后台线程中异步进行的
+   */
+  PositionManager(IpcTransport transport, bool redis_monitor,
+                  const std::string& ip, int port);
 
   void set_position(const Position* pos);
 
@@ -26,7 +35,21 @@ class PositionManager {
 
   void update_float_pnl(uint64_t ticker_index, double last_price);
 
+  /*
+   * 设置写redis的后台线程的位置并输出，没有后台线程时什么都不做
+   */
+  void set_publisher_placement(const ThreadPlacement& placement);
+
  private:
+  /*
+   * 把仓位发布给策略，写入共享内存仓位表和（或）redis中的pos-<ticker>
+   */
+  void publish(const Position& pos);
+
+  void publish_realized_pnl();
+
+  void publish_float_pnl();
+
   Position* find(uint64_t ticker_index) {
     auto iter = pos_map_.find(ticker_index);
     if (iter == pos_map_.end()) return nullptr;
@@ -44,9 +67,13 @@ class PositionManager {
   }
 
  private:
-  RedisSession redis_;
+  std::unique_ptr<PositionPublisher> redis_publisher_;
+  ShmSegment<PositionTable> pos_shm_;
+  PositionTable* pos_table_ = nullptr;
+
   std::map<uint64_t, Position> pos_map_;
   double realized_pnl_ = 0;
+  double float_pnl_ = 0;
 };
 
 }  // namespace ft
@@ -0,0 +1,120 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/PositionPublisher.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+#include "Core/ContractTable.h"
+#include "Core/Protocol.h"
+#include "Core/WireFormat.h"
+
+namespace ft {
+
+PositionPublisher::PositionPublisher(const std::string& ip, int port)
+    : redis_(ip, port), queue_(std::make_unique<SpscRing<Update, 4096>>()) {
+  thread_ = std::thread([this] { run(); });
+}
+
+PositionPublisher::~PositionPublisher() {
+  is_running_ = false;
+  thread_.join();
+}
+
+void PositionPublisher::publish_position(const Position& pos) {
+  Update update;
+  update.type = Update::POSITION;
+  update.pos = pos;
+  push(update);
+}
+
+void PositionPublisher::publish_realized_pnl(double realized_pnl) {
+  Update update;
+  update.type = Update::REALIZED_PNL;
+  update.pnl = realized_pnl;
+  push(update);
+}
+
+void PositionPublisher::publish_float_pnl(double float_pnl) {
+  Update update;
+  update.type = Update::FLOAT_PNL;
+  update.pnl = float_pnl;
+  push(update);
+}
+
+void PositionPublisher::push(const Update& update) {
+  if (queue_->push(update)) return;
+
+  // 队列满说明redis严重落后，仓位更新不能丢，只能等待
+  spdlog::warn("[PositionPublisher::push] Queue is full");
+  while (!queue_->push(update)) cpu_relax();
+}
+
+void PositionPublisher::run() {
+  while (is_running_) {
+    if (flush() == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  flush();
+}
+
+std::size_t PositionPublisher::flush() {
+  std::size_t num_updates = 0;
+  Update update;
+  while (queue_->pop(&update)) {
+    ++num_updates;
+    switch (update.type) {
+      case Update::POSITION:
+        pending_pos_[update.pos.ticker_index] = update.pos;
+        break;
+      case Update::REALIZED_PNL:
+        realized_pnl_ = update.pnl;
+        realized_pnl_dirty_ = true;
+        break;
+      case Update::FLOAT_PNL:
+        float_pnl_ = update.pnl;
+        float_pnl_dirty_ = true;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (num_updates == 0) return 0;
+
+  std::size_t num_writes = 0;
+  for (const auto& [ticker_index, pos] : pending_pos_) {
+    const auto* contract = ContractTable::get_by_index(ticker_index);
+    if (!contract) continue;
+
+    WireMsg<Position> msg;
+    msg.set_header(pos_seq_++);
+    msg.body[0] = pos;
+    redis_.append_set(proto_pos_key(contract->ticker), msg.data(), msg.size());
+    ++num_writes;
+  }
+  pending_pos_.clear();
+
+  if (realized_pnl_dirty_) {
+    redis_.append_set("realized_pnl", &realized_pnl_, sizeof(realized_pnl_));
+    realized_pnl_dirty_ = false;
+    ++num_writes;
+  }
+
+  if (float_pnl_dirty_) {
+    redis_.append_set("float_pnl", &float_pnl_, sizeof(float_pnl_));
+    float_pnl_dirty_ = false;
+    ++num_writes;
+  }
+
+  redis_.flush_pipeline();
+
+  spdlog::debug(
+      "[PositionPublisher::flush] Updates: {}, Writes: {}, Coalesced: {}",
+      num_updates, num_writes, num_updates - num_writes);
+  return num_updates;
+}
+
+}  // namespace ft
@@ -0,0 +1,81 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_POSITIONPUBLISHER_H_
+#define FT_TRADINGSYSTEM_POSITIONPUBLISHER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Core/Position.h"
+#include "IPC/redis.h"
+#include "IPC/spsc_ring.h"
+#include "Utils/ThreadAffinity.h"
+
+namespace ft {
+
+/*
+ * 在后台线程中把仓位和盈亏写入redis，避免引擎线程阻塞在redis命令上
+ *
+ * 调用方只是把更新放入无锁队列，后台线程每次把队列中的更新全部取出，
+ * 同一个key的多次更新只保留最新的一次，然后用pipeline一次性写入redis
+ *
+ * 队列是单生产者的，调用方需要保证同一时刻只有一个线程在调用publish_xxx，
+ * PositionManager的所有调用都在TradingEngine::mutex_的保护下（单写者模式
+ * 下都在事件循环线程中），满足这个条件
+ */
+class PositionPublisher {
+ public:
+  PositionPublisher(const std::string& ip, int port);
+
+  ~PositionPublisher();
+
+  void publish_position(const Position& pos);
+
+  void publish_realized_pnl(double realized_pnl);
+
+  void publish_float_pnl(double float_pnl);
+
+  void set_placement(const ThreadPlacement& placement) {
+    apply_thread_placement(thread_.native_handle(), "pos_publisher",
+                           placement);
+  }
+
+  pthread_t native_handle() { return thread_.native_handle(); }
+
+ private:
+  struct Update {
+    enum Type : uint32_t { POSITION = 0, REALIZED_PNL, FLOAT_PNL };
+
+    uint32_t type;
+    double pnl;
+    Position pos;
+  };
+
+  void push(const Update& update);
+
+  void run();
+
+  std::size_t flush();
+
+ private:
+  RedisSession redis_;
+  std::unique_ptr<SpscRing<Update, 4096>> queue_;
+  std::atomic<bool> is_running_ = true;
+
+  // 以下只在后台线程中访问
+  std::map<uint64_t, Position> pending_pos_;
+  uint64_t pos_seq_ = 0;
+  double realized_pnl_ = 0;
+  double float_pnl_ = 0;
+  bool realized_pnl_dirty_ = false;
+  bool float_pnl_dirty_ = false;
+
+  std::thread thread_;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_POSITIONPUBLISHER_H_
@@ -0,0 +1,127 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/StrategyHost.h"
+
+#include <dlfcn.h>
+
+#include <utility>
+
+namespace ft {
+
+StrategyHost::~StrategyHost() {
+  // 策略的析构函数在.so中，先析构再卸载
+  for (auto& hosted : strategies_) {
+    hosted.strategy.reset();
+    dlclose(hosted.handle);
+  }
+}
+
+bool StrategyHost::load(const std::string& file, uint32_t strategy_id,
+                        IpcTransport pos_transport,
+                        AlgoTradeContext::CmdHandler handler) {
+  if (is_hosted(strategy_id)) {
+    spdlog::error("[StrategyHost::load] Duplicate strategy id: {}",
+                  strategy_id);
+    return false;
+  }
+
+  void* handle = dlopen(file.c_str(), RTLD_NOW);
+  if (!handle) {
+    spdlog::error("[StrategyHost::load] Invalid strategy .so: {}. error: {}",
+                  file, dlerror());
+    return false;
+  }
+
+  auto create_strategy =
+      reinterpret_cast<Strategy* (*)()>(dlsym(handle, "create_strategy"));
+  if (!create_strategy) {
+    spdlog::error("[StrategyHost::load] create_strategy not found in {}",
+                  file);
+    dlclose(handle);
+    return false;
+  }
+
+  HostedStrategy hosted{handle, std::unique_ptr<Strategy>(create_strategy())};
+  auto* strategy = hosted.strategy.get();
+  if (!strategy->set_pos_transport(pos_transport)) {
+    spdlog::error("[StrategyHost::load] Failed to init pos transport");
+    hosted.strategy.reset();
+    dlclose(handle);
+    return false;
+  }
+
+  // on_init中的下单需要能收到回报，先登记再初始化
+  if (strategy_id >= id2strategy_.size())
+    id2strategy_.resize(strategy_id + 1, nullptr);
+  id2strategy_[strategy_id] = strategy;
+  strategies_.emplace_back(std::move(hosted));
+
+  if (!strategy->init_in_process(strategy_id, std::move(handler))) {
+    spdlog::error("[StrategyHost::load] Failed to init strategy {}",
+                  strategy_id);
+    id2strategy_[strategy_id] = nullptr;
+    strategies_.back().strategy.reset();
+    dlclose(strategies_.back().handle);
+    strategies_.pop_back();
+    return false;
+  }
+
+  spdlog::info("[StrategyHost::load] Strategy {} loaded from {}", strategy_id,
+               file);
+  return true;
+}
+
+bool StrategyHost::push_tick(const TickData& tick, uint64_t engine_time) {
+  TickData stamped = tick;
+  stamped.engine_time = engine_time;
+
+  // 不能阻塞行情线程，事件循环处理不过来时丢弃
+  if (!ticks_->push(stamped)) {
+    dropped_ticks_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool StrategyHost::push_bar(const BarData& bar) {
+  if (!bars_->push(bar)) {
+    spdlog::warn("[StrategyHost::push_bar] Bar queue is full. TickerIndex: {}",
+                 bar.ticker_index);
+    return false;
+  }
+  return true;
+}
+
+std::size_t StrategyHost::poll() {
+  std::size_t count = 0;
+
+  // 回调中产生的新回报留到下一轮，不会在遍历时修改pending_events_
+  if (!pending_events_.empty()) {
+    events_.swap(pending_events_);
+    for (const auto& event : events_) {
+      auto* strategy = id2strategy_[event.strategy_id];
+      if (strategy) strategy->dispatch_order_event(&event);
+    }
+    count += events_.size();
+    events_.clear();
+  }
+
+  while (const auto* tick = ticks_->front()) {
+    for (auto& hosted : strategies_) hosted.strategy->dispatch_tick(tick);
+    ticks_->pop_front();
+    ++count;
+  }
+
+  while (const auto* bar = bars_->front()) {
+    for (auto& hosted : strategies_) hosted.strategy->dispatch_bar(bar);
+    bars_->pop_front();
+    ++count;
+  }
+  return count;
+}
+
+void StrategyHost::dump_latency() const {
+  for (const auto& hosted : strategies_) hosted.strategy->dump_latency();
+}
+
+}  // namespace ft
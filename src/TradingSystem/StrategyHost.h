@@ -0,0 +1,104 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_STRATEGYHOST_H_
+#define FT_TRADINGSYSTEM_STRATEGYHOST_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/BarData.h"
+#include "Core/Protocol.h"
+#include "Core/TickData.h"
+#include "IPC/spsc_ring.h"
+#include "Strategy/Strategy.h"
+
+namespace ft {
+
+/*
+ * 在引擎进程内运行的策略
+ *
+ * 策略仍然是EXPORT_STRATEGY导出的.so，和strategy_loader加载的是同一个
+ * 文件。所有策略回调都在引擎的事件循环线程中进行，策略下单直接调用引擎
+ * 处理指令的函数，订单回报也直接回调，不经过redis或共享内存
+ *
+ * 行情由行情回调线程通过push_tick放入无锁队列；订单回报在引擎处理指令或
+ * 回报的过程中产生，先缓存起来，等到poll时再回调，避免策略在回调中下单
+ * 时重入引擎
+ */
+class StrategyHost {
+ public:
+  StrategyHost()
+      : ticks_(std::make_unique<TickRing>()),
+        bars_(std::make_unique<BarRing>()) {}
+
+  ~StrategyHost();
+
+  /*
+   * 加载.so并调用策略的on_init，on_init中就可以下单
+   */
+  bool load(const std::string& file, uint32_t strategy_id,
+            IpcTransport pos_transport, AlgoTradeContext::CmdHandler handler);
+
+  bool empty() const { return strategies_.empty(); }
+
+  bool is_hosted(uint32_t strategy_id) const {
+    return strategy_id < id2strategy_.size() && id2strategy_[strategy_id];
+  }
+
+  /*
+   * 只在行情回调线程中调用，队列满时丢弃行情并返回false
+   */
+  bool push_tick(const TickData& tick, uint64_t engine_time);
+
+  /*
+   * 在行情回调线程和事件循环线程中都会调用，调用方持有引擎的md_mutex_，
+   * 队列满时丢弃bar并返回false
+   */
+  bool push_bar(const BarData& bar);
+
+  // 以下函数只在事件循环线程中调用
+  void push_order_event(const OrderEvent& event) {
+    pending_events_.emplace_back(event);
+  }
+
+  /*
+   * 先回调缓存的订单回报，再回调队列中的行情和bar，返回处理的数量
+   */
+  std::size_t poll();
+
+  bool has_pending() const {
+    return !pending_events_.empty() || !ticks_->empty() || !bars_->empty();
+  }
+
+  void dump_latency() const;
+
+  uint64_t dropped_ticks() const {
+    return dropped_ticks_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using TickRing = SpscRing<TickData, 4096>;
+  using BarRing = SpscRing<BarData, 1024>;
+
+  struct HostedStrategy {
+    void* handle;
+    std::unique_ptr<Strategy> strategy;
+  };
+
+  std::vector<HostedStrategy> strategies_;
+  std::vector<Strategy*> id2strategy_;
+
+  std::unique_ptr<TickRing> ticks_;
+  std::atomic<uint64_t> dropped_ticks_ = 0;
+  std::unique_ptr<BarRing> bars_;
+
+  std::vector<OrderEvent> pending_events_;
+  std::vector<OrderEvent> events_;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_STRATEGYHOST_H_
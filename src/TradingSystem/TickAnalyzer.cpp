@@ -0,0 +1,86 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/TickAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ft {
+
+namespace {
+
+using VecU64 = uint64_t __attribute__((vector_size(32)));
+
+constexpr int kAnalyzedLevels = 5;
+
+/*
+ * 累加前n档，每次处理4档，不足4档的部分逐个累加
+ */
+uint64_t sum_levels(const uint64_t* values, int n) {
+  VecU64 acc{};
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    VecU64 v;
+    memcpy(&v, values + i, sizeof(v));
+    acc += v;
+  }
+
+  uint64_t sum = acc[0] + acc[1] + acc[2] + acc[3];
+  for (; i < n; ++i) sum += values[i];
+  return sum;
+}
+
+double imbalance(uint64_t bid_volume, uint64_t ask_volume) {
+  uint64_t total = bid_volume + ask_volume;
+  if (total == 0) return 0;
+  return (static_cast<double>(bid_volume) - static_cast<double>(ask_volume)) /
+         static_cast<double>(total);
+}
+
+}  // namespace
+
+void TickAnalyzer::analyze(const Contract& contract, TickData* tick) {
+  auto& analytics = tick->analytics;
+  analytics = TickAnalytics();
+
+  int levels = std::clamp(tick->level, 0, kAnalyzedLevels);
+  analytics.bid_depth_l5 = sum_levels(tick->bid_volume, levels);
+  analytics.ask_depth_l5 = sum_levels(tick->ask_volume, levels);
+  analytics.imbalance_l5 =
+      imbalance(analytics.bid_depth_l5, analytics.ask_depth_l5);
+
+  double bid = tick->bid[0];
+  double ask = tick->ask[0];
+  uint64_t bid_volume = tick->bid_volume[0];
+  uint64_t ask_volume = tick->ask_volume[0];
+  analytics.imbalance_l1 = imbalance(bid_volume, ask_volume);
+
+  if (bid > 0 && ask > 0) {
+    analytics.mid_price = (bid + ask) / 2;
+    analytics.micro_price =
+        bid_volume + ask_volume > 0
+            ? (bid * ask_volume + ask * bid_volume) / (bid_volume + ask_volume)
+            : analytics.mid_price;
+    if (contract.price_tick > 0)
+      analytics.spread_ticks = std::llround((ask - bid) / contract.price_tick);
+  }
+
+  if (tick->ticker_index >= last_.size()) return;
+
+  // 第一条行情没有增量；累计值变小说明是新的交易日，从0开始计算
+  auto& last = last_[tick->ticker_index];
+  if (last.has_last) {
+    analytics.volume_delta = tick->volume >= last.volume
+                                 ? tick->volume - last.volume
+                                 : tick->volume;
+    analytics.turnover_delta = tick->turnover >= last.turnover
+                                   ? tick->turnover - last.turnover
+                                   : tick->turnover;
+  }
+  last.volume = tick->volume;
+  last.turnover = tick->turnover;
+  last.has_last = true;
+}
+
+}  // namespace ft
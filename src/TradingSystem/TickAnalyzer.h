@@ -0,0 +1,41 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_TICKANALYZER_H_
+#define FT_TRADINGSYSTEM_TICKANALYZER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Core/Contract.h"
+#include "Core/TickData.h"
+
+namespace ft {
+
+/*
+ * 在引擎转发行情前计算TickAnalytics
+ *
+ * 多档的累加用4路的向量计算，没有开启AVX时编译为两条SSE2指令。成交量和
+ * 成交额的增量相对于同一合约上一条发布的行情，每个合约只需要记录上一次
+ * 的累计值
+ *
+ * 和TickFilter一样只在行情回调线程中调用
+ */
+class TickAnalyzer {
+ public:
+  explicit TickAnalyzer(std::size_t num_tickers) : last_(num_tickers) {}
+
+  void analyze(const Contract& contract, TickData* tick);
+
+ private:
+  struct LastTotal {
+    uint64_t volume = 0;
+    uint64_t turnover = 0;
+    bool has_last = false;
+  };
+
+  std::vector<LastTotal> last_;  // 以ticker_index为下标
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_TICKANALYZER_H_
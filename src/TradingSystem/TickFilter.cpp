@@ -0,0 +1,84 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/TickFilter.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstddef>
+#include <cstring>
+
+#include "Core/ContractTable.h"
+#include "Utils/Counter.h"
+
+namespace ft {
+
+TickFilter::TickFilter(std::size_t num_tickers, bool dedup, bool conflate)
+    : slots_(num_tickers), dedup_(dedup), conflate_(conflate) {}
+
+bool TickFilter::filter(const TickData& tick) {
+  if (tick.ticker_index >= slots_.size()) return true;
+
+  auto& slot = slots_[tick.ticker_index];
+  increase_counter(&slot.received);
+  if (!dedup_ && !conflate_) return true;
+
+  if (slot.has_last) {
+    if (dedup_ && is_same_tick(tick, slot.last)) {
+      increase_counter(&slot.duplicated);
+      return false;
+    }
+    if (conflate_ && is_same_top(tick, slot.last)) {
+      increase_counter(&slot.conflated);
+      return false;
+    }
+  }
+
+  slot.last = tick;
+  slot.has_last = true;
+  return true;
+}
+
+/*
+ * 不比较gateway_time和engine_time，同一个快照每次推送时都不同。按字段
+ * 分段memcmp，跳过level之后的填充字节
+ */
+bool TickFilter::is_same_tick(const TickData& lhs, const TickData& rhs) {
+  constexpr std::size_t kScalarsBegin = offsetof(TickData, date);
+  constexpr std::size_t kScalarsEnd = offsetof(TickData, level);
+  constexpr std::size_t kBookBegin = offsetof(TickData, ask);
+  constexpr std::size_t kBookEnd = offsetof(TickData, gateway_time);
+
+  const auto* l = reinterpret_cast<const char*>(&lhs);
+  const auto* r = reinterpret_cast<const char*>(&rhs);
+  return lhs.level == rhs.level &&
+         memcmp(l + kBookBegin, r + kBookBegin, kBookEnd - kBookBegin) == 0 &&
+         memcmp(l + kScalarsBegin, r + kScalarsBegin,
+                kScalarsEnd - kScalarsBegin) == 0;
+}
+
+bool TickFilter::is_same_top(const TickData& lhs, const TickData& rhs) {
+  return lhs.last_price == rhs.last_price && lhs.bid[0] == rhs.bid[0] &&
+         lhs.ask[0] == rhs.ask[0] && lhs.bid_volume[0] == rhs.bid_volume[0] &&
+         lhs.ask_volume[0] == rhs.ask_volume[0];
+}
+
+void TickFilter::report(const char* name) {
+  for (std::size_t i = 0; i < slots_.size(); ++i) {
+    auto& slot = slots_[i];
+    Counters now;
+    now.received = slot.received.load(std::memory_order_relaxed);
+    if (now.received == slot.reported.received) continue;
+    now.duplicated = slot.duplicated.load(std::memory_order_relaxed);
+    now.conflated = slot.conflated.load(std::memory_order_relaxed);
+
+    const auto* contract = ContractTable::get_by_index(i);
+    spdlog::info("[{}] Ticks of {}: received {}, duplicated {}, conflated {}",
+                 name, contract ? contract->ticker : std::to_string(i),
+                 now.received - slot.reported.received,
+                 now.duplicated - slot.reported.duplicated,
+                 now.conflated - slot.reported.conflated);
+    slot.reported = now;
+  }
+}
+
+}  // namespace ft
@@ -0,0 +1,71 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_TICKFILTER_H_
+#define FT_TRADINGSYSTEM_TICKFILTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Core/TickData.h"
+
+namespace ft {
+
+/*
+ * 在引擎转发行情前过滤掉没有新信息的行情
+ *
+ * CTP经常重复推送完全相同的快照（时间、成交量和盘口都相同），每个合约
+ * 保存最后一次转发的行情，和它完全相同的行情直接丢弃。开启conflate时，
+ * 最新价和买一卖一的价量都没有变化的行情也不再转发，策略只会在盘口变化
+ * 时被唤醒
+ *
+ * 只在行情回调线程中调用filter，多个账户的行情线程由调用方互斥。统计
+ * 计数可以在其他线程中读取
+ */
+class TickFilter {
+ public:
+  TickFilter(std::size_t num_tickers, bool dedup, bool conflate);
+
+  /*
+   * 返回true表示需要转发，此时tick成为这个合约最后一次转发的行情
+   */
+  bool filter(const TickData& tick);
+
+  /*
+   * 输出上次输出以来有行情的合约的计数，只能在同一个线程中调用
+   */
+  void report(const char* name);
+
+ private:
+  struct Counters {
+    uint64_t received = 0;
+    uint64_t duplicated = 0;
+    uint64_t conflated = 0;
+  };
+
+  struct Slot {
+    TickData last;
+    bool has_last = false;
+
+    // 只有行情线程写入，用relaxed的load+store代替原子加
+    std::atomic<uint64_t> received = 0;
+    std::atomic<uint64_t> duplicated = 0;
+    std::atomic<uint64_t> conflated = 0;
+
+    // 上次输出时的计数，只在输出的线程中访问
+    Counters reported;
+  };
+
+  static bool is_same_tick(const TickData& lhs, const TickData& rhs);
+
+  static bool is_same_top(const TickData& lhs, const TickData& rhs);
+
+ private:
+  std::vector<Slot> slots_;  // 以ticker_index为下标
+  bool dedup_;
+  bool conflate_;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_TICKFILTER_H_
@@ -0,0 +1,63 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/TimerWheel.h"
+
+#include <utility>
+
+namespace ft {
+
+TimerWheel::TimerWheel(uint64_t num_slots) : slots_(num_slots) {}
+
+void TimerWheel::add(uint64_t delay, uint64_t interval, Callback callback) {
+  Timer timer;
+  // 至少在下一个tick触发
+  timer.expire_tick = now_tick_ + (delay > 0 ? delay : 1);
+  timer.interval = interval;
+  timer.callback = std::move(callback);
+  schedule(std::move(timer));
+  ++num_timers_;
+}
+
+void TimerWheel::advance(uint64_t ticks) {
+  for (uint64_t i = 0; i < ticks; ++i) {
+    ++now_tick_;
+
+    // 回调中可能会添加新的定时器，所以先把当前槽位取出来
+    std::vector<Timer> slot;
+    slot.swap(slots_[now_tick_ % slots_.size()]);
+
+    for (auto& timer : slot) {
+      // 还没到最后一圈
+      if (timer.expire_tick > now_tick_) {
+        schedule(std::move(timer));
+        continue;
+      }
+
+      timer.callback();
+
+      if (timer.interval == 0) {
+        --num_timers_;
+        continue;
+      }
+
+      timer.expire_tick = now_tick_ + timer.interval;
+      schedule(std::move(timer));
+    }
+  }
+}
+
+uint64_t TimerWheel::next_expire_tick() const {
+  uint64_t next = 0;
+  for (const auto& slot : slots_) {
+    for (const auto& timer : slot) {
+      if (next == 0 || timer.expire_tick < next) next = timer.expire_tick;
+    }
+  }
+  return next;
+}
+
+void TimerWheel::schedule(Timer&& timer) {
+  slots_[timer.expire_tick % slots_.size()].emplace_back(std::move(timer));
+}
+
+}  // namespace ft
@@ -0,0 +1,60 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_TRADINGSYSTEM_TIMERWHEEL_H_
+#define FT_TRADINGSYSTEM_TIMERWHEEL_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ft {
+
+/*
+ * 时间轮，以tick为单位，由调用方驱动（advance）
+ * 定时器按到期的tick放入对应的槽位，每次advance只需要检查经过的槽位，
+ * 添加和触发都是O(1)。到期时间超过一圈的定时器留在槽位中，直到最后一圈
+ */
+class TimerWheel {
+ public:
+  using Callback = std::function<void()>;
+
+  explicit TimerWheel(uint64_t num_slots = 512);
+
+  /*
+   * 添加一个在delay个tick后到期的定时器，interval不为0时按interval周期触发
+   */
+  void add(uint64_t delay, uint64_t interval, Callback callback);
+
+  /*
+   * 时间前进ticks个tick，依次触发到期的定时器
+   */
+  void advance(uint64_t ticks);
+
+  bool empty() const { return num_timers_ == 0; }
+
+  uint64_t now_tick() const { return now_tick_; }
+
+  /*
+   * 最早到期的定时器的tick，没有定时器时返回0
+   * 需要遍历所有槽位，只适合在定时器触发之后调用
+   */
+  uint64_t next_expire_tick() const;
+
+ private:
+  struct Timer {
+    uint64_t expire_tick;
+    uint64_t interval;
+    Callback callback;
+  };
+
+  void schedule(Timer&& timer);
+
+ private:
+  std::vector<std::vector<Timer>> slots_;
+  uint64_t now_tick_ = 0;
+  uint64_t num_timers_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_TRADINGSYSTEM_TIMERWHEEL_H_
@@ -2,28 +2,143 @@
 
 #include "TradingSystem/TradingEngine.h"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #include "Core/ContractTable.h"
 #include "Core/Protocol.h"
+#include "Core/WireFormat.h"
+#include "RiskManagement/NoSelfTrade.h"
+#include "RiskManagement/OrderSizeLimit.h"
+#include "RiskManagement/RiskRuleChain.h"
+#include "RiskManagement/VelocityLimit.h"
+#include "Utils/Clock.h"
+#include "Utils/DeferredLog.h"
+#include "Utils/LatencyRecorder.h"
 
 namespace ft {
 
-TradingEngine::TradingEngine()
-    : portfolio_("127.0.0.1", 6379),
-      tick_redis_("127.0.0.1", 6379),
-      order_redis_("127.0.0.1", 6379) {}
+// 按顺序检查，开销小的规则放在前面
+using EngineRiskRules =
+    RiskRuleChain<OrderSizeLimit, NoSelfTradeRule, VelocityLimit>;
+
+TradingEngine::TradingEngine(const EngineConfig& config)
+    : config_(config),
+      portfolio_(config.pos_transport, config.pos_redis_monitor, "127.0.0.1",
+                 6379),
+      tick_filter_(ContractTable::size() + 1, config.tick_dedup,
+                   config.tick_conflate),
+      tick_analyzer_(ContractTable::size() + 1) {
+  if (config_.md_transport == IpcTransport::REDIS) {
+    tick_redis_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+    event_redis_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+  } else {
+    if (md_shm_.open(MD_SHM_NAME, true))
+      md_ = md_shm_.get();
+    else
+      spdlog::error("[TradingEngine::TradingEngine] Failed to open shm of md");
+    event_shm_.resize(kMaxStrategies);
+    event_backlogs_.resize(kMaxStrategies);
+  }
+
+  // 进程内策略的回调和下单都在事件循环线程中，订单状态也只能在这个线程中
+  // 访问，否则策略在回调中下单时会重入引擎
+  if (!config_.inproc_strategies.empty() && !config_.single_writer) {
+    spdlog::info(
+        "[TradingEngine::TradingEngine] In-process strategies require "
+        "single-writer mode. Enable it");
+    config_.single_writer = true;
+  }
+
+  if (config_.risk_check) {
+    risk_mgr_ = std::make_unique<EngineRiskRules>(
+        OrderSizeLimit(), NoSelfTradeRule(),
+        VelocityLimit(config_.velocity_period_ms, config_.velocity_order_limit,
+                      config_.velocity_volume_limit));
+  }
 
-TradingEngine::~TradingEngine() {}
+  // 行情线程在登录后就开始回调，提前创建好，策略在run中加载
+  if (!config_.inproc_strategies.empty())
+    strategy_host_ = std::make_unique<StrategyHost>();
+
+  if (!config_.bar_specs.empty()) {
+    std::vector<BarSpec> specs;
+    std::vector<TradingSession> sessions;
+    if (BarAggregator::parse_specs(config_.bar_specs, &specs) &&
+        BarAggregator::parse_sessions(config_.bar_sessions, &sessions)) {
+      bar_aggregator_ = std::make_unique<BarAggregator>(
+          ContractTable::size() + 1, std::move(specs), std::move(sessions),
+          config_.bar_update_ms, [this](const BarData& bar) {
+            publish_bar(bar);
+          });
+    } else {
+      spdlog::error(
+          "[TradingEngine::TradingEngine] Invalid bar config. Bars: {}, "
+          "Sessions: {}",
+          config_.bar_specs, config_.bar_sessions);
+    }
+  }
+}
+
+const std::vector<std::string> TradingEngine::kLatencyStageNames = {
+    "cmd_transport", "risk_check", "gateway_send",
+    "tick_to_order", "order_ack",  "order_fill"};
+
+TradingEngine::~TradingEngine() {
+  stop_bar_flusher();
+  if (latency_dump_fd_ >= 0) {
+    latency_dump_notify_fd.store(-1);
+    ::close(latency_dump_fd_);
+  }
+}
 
-bool TradingEngine::login(const LoginParams& params) {
+bool TradingEngine::login(const std::vector<LoginParams>& params_list) {
   if (is_logon_) return true;
 
-  gateway_.reset(create_gateway(params.api(), this));
-  if (!gateway_) {
-    spdlog::error("[TradingEngine::login] Failed. Unknown gateway");
+  // 其他账户登录期间已登录账户的网关可能在回调，不能让accounts_重新分配
+  accounts_.reserve(params_list.size());
+  for (const auto& params : params_list) {
+    if (!add_account(params)) return false;
+  }
+  build_routes();
+
+  spdlog::info("[TradingEngine::login] Init done. Accounts: {}",
+               accounts_.size());
+
+  is_logon_ = true;
+  return true;
+}
+
+bool TradingEngine::add_account(const LoginParams& account_params) {
+  LoginParams params = account_params;
+  uint32_t account_index = accounts_.size();
+  const auto& gateways = config_.topology.gateways;
+  if (account_index < gateways.size()) {
+    params.set_md_thread(gateways[account_index].md);
+    params.set_trade_thread(gateways[account_index].trade);
+  }
+
+  auto endpoint = std::make_unique<GatewayEndpoint>(this, account_index,
+                                                    config_.single_writer);
+  std::unique_ptr<Gateway> gateway(
+      create_gateway(params.api(), endpoint.get()));
+  if (!gateway) {
+    spdlog::error("[TradingEngine::login] Failed. Unknown gateway: {}",
+                  params.api());
     return false;
   }
 
-  if (!gateway_->login(params)) {
+  auto& account = accounts_.emplace_back();
+  account.investor_id = params.investor_id();
+  account.exchanges = params.exchanges();
+  account.endpoint = std::move(endpoint);
+  account.gateway = std::move(gateway);
+
+  if (!account.gateway->login(params)) {
     spdlog::error("[TradingEngine::login] Failed to login");
     return false;
   }
@@ -31,53 +146,369 @@ bool TradingEngine::login(const LoginParams& params) {
   spdlog::info("[TradingEngine::login] Success. Login as {}",
                params.investor_id());
 
-  if (!gateway_->query_account()) {
+  if (!account.gateway->query_account()) {
     spdlog::error("[TradingEngine::login] Failed to query account");
     return false;
   }
 
   // query all positions
-  if (!gateway_->query_positions()) {
+  if (!account.gateway->query_positions()) {
     spdlog::error("[TradingEngine::login] Failed to query positions");
     return false;
   }
 
-  spdlog::info("[TradingEngine::login] Init done");
-
-  is_logon_ = true;
   return true;
 }
 
+void TradingEngine::build_routes() {
+  uint32_t default_account = kNoRoute;
+  for (uint32_t i = 0; i < accounts_.size(); ++i) {
+    if (accounts_[i].exchanges.empty()) {
+      default_account = i;
+      break;
+    }
+  }
+
+  ticker_routes_.assign(ContractTable::size() + 1, default_account);
+  for (uint64_t i = 1; i <= ContractTable::size(); ++i) {
+    const auto& exchange = ContractTable::get_by_index(i)->exchange;
+    for (uint32_t j = 0; j < accounts_.size(); ++j) {
+      const auto& exchanges = accounts_[j].exchanges;
+      if (std::find(exchanges.begin(), exchanges.end(), exchange) !=
+          exchanges.end()) {
+        ticker_routes_[i] = j;
+        break;
+      }
+    }
+  }
+}
+
 void TradingEngine::run() {
+  start_time_ = now_ns();
+  if (!loop_.init(config_.cmd_busy_poll, config_.cmd_spin_count,
+                  kTimerTickMs)) {
+    spdlog::error("[TradingEngine::run] Failed to init event loop");
+    return;
+  }
+
+  bool is_ok = config_.cmd_transport == IpcTransport::SHM
+                   ? add_shm_cmd_source()
+                   : add_redis_cmd_source();
+  if (!is_ok) return;
+
+  if (config_.single_writer) add_gateway_event_source();
+  if (strategy_host_ && !add_strategy_host()) return;
+  add_timers();
+  if (!add_latency_dump_source()) return;
+  start_bar_flusher();
+  apply_thread_topology();
+
   spdlog::info("[TradingEngine::run] Start to recv order req");
+  loop_.run();
+}
+
+void TradingEngine::close() {
+  loop_.stop();
+  stop_bar_flusher();
+}
+
+bool TradingEngine::add_redis_cmd_source() {
+  cmd_redis_ = std::make_unique<RedisSession>("127.0.0.1", 6379);
+  cmd_redis_->subscribe({TRADER_CMD_TOPIC});
+
+  auto handler = [this](const RedisReply& reply) {
+    if (!is_sub_message(reply)) return;
+
+    WireView<TraderCommand> cmds(reply->element[2]->str,
+                                 reply->element[2]->len);
+    if (cmds.is_valid()) process_cmds(cmds.data(), cmds.count());
+  };
+
+  return loop_.add_fd(cmd_redis_->fd(), [this, handler] {
+    cmd_redis_->poll_sub_replies(handler);
+  });
+}
+
+bool TradingEngine::add_shm_cmd_source() {
+  if (!cmd_shm_.open(TRADER_CMD_SHM_NAME, true)) {
+    spdlog::error("[TradingEngine::run] Failed to open shm of trader cmd");
+    return false;
+  }
+
+  if (!cmd_doorbell_.open_reader(TRADER_CMD_DOORBELL_PATH)) {
+    spdlog::error("[TradingEngine::run] Failed to open doorbell of trader cmd");
+    return false;
+  }
+
+  // 同一批次的指令是一次性写入同一个队列的，会被连续取出，凑齐后一起处理
+  auto handler = [this](const TraderCommand& cmd) {
+    if (cmd_batch_.empty() && cmd.batch_size <= 1) {
+      process_cmds(&cmd, 1);
+      return;
+    }
+
+    cmd_batch_.emplace_back(cmd);
+    if (cmd_batch_.size() >= cmd_batch_.front().batch_size) {
+      process_cmds(cmd_batch_.data(), cmd_batch_.size());
+      cmd_batch_.clear();
+    }
+  };
+
+  // 队列中是上次运行时没有处理的指令，不能在这次运行中执行
+  auto* queue = cmd_shm_.get();
+  for (uint32_t i = 0; i < TraderCmdQueue::max_producers(); ++i) {
+    uint64_t count = queue->clear(i);
+    if (count > 0)
+      spdlog::warn(
+          "[TradingEngine::run] Discard {} stale cmds of strategy {}", count,
+          i);
+  }
+
+  loop_.add_poller([queue, handler] { return queue->poll(handler); },
+                   [queue] { return queue->prepare_sleep(); },
+                   [queue] { queue->finish_sleep(); });
+  return loop_.add_fd(cmd_doorbell_.fd(), [this] { cmd_doorbell_.drain(); });
+}
+
+void TradingEngine::add_gateway_event_source() {
+  for (const auto& account : accounts_) {
+    auto* events = account.endpoint->events();
+    auto poll = [this, events] {
+      std::size_t count = 0;
+      while (const auto* event = events->front()) {
+        process_gateway_event(*event);
+        events->pop_front();
+        ++count;
+      }
+      return count;
+    };
+
+    auto prepare_sleep = [this, events] {
+      return prepare_loop_sleep([events] { return events->empty(); });
+    };
 
-  order_redis_.subscribe({TRADER_CMD_TOPIC});
+    loop_.add_poller(poll, prepare_sleep, [this] { finish_loop_sleep(); });
+  }
+}
+
+bool TradingEngine::add_strategy_host() {
+  auto handler = [this](const TraderCommand* cmds, uint32_t count) {
+    process_cmds(cmds, count);
+  };
+
+  uint32_t strategy_id = config_.inproc_strategy_id;
+  for (const auto& file : config_.inproc_strategies) {
+    if (!strategy_host_->load(file, strategy_id++, config_.pos_transport,
+                              handler)) {
+      spdlog::error("[TradingEngine::add_strategy_host] Failed to load {}",
+                    file);
+      return false;
+    }
+  }
+
+  auto* host = strategy_host_.get();
+  auto prepare_sleep = [this, host] {
+    return prepare_loop_sleep([host] { return !host->has_pending(); });
+  };
+
+  loop_.add_poller([host] { return host->poll(); }, prepare_sleep,
+                   [this] { finish_loop_sleep(); });
+  return true;
+}
+
+void TradingEngine::apply_thread_topology() {
+  const auto& topology = config_.topology;
+
+  auto& logger = DeferredLogger::instance();
+  logger.set_placement(topology.log_writer);
+  report_thread_placement(logger.native_handle(), "log_writer");
+
+  portfolio_.set_publisher_placement(topology.pos_publisher);
+
+  // 新线程会继承创建者的设置，事件循环线程在其他线程都创建好之后最后设置
+  pin_current_thread("engine_loop", topology.engine_loop);
+  report_thread_placement(pthread_self(), "engine_loop");
+}
+
+void TradingEngine::add_timers() {
+  if (config_.account_refresh_sec > 0) {
+    loop_.add_timer(config_.account_refresh_sec * 1000, [this] {
+      for (const auto& account : accounts_) {
+        if (!account.gateway->query_account())
+          spdlog::error(
+              "[TradingEngine::add_timers] Failed to query account {}",
+              account.investor_id);
+      }
+    });
+  }
+
+  if (config_.order_ack_timeout_sec > 0)
+    loop_.add_timer(1000, [this] { check_unacked_orders(); });
+
+  loop_.add_timer(kStatsIntervalMs, [this] { report_stats(); });
+
+  // 策略的队列满了之后没有新的回报时，由这里补发暂存的回报
+  if (config_.md_transport == IpcTransport::SHM) {
+    loop_.add_timer(kEventBacklogCheckMs, [this] {
+      auto lock = lock_order_state();
+      for (uint32_t i = 0; i < event_backlogs_.size(); ++i) {
+        if (!event_backlogs_[i].empty())
+          flush_event_backlog(i, get_order_event_ring(i));
+      }
+    });
+  }
+}
+
+bool TradingEngine::add_latency_dump_source() {
+  latency_dump_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (latency_dump_fd_ < 0) {
+    spdlog::error(
+        "[TradingEngine::add_latency_dump_source] Failed to create eventfd");
+    return false;
+  }
+
+  install_latency_dump_handler(latency_dump_fd_);
+  return loop_.add_fd(latency_dump_fd_, [this] {
+    uint64_t value;
+    while (read(latency_dump_fd_, &value, sizeof(value)) > 0) {
+    }
+    if (!take_latency_dump_request()) return;
+
+    auto lock = lock_order_state();
+    latency_.report("TradingEngine::dump_latency");
+    if (strategy_host_) strategy_host_->dump_latency();
+  });
+}
+
+void TradingEngine::check_unacked_orders() {
+  uint64_t now = now_ns();
+  uint64_t timeout = config_.order_ack_timeout_sec * 1000000000UL;
+
+  auto lock = lock_order_state();
+  order_table_.for_each([=](const Order& order) {
+    if (order.status != OrderStatus::SUBMITTING) return;
+    if (now - order.insert_time < timeout) return;
 
-  for (;;) {
-    auto reply = order_redis_.get_sub_reply();
-    auto cmd = reinterpret_cast<const TraderCommand*>(reply->element[2]->str);
-    if (cmd->magic != TRADER_CMD_MAGIC) {
-      spdlog::error("[TradingEngine::run] Recv unknown cmd: error magic num");
+    spdlog::warn(
+        "[TradingEngine::check_unacked_orders] Order not acked for {}s. "
+        "OrderID: {}, Ticker: {}",
+        (now - order.insert_time) / 1000000000UL, order.order_id,
+        order.contract->ticker);
+  });
+}
+
+void TradingEngine::report_stats() {
+  auto lock = lock_order_state();
+  spdlog::info(
+      "[TradingEngine::report_stats] Cmds: {}, Orders: {}, Active orders: {}, "
+      "Backlogged events: {}",
+      num_cmds_, next_order_id_ - 1, order_table_.size(), backlogged_events_);
+
+  if (strategy_host_) {
+    spdlog::info("[TradingEngine::report_stats] Dropped in-process ticks: {}",
+                 strategy_host_->dropped_ticks());
+  }
+
+  tick_filter_.report("TradingEngine::report_stats");
+  if (bar_aggregator_) {
+    spdlog::info("[TradingEngine::report_stats] Bars: {}, Late ticks: {}",
+                 bar_aggregator_->num_bars(), bar_aggregator_->late_ticks());
+  }
+  latency_.report("TradingEngine::report_stats");
+  latency_.reset();
+}
+
+void TradingEngine::process_cmds(const TraderCommand* cmds,
+                                 std::size_t count) {
+  uint64_t dequeue_time = now_ns();
+  for (std::size_t i = 0; i < count; ++i) {
+    if (cmds[i].magic != TRADER_CMD_MAGIC) {
+      spdlog::error(
+          "[TradingEngine::process_cmds] Recv unknown cmd: error magic num");
+      return;
+    }
+  }
+
+  // 同一批次的指令是一起发出的，send_time相同
+  uint64_t send_time = cmds[0].send_time;
+  bool is_stale = send_time < start_time_ ||
+                  (config_.cmd_max_age_ms > 0 &&
+                   dequeue_time > send_time + config_.cmd_max_age_ms * 1000000);
+
+  auto lock = lock_order_state();
+  num_cmds_ += count;
+  if (is_stale) {
+    spdlog::error(
+        "[TradingEngine::process_cmds] Stale cmds. StrategyID: {}, "
+        "Age(ms): {}",
+        cmds[0].strategy_id,
+        send_time < dequeue_time ? (dequeue_time - send_time) / 1000000 : 0);
+  } else {
+    for (std::size_t i = 0; i < count; ++i)
+      latency_.record(CMD_TRANSPORT, cmds[i].send_time, dequeue_time);
+  }
+
+  // 先对批次中所有的新订单做风控检查，任意一个不通过则整批都不执行
+  // 过期的批次中新订单全部拒绝，撤单不执行
+  batch_orders_.clear();
+  bool is_passed = is_logon_ && !is_stale;
+  std::size_t num_checked = 0;
+  if (!is_logon_) spdlog::error("[TradingEngine::process_cmds] Not logon");
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (cmds[i].type != NEW_ORDER) continue;
+
+    Order order;
+    if (!make_order(cmds[i], &order)) {
+      // 无法生成订单的指令没有order_id，策略通过client_order_id对应
+      is_passed = false;
+      publish_order_event(order, ORDER_REJECTED, now_ns());
       continue;
     }
+    batch_orders_.emplace_back(order);
+
+    if (!is_passed) continue;
+    if (check_order(order))
+      ++num_checked;
+    else
+      is_passed = false;
+  }
+
+  if (!is_passed) {
+    spdlog::error("风控未通过，整批指令不执行. Batch size: {}", count);
+    for (std::size_t i = 0; i < batch_orders_.size(); ++i) {
+      // 已经通过检查的订单需要通知风控模块订单结束
+      if (risk_mgr_ && i < num_checked)
+        risk_mgr_->on_order_completed(batch_orders_[i].order_id);
+      publish_order_event(batch_orders_[i], ORDER_REJECTED, now_ns());
+    }
+    return;
+  }
+
+  if (!batch_orders_.empty())
+    latency_.record(RISK_CHECK, dequeue_time, now_ns());
 
+  auto order_iter = batch_orders_.begin();
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto* cmd = &cmds[i];
     switch (cmd->type) {
       case NEW_ORDER:
-        spdlog::info("new order");
-        send_order(cmd->order_req.ticker_index, cmd->order_req.volume,
-                   cmd->order_req.direction, cmd->order_req.offset,
-                   cmd->order_req.type, cmd->order_req.price);
+        send_order(*order_iter++);
         break;
       case CANCEL_ORDER:
-        spdlog::info("cancel order");
+        FT_LOG_DEBUG("[TradingEngine::process_cmds] Cancel order. OrderID: {}",
+                     cmd->cancel_req.order_id);
         cancel_order(cmd->cancel_req.order_id);
         break;
       case CANCEL_TICKER:
-        spdlog::info("cancel all for ticker");
+        FT_LOG_DEBUG(
+            "[TradingEngine::process_cmds] Cancel all for ticker. "
+            "TickerIndex: {}",
+            cmd->cancel_ticker_req.ticker_index);
         cancel_all_for_ticker(cmd->cancel_ticker_req.ticker_index);
         break;
       case CANCEL_ALL:
-        spdlog::info("cancel all");
+        FT_LOG_DEBUG("[TradingEngine::process_cmds] Cancel all");
         cancel_all();
         break;
       default:
@@ -87,94 +518,158 @@ void TradingEngine::run() {
   }
 }
 
-bool TradingEngine::send_order(uint64_t ticker_index, int volume,
-                               uint64_t direction, uint64_t offset,
-                               uint64_t type, double price) {
-  if (!is_logon_) {
-    spdlog::error("[TradingEngine::send_order] Failed. Not logon");
+static OrderReq make_order_req(const Order& order) {
+  OrderReq req;
+  req.order_id = order.order_id;
+  req.ticker_index = order.contract->index;
+  req.direction = order.direction;
+  req.offset = order.offset;
+  req.volume = order.volume;
+  req.type = order.type;
+  req.price = order.price;
+  return req;
+}
+
+bool TradingEngine::make_order(const TraderCommand& cmd, Order* order) {
+  const auto& req = cmd.order_req;
+  auto contract = ContractTable::get_by_index(req.ticker_index);
+
+  // 失败时order中的字段用于发布拒单回报
+  order->order_id = 0;
+  order->strategy_id = cmd.strategy_id;
+  order->client_order_id = req.client_order_id;
+  order->contract = contract;
+  order->direction = req.direction;
+  order->offset = req.offset;
+  order->volume = req.volume;
+  order->type = req.type;
+  order->price = req.price;
+  order->status = OrderStatus::REJECTED;
+
+  if (!contract) {
+    spdlog::error("[TradingEngine::make_order] Contract not found");
     return false;
   }
 
-  auto contract = ContractTable::get_by_index(ticker_index);
-  if (!contract) {
-    spdlog::error("[TradingEngine::send_order] Contract not found");
+  uint32_t account_index = ticker_routes_[contract->index];
+  if (account_index == kNoRoute) {
+    spdlog::error(
+        "[TradingEngine::make_order] No account for exchange {}. Ticker: {}",
+        contract->exchange, contract->ticker);
     return false;
   }
 
-  OrderReq req;
-  req.order_id = next_order_id();
-  req.ticker_index = ticker_index;
-  req.direction = direction;
-  req.offset = offset;
-  req.volume = volume;
-  req.type = type;
-  req.price = price;
+  order->order_id = next_order_id();
+  order->account_index = account_index;
+  order->status = OrderStatus::CREATED;
+  order->insert_time = now_ns();
+  order->trigger_time = cmd.trigger_time;
+  return true;
+}
 
-  std::unique_lock<std::mutex> lock(mutex_);
-  if (risk_mgr_) {
-    if (!risk_mgr_->check_order_req(&req)) {
-      spdlog::error("风控未通过");
-      return false;
-    }
+bool TradingEngine::check_order(const Order& order) {
+  if (!risk_mgr_) return true;
+
+  auto req = make_order_req(order);
+  return risk_mgr_->check_order_req(&req);
+}
+
+bool TradingEngine::send_order(const Order& order) {
+  auto req = make_order_req(order);
+  const auto* contract = order.contract;
+
+  // 先占用槽位再发送，保证发出去的订单都能在回报中找到
+  uint64_t begin_time = now_ns();
+  auto* inserted = order_table_.insert(order);
+  if (!inserted) {
+    spdlog::error(
+        "[StrategyEngine::send_order] Order table is full. OrderID: {}, "
+        "Active orders: {}",
+        order.order_id, order_table_.size());
+
+    if (risk_mgr_) risk_mgr_->on_order_completed(order.order_id);
+    publish_order_event(order, ORDER_REJECTED, now_ns());
+    return false;
   }
 
-  if (!gateway_->send_order(&req)) {
+  inserted->status = OrderStatus::SUBMITTING;
+  if (!accounts_[order.account_index].gateway->send_order(&req)) {
     spdlog::error(
         "[StrategyEngine::send_order] Failed to send_order."
         " Order: <Ticker: {}, OrderID: {}, Direction: {}, "
         "Offset: {}, OrderType: {}, Traded: {}, Total: {}, Price: {:.2f}, "
         "Status: Failed>",
-        contract->ticker, req.order_id, direction_str(req.direction),
-        offset_str(req.offset), ordertype_str(req.type), 0, req.volume,
-        req.price);
+        contract->ticker, order.order_id, direction_str(order.direction),
+        offset_str(order.offset), ordertype_str(order.type), 0, order.volume,
+        order.price);
 
-    if (risk_mgr_) risk_mgr_->on_order_completed(req.order_id);
+    if (risk_mgr_) risk_mgr_->on_order_completed(order.order_id);
+    inserted->status = OrderStatus::REJECTED;
+    publish_order_event(*inserted, ORDER_REJECTED, now_ns());
+    order_table_.erase(order.order_id);
 
     return false;
   }
 
-  if (risk_mgr_) risk_mgr_->on_order_sent(req.order_id);
-
-  Order order;
-  order.order_id = req.order_id;
-  order.contract = contract;
-  order.direction = direction;
-  order.offset = offset;
-  order.volume = volume;
-  order.type = type;
-  order.price = price;
-  order.status = OrderStatus::SUBMITTING;
-  order_map_.emplace(order.order_id, order);
-
-  portfolio_.update_pending(contract->index, direction, offset, volume);
-
-  spdlog::debug(
-      "[StrategyEngine::send_order] Success."
-      " Order: <Ticker: {}, OrderID: {}, Direction: {}, "
-      "Offset: {}, OrderType: {}, Traded: {}, Total: {}, Price: {:.2f}, "
-      "Status: {}>",
-      contract->ticker, order.order_id, direction_str(order.direction),
-      offset_str(order.offset), ordertype_str(order.type), 0, order.volume,
-      order.price, to_string(order.status));
+  inserted->sent_time = now_ns();
+  open_orders_.add(inserted);
+  latency_.record(GATEWAY_SEND, begin_time, inserted->sent_time);
+  latency_.record(TICK_TO_ORDER, order.trigger_time, inserted->sent_time);
+
+  if (risk_mgr_) risk_mgr_->on_order_sent(order.order_id);
+
+  portfolio_.update_pending(contract->index, order.direction, order.offset,
+                            order.volume);
+
+  FT_LOG_DEBUG(
+      "[StrategyEngine::send_order] Success. Order: <Ticker: {}, OrderID: {}, "
+      "Direction: {}, Offset: {}, Total: {}, Price: {:.2f}>",
+      contract->ticker.c_str(), order.order_id,
+      LazyStr<direction_str>{order.direction},
+      LazyStr<offset_str>{order.offset}, order.volume, order.price);
   return true;
 }
 
 void TradingEngine::cancel_order(uint64_t order_id) {
-  gateway_->cancel_order(order_id);
+  // 撤单需要发给下单时的账户
+  const auto* order = order_table_.find(order_id);
+  if (!order) {
+    spdlog::error("[TradingEngine::cancel_order] Order not found. OrderID: {}",
+                  order_id);
+    return;
+  }
+
+  accounts_[order->account_index].gateway->cancel_order(order_id);
 }
 
 void TradingEngine::cancel_all_for_ticker(uint64_t ticker_index) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [order_id, order] : order_map_) {
-    if (ticker_index == order.contract->index) gateway_->cancel_order(order_id);
-  }
+  order_table_.for_each_of_ticker(ticker_index, [this](const Order& order) {
+    accounts_[order.account_index].gateway->cancel_order(order.order_id);
+  });
 }
 
 void TradingEngine::cancel_all() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [order_id, order] : order_map_) {
-    gateway_->cancel_order(order_id);
+  order_table_.for_each([this](const Order& order) {
+    accounts_[order.account_index].gateway->cancel_order(order.order_id);
+  });
+}
+
+void TradingEngine::update_status(Order* order, OrderStatus status) {
+  if (!is_valid_transition(order->status, status)) {
+    spdlog::warn(
+        "[TradingEngine::update_status] Invalid transition of order {}: {} "
+        "-> {}",
+        order->order_id, to_string(order->status), to_string(status));
+    return;
   }
+
+  order->status = status;
+  open_orders_.update(*order);
+}
+
+void TradingEngine::remove_order(Order* order) {
+  open_orders_.remove(order);
+  order_table_.erase(order->order_id);
 }
 
 void TradingEngine::on_query_contract(const Contract* contract) {}
@@ -214,127 +709,457 @@ void TradingEngine::on_tick(const TickData* tick) {
     return;
   }
 
-  tick_redis_.publish(proto_md_topic(contract->ticker), tick, sizeof(TickData));
+  // 多个账户的行情线程会同时回调；合成bar时后台线程也会发布bar
+  std::unique_lock<std::mutex> lock(md_mutex_, std::defer_lock);
+  if (accounts_.size() > 1 || bar_aggregator_) lock.lock();
+
+  if (!tick_filter_.filter(*tick)) return;
+
+  // 盘口指标只在这里计算一次，随行情发给所有策略
+  TickData analyzed = *tick;
+  tick_analyzer_.analyze(*contract, &analyzed);
+
+  uint64_t engine_time = now_ns();
+  analyzed.engine_time = engine_time;
+
+  // 进程内的策略在事件循环线程中回调，这里只负责转交
+  if (strategy_host_ && strategy_host_->push_tick(analyzed, engine_time))
+    wakeup_loop();
+
+  if (config_.md_transport == IpcTransport::SHM) {
+    if (md_ && contract->index < kMaxTickers) {
+      LatestTick latest{md_->ring.head(), analyzed};
+
+      // 写入不会被策略阻塞，处理不过来的策略自己跳过积压的数据
+      md_->publish_time.store(engine_time, std::memory_order_relaxed);
+      md_->latest[contract->index].store(latest);
+      md_->ring.push(latest.tick);
+      md_->notifier.notify();
+    }
+  } else {
+    WireMsg<TickData> msg;
+    msg.set_header(tick_seq_++);
+    msg.body[0] = analyzed;
+    tick_redis_->publish(proto_md_topic(contract->ticker), msg.data(),
+                         msg.size());
+  }
+
+  // 行情先发出去，这条行情结束的bar随后发布
+  if (bar_aggregator_) bar_aggregator_->on_tick(analyzed);
   spdlog::debug("[TradingEngine::process_tick]");
 }
 
-void TradingEngine::on_order_accepted(uint64_t order_id) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::publish_bar(const BarData& bar) {
+  if (strategy_host_ && strategy_host_->push_bar(bar)) wakeup_loop();
+
+  if (config_.md_transport == IpcTransport::SHM) {
+    if (!md_) return;
+    md_->bars.push(bar);
+    md_->notifier.notify();
+  } else {
+    const auto* contract = ContractTable::get_by_index(bar.ticker_index);
+    if (!contract) return;
+
+    WireMsg<BarData> msg;
+    msg.set_header(bar_seq_++);
+    msg.body[0] = bar;
+    tick_redis_->publish(proto_bar_topic(contract->ticker), msg.data(),
+                         msg.size());
+  }
+}
+
+void TradingEngine::start_bar_flusher() {
+  if (!bar_aggregator_ || bar_flusher_.joinable()) return;
+
+  is_bar_flusher_running_ = true;
+  bar_flusher_ = std::thread([this] {
+    std::unique_lock<std::mutex> flusher_lock(bar_flusher_mutex_);
+    while (!bar_flusher_cv_.wait_for(flusher_lock, std::chrono::seconds(1),
+                                     [this] {
+                                       return !is_bar_flusher_running_;
+                                     })) {
+      std::unique_lock<std::mutex> lock(md_mutex_);
+      bar_aggregator_->flush(wall_time_ns());
+    }
+  });
+  report_thread_placement(bar_flusher_.native_handle(), "bar_flusher");
+}
+
+void TradingEngine::stop_bar_flusher() {
+  if (!bar_flusher_.joinable()) return;
+
+  {
+    std::unique_lock<std::mutex> lock(bar_flusher_mutex_);
+    is_bar_flusher_running_ = false;
+  }
+  bar_flusher_cv_.notify_one();
+  bar_flusher_.join();
+}
+
+void TradingEngine::handle_order_accepted(uint64_t order_id,
+                                          uint64_t recv_time) {
+  auto* order = order_table_.find(order_id);
+  if (!order) {
     spdlog::error(
-        "[TradingEngine::on_order_accepted] Order not found. OrderID: {}",
+        "[TradingEngine::handle_order_accepted] Order not found. OrderID: {}",
         order_id);
     return;
   }
 
-  auto& order = iter->second;
+  // 成交回报可能先到，这时不再回到NO_TRADED
+  if (order->status == OrderStatus::SUBMITTING)
+    update_status(order, OrderStatus::NO_TRADED);
+  latency_.record(ORDER_ACK, order->sent_time, recv_time);
 
-  spdlog::info(
-      "[TradingEngine::on_order_accepted] 报单委托成功. Ticker: {}, Direction: "
-      "{}, Offset: {}, Volume: {}, Price: {:.2f}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), order.volume, order.price);
+  FT_LOG_INFO(
+      "[TradingEngine::handle_order_accepted] 报单委托成功. Ticker: {}, "
+      "Direction: {}, Offset: {}, Volume: {}, Price: {:.2f}",
+      order->contract->ticker.c_str(), LazyStr<direction_str>{order->direction},
+      LazyStr<offset_str>{order->offset}, order->volume, order->price);
+
+  publish_order_event(*order, ORDER_ACCEPTED, recv_time);
 }
 
-void TradingEngine::on_order_rejected(uint64_t order_id) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_rejected(uint64_t order_id,
+                                          uint64_t recv_time) {
+  auto* order = order_table_.find(order_id);
+  if (!order) {
     spdlog::error(
-        "[TradingEngine::on_order_rejected] Order not found. OrderID: {}",
+        "[TradingEngine::handle_order_rejected] Order not found. OrderID: {}",
         order_id);
     return;
   }
-  auto& order = iter->second;
 
   spdlog::error(
-      "[TradingEngine::on_order_rejected] 报单被拒. Ticker: {}, Direction: "
+      "[TradingEngine::handle_order_rejected] 报单被拒. Ticker: {}, Direction: "
       "{}, Offset: {}, Volume: {}, Price: {:.2f}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), order.volume, order.price);
+      order->contract->ticker, direction_str(order->direction),
+      offset_str(order->offset), order->volume, order->price);
+
+  // 订单结束，通知风控模块
+  if (risk_mgr_) risk_mgr_->on_order_completed(order_id);
 
-  order_map_.erase(iter);
+  update_status(order, OrderStatus::REJECTED);
+  publish_order_event(*order, ORDER_REJECTED, recv_time);
+  remove_order(order);
 }
 
-void TradingEngine::on_order_traded(uint64_t order_id, int64_t this_traded,
-                                    double traded_price) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_traded(uint64_t order_id, int64_t this_traded,
+                                        double traded_price,
+                                        uint64_t recv_time) {
+  auto* order = order_table_.find(order_id);
+  if (!order) {
     spdlog::error(
-        "[TradingEngine::on_order_traded] Order not found. OrderID: {}, "
+        "[TradingEngine::handle_order_traded] Order not found. OrderID: {}, "
         "Traded: {}, Price: {}",
         order_id, this_traded, traded_price);
     return;
   }
-  auto& order = iter->second;
 
-  spdlog::info(
-      "[TradingEngine::on_order_traded] 报单成交. Ticker: {}, Direction: {}, "
-      "Offset: {}, Traded: {}, Price: {}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), this_traded, traded_price);
+  FT_LOG_INFO(
+      "[TradingEngine::handle_order_traded] 报单成交. Ticker: {}, Direction: "
+      "{}, Offset: {}, Traded: {}, Price: {}",
+      order->contract->ticker.c_str(), LazyStr<direction_str>{order->direction},
+      LazyStr<offset_str>{order->offset}, this_traded, traded_price);
 
-  portfolio_.update_traded(order.contract->index, order.direction, order.offset,
-                           this_traded, traded_price);
+  portfolio_.update_traded(order->contract->index, order->direction,
+                           order->offset, this_traded, traded_price);
 
   if (risk_mgr_)
     risk_mgr_->on_order_traded(order_id, this_traded, traded_price);
 
-  order.traded_volume += this_traded;
-  if (order.traded_volume + order.canceled_volume == order.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_traded] 报单完成. Ticker: {}, Direction: {}, "
-        "Offset: {}, Traded/Original: {}/{}",
-        order.contract->ticker, direction_str(order.direction),
-        offset_str(order.offset), order.traded_volume, order.volume);
+  if (order->traded_volume == 0)
+    latency_.record(ORDER_FILL, order->sent_time, recv_time);
+  order->traded_volume += this_traded;
+  if (order->status == OrderStatus::CANCELED) {
+    // 撤单回报可能先于最后的成交回报到达，订单保持CANCELED，只更新成交量
+    open_orders_.update(*order);
+  } else {
+    update_status(order, order->traded_volume == order->volume
+                             ? OrderStatus::ALL_TRADED
+                             : OrderStatus::PART_TRADED);
+  }
+  publish_order_event(*order, ORDER_TRADED, recv_time, this_traded,
+                      traded_price);
+
+  if (order->traded_volume + order->canceled_volume == order->volume) {
+    FT_LOG_INFO(
+        "[TradingEngine::handle_order_traded] 报单完成. Ticker: {}, "
+        "Direction: {}, Offset: {}, Traded/Original: {}/{}",
+        order->contract->ticker.c_str(),
+        LazyStr<direction_str>{order->direction},
+        LazyStr<offset_str>{order->offset}, order->traded_volume,
+        order->volume);
 
     // 订单结束，通知风控模块
     if (risk_mgr_) risk_mgr_->on_order_completed(order_id);
 
-    order_map_.erase(iter);
+    remove_order(order);
   }
 }
 
-void TradingEngine::on_order_canceled(uint64_t order_id,
-                                      int64_t canceled_volume) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_canceled(uint64_t order_id,
+                                          int64_t canceled_volume,
+                                          uint64_t recv_time) {
+  auto* order = order_table_.find(order_id);
+  if (!order) {
     spdlog::error(
-        "[TradingEngine::on_order_canceled] Order not found. OrderID: {}",
+        "[TradingEngine::handle_order_canceled] Order not found. OrderID: {}",
         order_id);
     return;
   }
-  auto& order = iter->second;
 
-  spdlog::info(
-      "[TradingEngine::on_order_canceled] 报单已撤. Ticker: {}, Direction: {}, "
-      "Offset: {}, Canceled: {}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), canceled_volume);
+  FT_LOG_INFO(
+      "[TradingEngine::handle_order_canceled] 报单已撤. Ticker: {}, "
+      "Direction: {}, Offset: {}, Canceled: {}",
+      order->contract->ticker.c_str(), LazyStr<direction_str>{order->direction},
+      LazyStr<offset_str>{order->offset}, canceled_volume);
 
-  order.canceled_volume = canceled_volume;
-  if (order.traded_volume + order.canceled_volume == order.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_canceled] 报单完成. Ticker: {}, Direction: "
-        "{}, Offset: {}, Traded/Original: {}/{}",
-        order.contract->ticker, direction_str(order.direction),
-        offset_str(order.offset), order.traded_volume, order.volume);
+  order->canceled_volume = canceled_volume;
+  update_status(order, OrderStatus::CANCELED);
+  publish_order_event(*order, ORDER_CANCELED, recv_time);
+
+  if (order->traded_volume + order->canceled_volume == order->volume) {
+    FT_LOG_INFO(
+        "[TradingEngine::handle_order_canceled] 报单完成. Ticker: {}, "
+        "Direction: {}, Offset: {}, Traded/Original: {}/{}",
+        order->contract->ticker.c_str(),
+        LazyStr<direction_str>{order->direction},
+        LazyStr<offset_str>{order->offset}, order->traded_volume,
+        order->volume);
 
     // 订单结束，通知风控模块
     if (risk_mgr_) risk_mgr_->on_order_completed(order_id);
 
-    order_map_.erase(iter);
+    remove_order(order);
   }
 }
 
-void TradingEngine::on_order_cancel_rejected(uint64_t order_id) {
+void TradingEngine::handle_order_cancel_rejected(uint64_t order_id,
+                                                 uint64_t recv_time) {
   spdlog::warn(
-      "[TradingEngine::on_order_cancel_rejected] Order cannot be canceled. "
-      "OrderID: {}",
+      "[TradingEngine::handle_order_cancel_rejected] Order cannot be "
+      "canceled. OrderID: {}",
       order_id);
+
+  auto* order = order_table_.find(order_id);
+  if (!order) return;
+
+  publish_order_event(*order, ORDER_CANCEL_REJECTED, recv_time);
+}
+
+void TradingEngine::on_order_accepted(const GatewayEndpoint& from,
+                                      uint64_t order_id, uint64_t recv_time) {
+  if (config_.single_writer) {
+    push_gateway_event(from, {ORDER_ACCEPTED, order_id, 0, 0, recv_time});
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  handle_order_accepted(order_id, recv_time);
+}
+
+void TradingEngine::on_order_rejected(const GatewayEndpoint& from,
+                                      uint64_t order_id, uint64_t recv_time) {
+  if (config_.single_writer) {
+    push_gateway_event(from, {ORDER_REJECTED, order_id, 0, 0, recv_time});
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  handle_order_rejected(order_id, recv_time);
+}
+
+void TradingEngine::on_order_traded(const GatewayEndpoint& from,
+                                    uint64_t order_id, int64_t this_traded,
+                                    double traded_price, uint64_t recv_time) {
+  if (config_.single_writer) {
+    push_gateway_event(
+        from, {ORDER_TRADED, order_id, this_traded, traded_price, recv_time});
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  handle_order_traded(order_id, this_traded, traded_price, recv_time);
+}
+
+void TradingEngine::on_order_canceled(const GatewayEndpoint& from,
+                                      uint64_t order_id,
+                                      int64_t canceled_volume,
+                                      uint64_t recv_time) {
+  if (config_.single_writer) {
+    push_gateway_event(
+        from, {ORDER_CANCELED, order_id, canceled_volume, 0, recv_time});
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  handle_order_canceled(order_id, canceled_volume, recv_time);
+}
+
+void TradingEngine::on_order_cancel_rejected(const GatewayEndpoint& from,
+                                             uint64_t order_id,
+                                             uint64_t recv_time) {
+  if (config_.single_writer) {
+    push_gateway_event(from,
+                       {ORDER_CANCEL_REJECTED, order_id, 0, 0, recv_time});
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  handle_order_cancel_rejected(order_id, recv_time);
+}
+
+void TradingEngine::push_gateway_event(const GatewayEndpoint& from,
+                                       const GatewayEvent& event) {
+  // 回报不能丢，队列满时等待引擎线程处理
+  while (!from.events()->push(event)) cpu_relax();
+  wakeup_loop();
+}
+
+void TradingEngine::process_gateway_event(const GatewayEvent& event) {
+  switch (event.type) {
+    case ORDER_ACCEPTED:
+      handle_order_accepted(event.order_id, event.recv_time);
+      break;
+    case ORDER_REJECTED:
+      handle_order_rejected(event.order_id, event.recv_time);
+      break;
+    case ORDER_TRADED:
+      handle_order_traded(event.order_id, event.volume, event.price,
+                          event.recv_time);
+      break;
+    case ORDER_CANCELED:
+      handle_order_canceled(event.order_id, event.volume, event.recv_time);
+      break;
+    case ORDER_CANCEL_REJECTED:
+      handle_order_cancel_rejected(event.order_id, event.recv_time);
+      break;
+    default:
+      spdlog::error(
+          "[TradingEngine::process_gateway_event] Unknown event type: {}",
+          event.type);
+      break;
+  }
+}
+
+void TradingEngine::wakeup_loop() {
+  // 和prepare_loop_sleep配合，保证不会在引擎线程睡眠时漏掉唤醒
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (is_loop_sleeping_.load(std::memory_order_relaxed) &&
+      is_loop_sleeping_.exchange(false))
+    loop_.wakeup();
+}
+
+template <class IsEmpty>
+bool TradingEngine::prepare_loop_sleep(IsEmpty&& is_empty) {
+  is_loop_sleeping_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (is_empty()) return true;
+
+  is_loop_sleeping_.store(false, std::memory_order_relaxed);
+  return false;
+}
+
+void TradingEngine::finish_loop_sleep() {
+  is_loop_sleeping_.store(false, std::memory_order_relaxed);
+}
+
+std::unique_lock<std::mutex> TradingEngine::lock_order_state() {
+  if (config_.single_writer)
+    return std::unique_lock<std::mutex>(mutex_, std::defer_lock);
+  return std::unique_lock<std::mutex>(mutex_);
+}
+
+void TradingEngine::publish_order_event(const Order& order, uint32_t type,
+                                        uint64_t recv_time, int64_t this_traded,
+                                        double traded_price) {
+  OrderEvent event{};
+  event.type = type;
+  event.strategy_id = order.strategy_id;
+  event.order_id = order.order_id;
+  event.client_order_id = order.client_order_id;
+  event.ticker_index = order.contract ? order.contract->index : NONE_TICKER;
+  event.direction = order.direction;
+  event.offset = order.offset;
+  event.volume = order.volume;
+  event.traded_volume = order.traded_volume;
+  event.canceled_volume = order.canceled_volume;
+  event.this_traded = this_traded;
+  event.this_traded_price = traded_price;
+  event.gateway_time = recv_time;
+  event.engine_time = now_ns();
+
+  if (strategy_host_ && strategy_host_->is_hosted(order.strategy_id)) {
+    strategy_host_->push_order_event(event);
+    return;
+  }
+
+  if (config_.md_transport == IpcTransport::SHM) {
+    auto* ring = get_order_event_ring(order.strategy_id);
+    if (!ring) return;
+
+    // 策略进程可能已经退出，不能阻塞回报线程。队列满了就暂存起来，之后的
+    // 回报排在暂存的后面，保证策略收到的顺序不变
+    auto& backlog = event_backlogs_[order.strategy_id];
+    if (!backlog.empty()) flush_event_backlog(order.strategy_id, ring);
+    if (!backlog.empty() || !ring->push(event)) {
+      if (backlog.empty()) {
+        spdlog::error(
+            "[TradingEngine::publish_order_event] Event ring of strategy {} "
+            "is full. Keep events until it catches up",
+            order.strategy_id);
+      }
+      backlog.emplace_back(event);
+      ++backlogged_events_;
+    }
+    // 策略可能正睡眠在行情的唤醒点上等待
+    if (md_) md_->notifier.notify();
+  } else {
+    WireMsg<OrderEvent> msg;
+    msg.set_header(event_seq_++);
+    msg.body[0] = event;
+    event_redis_->publish(proto_order_event_topic(order.strategy_id),
+                          msg.data(), msg.size());
+  }
+}
+
+void TradingEngine::flush_event_backlog(uint32_t strategy_id,
+                                        OrderEventRing* ring) {
+  auto& backlog = event_backlogs_[strategy_id];
+  if (!ring) return;
+
+  std::size_t count = 0;
+  while (!backlog.empty() && ring->push(backlog.front())) {
+    backlog.pop_front();
+    ++count;
+  }
+  if (count == 0) return;
+
+  if (md_) md_->notifier.notify();
+  if (backlog.empty()) {
+    spdlog::info("[TradingEngine::flush_event_backlog] Strategy {} caught up",
+                 strategy_id);
+  }
+}
+
+OrderEventRing* TradingEngine::get_order_event_ring(uint32_t strategy_id) {
+  if (strategy_id >= event_shm_.size()) return nullptr;
+
+  auto& shm = event_shm_[strategy_id];
+  if (!shm) {
+    shm = std::make_unique<ShmSegment<OrderEventRing>>();
+    if (!shm->open(proto_order_event_shm_name(strategy_id), true)) {
+      spdlog::error(
+          "[TradingEngine::get_order_event_ring] Failed to open shm of "
+          "strategy {}",
+          strategy_id);
+      shm.reset();
+      return nullptr;
+    }
+  }
+
+  return shm->get();
 }
 
 }  // namespace ft
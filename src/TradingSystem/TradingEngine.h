@@ -3,12 +3,16 @@
 #ifndef FT_TRADINGSYSTEM_TRADINGENGINE_H_
 #define FT_TRADINGSYSTEM_TRADINGENGINE_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -17,27 +21,96 @@
 #include "Core/LoginParams.h"
 #include "Core/RiskManagementInterface.h"
 #include "Core/TradingEngineInterface.h"
+#include "Core/WireFormat.h"
+#include "IPC/doorbell.h"
 #include "IPC/redis.h"
+#include "IPC/shm.h"
+#include "IPC/spsc_ring.h"
+#include "Utils/LatencyRecorder.h"
+#include "TradingSystem/BarAggregator.h"
+#include "TradingSystem/Config.h"
+#include "TradingSystem/EventLoop.h"
+#include "TradingSystem/OpenOrderPublisher.h"
 #include "TradingSystem/Order.h"
+#include "TradingSystem/OrderTable.h"
 #include "TradingSystem/PositionManager.h"
+#include "TradingSystem/StrategyHost.h"
+#include "TradingSystem/TickAnalyzer.h"
+#include "TradingSystem/TickFilter.h"
 
 namespace ft {
 
-class TradingEngine : public TradingEngineInterface {
+/*
+ * 一个引擎可以同时登录多个账户（网关），订单按合约的交易所路由到对应的
+ * 账户，策略仍然只和这一个引擎通信
+ */
+class TradingEngine {
  public:
-  TradingEngine();
+  explicit TradingEngine(const EngineConfig& config);
 
   ~TradingEngine();
 
-  bool login(const LoginParams& params);
+  /*
+   * 依次登录所有账户，任意一个失败则返回false
+   */
+  bool login(const std::vector<LoginParams>& params_list);
 
   void run();
 
   void close();
 
  private:
-  bool send_order(uint64_t ticker_index, int volume, uint64_t direction,
-                  uint64_t offset, uint64_t type, double price);
+  class GatewayEndpoint;
+
+  bool add_account(const LoginParams& params);
+
+  /*
+   * 按交易所为每个合约选定账户，没有指定账户的交易所使用默认账户
+   */
+  void build_routes();
+
+  bool add_redis_cmd_source();
+
+  bool add_shm_cmd_source();
+
+  void add_gateway_event_source();
+
+  /*
+   * 加载进程内的策略，策略的回调和下单都在事件循环线程中进行
+   */
+  bool add_strategy_host();
+
+  void add_timers();
+
+  /*
+   * kill -USR1 <pid>时输出当前统计周期内的延迟
+   * 信号处理函数通过eventfd唤醒事件循环，平时不需要定时检查
+   */
+  bool add_latency_dump_source();
+
+  /*
+   * 按config_.topology设置各个线程的位置并输出实际生效的结果
+   */
+  void apply_thread_topology();
+
+  /*
+   * 检查发出后长时间没有被交易所接受或拒绝的订单
+   */
+  void check_unacked_orders();
+
+  void report_stats();
+
+  /*
+   * 处理一个批次的指令，单条指令视为大小为1的批次
+   */
+  void process_cmds(const TraderCommand* cmds, std::size_t count);
+
+  // 以下函数的调用方需要持有mutex_，单写者模式下只在事件循环线程中调用
+  bool make_order(const TraderCommand& cmd, Order* order);
+
+  bool check_order(const Order& order);
+
+  bool send_order(const Order& order);
 
   void cancel_order(uint64_t order_id);
 
@@ -45,43 +118,278 @@ class TradingEngine : public TradingEngineInterface {
 
   void cancel_all();
 
-  void on_query_contract(const Contract* contract) override;
+  /*
+   * 按回报更新订单状态，不合法的转换只告警，不修改状态
+   */
+  void update_status(Order* order, OrderStatus status);
 
-  void on_query_account(const Account* account) override;
+  /*
+   * 订单结束时调用，从订单表和策略的未结束订单视图中删除
+   */
+  void remove_order(Order* order);
 
-  void on_query_position(const Position* position) override;
+  // 网关的回调，经由各账户的GatewayEndpoint进入
+  void on_query_contract(const Contract* contract);
 
-  void on_tick(const TickData* tick) override;
+  void on_query_account(const Account* account);
 
-  void on_order_accepted(uint64_t order_id) override;
+  void on_query_position(const Position* position);
 
-  void on_order_rejected(uint64_t order_id) override;
+  void on_tick(const TickData* tick);
 
-  void on_order_traded(uint64_t order_id, int64_t this_traded,
-                       double traded_price) override;
+  /*
+   * BarAggregator的回调，调用方需要持有md_mutex_
+   */
+  void publish_bar(const BarData& bar);
+
+  /*
+   * 行情稀疏的合约没有下一条行情来结束时间bar，由后台线程每秒结束一次。
+   * 结束时需要持有md_mutex_，在redis模式下还要同步发布，所以不放在事件
+   * 循环中，避免事件循环被行情的发布阻塞。停止时立即唤醒，不等到下一秒
+   */
+  void start_bar_flusher();
+  void stop_bar_flusher();
 
-  void on_order_canceled(uint64_t order_id, int64_t canceled_volume) override;
+  void on_order_accepted(const GatewayEndpoint& from, uint64_t order_id,
+                         uint64_t recv_time);
 
-  void on_order_cancel_rejected(uint64_t order_id) override;
+  void on_order_rejected(const GatewayEndpoint& from, uint64_t order_id,
+                         uint64_t recv_time);
+
+  void on_order_traded(const GatewayEndpoint& from, uint64_t order_id,
+                       int64_t this_traded, double traded_price,
+                       uint64_t recv_time);
+
+  void on_order_canceled(const GatewayEndpoint& from, uint64_t order_id,
+                         int64_t canceled_volume, uint64_t recv_time);
+
+  void on_order_cancel_rejected(const GatewayEndpoint& from,
+                                uint64_t order_id, uint64_t recv_time);
+
+  // 网关回调的实际处理，调用方需要持有mutex_，单写者模式下只在事件循环
+  // 线程中调用
+  void handle_order_accepted(uint64_t order_id, uint64_t recv_time);
+
+  void handle_order_rejected(uint64_t order_id, uint64_t recv_time);
+
+  void handle_order_traded(uint64_t order_id, int64_t this_traded,
+                           double traded_price, uint64_t recv_time);
+
+  void handle_order_canceled(uint64_t order_id, int64_t canceled_volume,
+                             uint64_t recv_time);
+
+  void handle_order_cancel_rejected(uint64_t order_id, uint64_t recv_time);
 
  private:
   uint64_t next_order_id() { return next_order_id_++; }
 
-  std::unique_ptr<Gateway> gateway_ = nullptr;
+  /*
+   * 把订单回报发给下单的策略，调用方需要持有mutex_
+   */
+  void publish_order_event(const Order& order, uint32_t type,
+                           uint64_t recv_time, int64_t this_traded = 0,
+                           double traded_price = 0);
+
+  OrderEventRing* get_order_event_ring(uint32_t strategy_id);
+
+  /*
+   * 把暂存的订单回报按顺序写入策略的队列，直到写完或者队列再次满了，
+   * 调用方需要持有mutex_
+   */
+  void flush_event_backlog(uint32_t strategy_id, OrderEventRing* ring);
+
+  /*
+   * 单写者模式下网关回调只把回报放入队列，由事件循环线程处理
+   */
+  struct GatewayEvent {
+    uint32_t type;  // OrderEventType
+    uint64_t order_id;
+    int64_t volume;  // 本次成交或撤单的数量
+    double price;    // 本次成交的价格
+    uint64_t recv_time;
+  };
+
+  // 每个网关只有一个回调线程，每个账户一个队列即满足单生产者的条件
+  using GatewayEventRing = SpscRing<GatewayEvent, 4096>;
+
+  void push_gateway_event(const GatewayEndpoint& from,
+                          const GatewayEvent& event);
+
+  void process_gateway_event(const GatewayEvent& event);
+
+  /*
+   * 其他线程写入事件循环的无锁队列后调用，事件循环正在睡眠时唤醒它
+   */
+  void wakeup_loop();
+
+  /*
+   * 事件循环睡眠前调用，is_empty()返回false时放弃睡眠
+   */
+  template <class IsEmpty>
+  bool prepare_loop_sleep(IsEmpty&& is_empty);
+
+  void finish_loop_sleep();
+
+  /*
+   * 访问订单状态前加锁，单写者模式下返回未加锁的lock
+   */
+  std::unique_lock<std::mutex> lock_order_state();
+
+  // 定时器的精度和统计信息的输出间隔
+  static constexpr uint64_t kTimerTickMs = 10;
+  static constexpr uint64_t kStatsIntervalMs = 60000;
+  static constexpr uint64_t kEventBacklogCheckMs = 1000;
+
+  /*
+   * 下单链路上各阶段的延迟
+   * cmd_transport: 策略发出指令 -> 引擎取出指令
+   * risk_check: 引擎取出指令 -> 整批风控检查完成
+   * gateway_send: 开始发送 -> 网关的下单函数（如ReqOrderInsert）返回
+   * tick_to_order: 网关收到触发下单的行情 -> 网关的下单函数返回
+   * order_ack: 下单完成 -> 收到交易所的委托回报
+   * order_fill: 下单完成 -> 收到第一笔成交回报
+   */
+  enum LatencyStage {
+    CMD_TRANSPORT = 0,
+    RISK_CHECK,
+    GATEWAY_SEND,
+    TICK_TO_ORDER,
+    ORDER_ACK,
+    ORDER_FILL
+  };
+
+  static const std::vector<std::string> kLatencyStageNames;
+
+  EngineConfig config_;
+  EventLoop loop_;
+
+  // 交易指令的来源，只在事件循环线程中访问
+  std::unique_ptr<RedisSession> cmd_redis_;
+  ShmSegment<TraderCmdQueue> cmd_shm_;
+  Doorbell cmd_doorbell_;
+  int latency_dump_fd_ = -1;
+  std::vector<TraderCommand> cmd_batch_;
+  uint64_t num_cmds_ = 0;
+  // 开始处理交易指令的时间（now_ns），之前发出的指令都是过期的
+  uint64_t start_time_ = 0;
+
+  static constexpr uint32_t kNoRoute = UINT32_MAX;
+
+  struct TradingAccount {
+    std::string investor_id;
+    std::vector<std::string> exchanges;
+    std::unique_ptr<GatewayEndpoint> endpoint;
+    std::unique_ptr<Gateway> gateway;
+  };
+
+  // 登录完成后不再修改
+  std::vector<TradingAccount> accounts_;
+  std::vector<uint32_t> ticker_routes_;  // 以ticker_index为下标
+
   std::unique_ptr<RiskManagementInterface> risk_mgr_ = nullptr;
 
   PositionManager portfolio_;
-  std::map<uint64_t, Order> order_map_;
+  LatencyRecorder latency_{kLatencyStageNames};
+  OrderTable order_table_;
+  OpenOrderPublisher open_orders_;
+  std::vector<Order> batch_orders_;
   std::mutex mutex_;
 
+  std::atomic<bool> is_loop_sleeping_ = false;
+
+  // 进程内运行的策略，没有加载策略时为空
+  std::unique_ptr<StrategyHost> strategy_host_;
+
   uint64_t next_order_id_ = 1;
 
-  RedisSession tick_redis_;
-  RedisSession order_redis_;
+  std::unique_ptr<RedisSession> tick_redis_;
+  uint64_t tick_seq_ = 0;
+
+  // 只在行情回调线程中写入，多个账户的行情线程之间用md_mutex_互斥
+  std::mutex md_mutex_;
+  TickFilter tick_filter_;
+  TickAnalyzer tick_analyzer_;
+  std::unique_ptr<BarAggregator> bar_aggregator_;  // 没有配置bar时为空
+  uint64_t bar_seq_ = 0;
+  std::thread bar_flusher_;
+  std::mutex bar_flusher_mutex_;
+  std::condition_variable bar_flusher_cv_;
+  bool is_bar_flusher_running_ = false;  // 由bar_flusher_mutex_保护
+  ShmSegment<MarketDataBroadcast> md_shm_;
+  MarketDataBroadcast* md_ = nullptr;
+
+  // 订单回报，和订单状态一样在mutex_的保护下或者在事件循环线程中访问
+  std::unique_ptr<RedisSession> event_redis_;
+  uint64_t event_seq_ = 0;
+  std::vector<std::unique_ptr<ShmSegment<OrderEventRing>>> event_shm_;
+  // 策略的队列满时暂存的回报，以strategy_id为下标。成交和撤单不能丢，
+  // 否则策略的仓位和挂单会和引擎不一致
+  std::vector<std::deque<OrderEvent>> event_backlogs_;
+  uint64_t backlogged_events_ = 0;
 
   std::atomic<bool> is_logon_ = false;
 };
 
+/*
+ * 每个账户的网关持有一个自己的endpoint作为回调接口，回调时引擎可以知道
+ * 回报来自哪个账户。单写者模式下每个endpoint有一个自己的回报队列
+ */
+class TradingEngine::GatewayEndpoint : public TradingEngineInterface {
+ public:
+  GatewayEndpoint(TradingEngine* engine, uint32_t account_index,
+                  bool single_writer)
+      : engine_(engine), account_index_(account_index) {
+    if (single_writer) events_ = std::make_unique<GatewayEventRing>();
+  }
+
+  uint32_t account_index() const { return account_index_; }
+
+  GatewayEventRing* events() const { return events_.get(); }
+
+  void on_query_contract(const Contract* contract) override {
+    engine_->on_query_contract(contract);
+  }
+
+  void on_query_account(const Account* account) override {
+    engine_->on_query_account(account);
+  }
+
+  void on_query_position(const Position* position) override {
+    engine_->on_query_position(position);
+  }
+
+  void on_tick(const TickData* tick) override { engine_->on_tick(tick); }
+
+  void on_order_accepted(uint64_t order_id, uint64_t recv_time) override {
+    engine_->on_order_accepted(*this, order_id, recv_time);
+  }
+
+  void on_order_rejected(uint64_t order_id, uint64_t recv_time) override {
+    engine_->on_order_rejected(*this, order_id, recv_time);
+  }
+
+  void on_order_traded(uint64_t order_id, int64_t this_traded,
+                       double traded_price, uint64_t recv_time) override {
+    engine_->on_order_traded(*this, order_id, this_traded, traded_price,
+                             recv_time);
+  }
+
+  void on_order_canceled(uint64_t order_id, int64_t canceled_volume,
+                         uint64_t recv_time) override {
+    engine_->on_order_canceled(*this, order_id, canceled_volume, recv_time);
+  }
+
+  void on_order_cancel_rejected(uint64_t order_id,
+                                uint64_t recv_time) override {
+    engine_->on_order_cancel_rejected(*this, order_id, recv_time);
+  }
+
+ private:
+  TradingEngine* engine_;
+  uint32_t account_index_;
+  std::unique_ptr<GatewayEventRing> events_;
+};
+
 }  // namespace ft
 
 #endif  // FT_TRADINGSYSTEM_TRADINGENGINE_H_
@@ -3,8 +3,11 @@
 #include <spdlog/spdlog.h>
 
 #include <getopt.hpp>
+#include <sstream>
+#include <vector>
 
 #include "Core/ContractTable.h"
+#include "TradingSystem/BarAggregator.h"
 #include "TradingSystem/Config.h"
 #include "TradingSystem/TradingEngine.h"
 
@@ -14,12 +17,33 @@ int main() {
   std::string contracts_file =
       getarg("../config/contracts.csv", "--contracts-file");
   std::string strategy_file = getarg("", "--strategy");
+  std::string topology_file = getarg("", "--topology-config");
   std::string log_level = getarg("info", "--loglevel");
+  std::string md_transport = getarg("redis", "--md-transport");
+  std::string cmd_transport = getarg("redis", "--cmd-transport");
+  std::string pos_transport = getarg("redis", "--pos-transport");
+  bool redis_monitor = getarg(false, "--redis-monitor");
+  bool busy_poll = getarg(false, "--busy-poll");
+  uint64_t spin_count = getarg(100000UL, "--spin-count");
+  uint64_t cmd_max_age = getarg(1000UL, "--cmd-max-age-ms");
+  uint64_t account_refresh = getarg(0UL, "--account-refresh-sec");
+  uint64_t order_ack_timeout = getarg(5UL, "--order-ack-timeout-sec");
+  bool single_writer = getarg(false, "--single-writer");
+  uint32_t strategy_id = getarg(ft::kMaxStrategies, "--strategy-id");
+  bool risk_check = getarg(false, "--risk-check");
+  uint64_t velocity_period = getarg(1000UL, "--velocity-period-ms");
+  uint64_t velocity_orders = getarg(0UL, "--velocity-order-limit");
+  uint64_t velocity_volume = getarg(0UL, "--velocity-volume-limit");
+  bool tick_dedup = getarg(true, "--tick-dedup");
+  bool tick_conflate = getarg(false, "--tick-conflate");
+  std::string bar_specs = getarg("", "--bars");
+  std::string bar_sessions = getarg("", "--bar-sessions");
+  uint64_t bar_update = getarg(1000UL, "--bar-update-ms");
 
   spdlog::set_level(spdlog::level::from_str(log_level));
 
-  ft::LoginParams params;
-  if (!load_login_params(login_config_file, &params)) {
+  std::vector<ft::LoginParams> params_list;
+  if (!load_login_params_list(login_config_file, &params_list)) {
     spdlog::error("Invalid file of login config");
     exit(-1);
   }
@@ -29,8 +53,62 @@ int main() {
     exit(-1);
   }
 
-  ft::TradingEngine engine;
+  ft::EngineConfig config;
+  if (!load_thread_topology(topology_file, &config.topology)) {
+    spdlog::error("Invalid file of thread topology");
+    exit(-1);
+  }
+
+  config.md_transport = ft::string2transport(md_transport);
+  config.cmd_transport = ft::string2transport(cmd_transport);
+  config.pos_transport = ft::string2transport(pos_transport);
+  config.pos_redis_monitor = redis_monitor;
+  config.cmd_busy_poll = busy_poll;
+  config.cmd_spin_count = spin_count;
+  config.cmd_max_age_ms = cmd_max_age;
+  config.account_refresh_sec = account_refresh;
+  config.order_ack_timeout_sec = order_ack_timeout;
+  config.single_writer = single_writer;
+  config.inproc_strategy_id = strategy_id;
+  config.risk_check = risk_check;
+  config.velocity_period_ms = velocity_period;
+  config.velocity_order_limit = velocity_orders;
+  config.velocity_volume_limit = velocity_volume;
+  config.tick_dedup = tick_dedup;
+  config.tick_conflate = tick_conflate;
+  config.bar_specs = bar_specs;
+  if (!bar_sessions.empty()) config.bar_sessions = bar_sessions;
+  config.bar_update_ms = bar_update;
+
+  std::vector<ft::BarSpec> specs;
+  std::vector<ft::TradingSession> sessions;
+  if (!ft::BarAggregator::parse_specs(config.bar_specs, &specs)) {
+    spdlog::error("Invalid bar specs: {}", config.bar_specs);
+    exit(-1);
+  }
+  if (!specs.empty() &&
+      (!ft::BarAggregator::parse_sessions(config.bar_sessions, &sessions) ||
+       sessions.empty())) {
+    spdlog::error("Invalid trading sessions of bars: {}", config.bar_sessions);
+    exit(-1);
+  }
+
+  // 多个策略以逗号分隔
+  std::stringstream ss(strategy_file);
+  std::string file;
+  while (std::getline(ss, file, ','))
+    if (!file.empty()) config.inproc_strategies.emplace_back(file);
+
+  // 进程内策略的strategy_id不能和进程外的策略重复，必须显式指定
+  if (!config.inproc_strategies.empty() &&
+      strategy_id + config.inproc_strategies.size() > ft::kMaxStrategies) {
+    spdlog::error("--strategy-id is required with --strategy, range: [0, {})",
+                  ft::kMaxStrategies);
+    exit(-1);
+  }
+
+  ft::TradingEngine engine(config);
 
-  engine.login(params);
+  engine.login(params_list);
   engine.run();
 }